@@ -10,6 +10,7 @@
 #include "AudioCommon/DSoundStream.h"
 #include "AudioCommon/Mixer.h"
 #include "AudioCommon/NullSoundStream.h"
+#include "AudioCommon/OfflineSoundStream.h"
 #include "AudioCommon/OpenALStream.h"
 #include "AudioCommon/OpenSLESStream.h"
 #include "AudioCommon/PulseAudioStream.h"
@@ -60,6 +61,8 @@ namespace AudioCommon
 			soundStream = new PulseAudio(mixer);
 		else if (backend == BACKEND_OPENSLES && OpenSLESStream::isValid())
 			soundStream = new OpenSLESStream(mixer);
+		else if (backend == BACKEND_OFFLINE     && OfflineSound::isValid())
+			soundStream = new OfflineSound(mixer);
 
 		if (!soundStream && NullSound::isValid())
 		{
@@ -135,6 +138,8 @@ namespace AudioCommon
 			backends.push_back(BACKEND_OPENAL);
 		if (OpenSLESStream::isValid())
 			backends.push_back(BACKEND_OPENSLES);
+		if (OfflineSound::isValid())
+			backends.push_back(BACKEND_OFFLINE);
 		return backends;
 	}
 
@@ -7,6 +7,8 @@
 // * Copyright (c) 2004-2006 Milan Cutka
 // * based on mplayer HRTF plugin by ylai
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <functional>
@@ -14,8 +16,13 @@
 #include <vector>
 
 #include "AudioCommon/DPL2Decoder.h"
+#include "Common/Common.h"
 #include "Common/MathUtil.h"
 
+#if _M_X86
+#include <xmmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -31,13 +38,21 @@ static float l_fwr, r_fwr, lpr_fwr, lmr_fwr;
 static std::vector<float> fwrbuf_l, fwrbuf_r;
 static float adapt_l_gain, adapt_r_gain, adapt_lpr_gain, adapt_lmr_gain;
 static std::vector<float> lf, rf, lr, rr, cf, cr;
-static float LFE_buf[256];
-static unsigned int lfe_pos;
-static float *filter_coefs_lfe;
-static unsigned int len125;
 
-template<class T, class _ftype_t>
-static _ftype_t DotProduct(int count, const T *buf, const _ftype_t *coefficients)
+// The LFE channel is low passed with a long FIR filter, which is run over a
+// block of frames at a time once the matrix has decoded them.
+enum
+{
+	LFE_TAPS = 256,
+	BLOCK_FRAMES = 256,
+};
+// Rotated, so each output is the dot product with the LFE_TAPS inputs
+// ending at its own.
+GC_ALIGNED16(static float lfe_coefs[LFE_TAPS]);
+// The last LFE_TAPS - 1 inputs of the previous block, then this block's
+GC_ALIGNED16(static float lfe_history[LFE_TAPS - 1 + BLOCK_FRAMES]);
+
+static float DotProductScalar(const float *buf, const float *coefficients, int count)
 {
 	float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
 	for (; count >= 4; buf += 4, coefficients += 4, count -= 4)
@@ -54,29 +69,36 @@ static _ftype_t DotProduct(int count, const T *buf, const _ftype_t *coefficients
 	return sum0 + sum1 + sum2 + sum3;
 }
 
-template<class T>
-static T FIRFilter(const T *buf, int pos, int len, int count, const float *coefficients)
+// count must be a multiple of 16 and coefficients 16 byte aligned.
+static float DotProduct(const float *buf, const float *coefficients, int count)
 {
-	int count1, count2;
-
-	if (pos >= count)
+#if _M_X86
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps(), sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+	for (; count > 0; buf += 16, coefficients += 16, count -= 16)
 	{
-		pos -= count;
-		count1 = count; count2 = 0;
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(buf + 0), _mm_load_ps(coefficients + 0)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(buf + 4), _mm_load_ps(coefficients + 4)));
+		sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(buf + 8), _mm_load_ps(coefficients + 8)));
+		sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(buf + 12), _mm_load_ps(coefficients + 12)));
 	}
-	else
+	__m128 sum = _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+#else
+	return DotProductScalar(buf, coefficients, count);
+#endif
+}
+
+// Fills the LFE channel of num_frames decoded frames from lfe_history.
+static void LFEFilter(float *out, int num_frames, bool scalar)
+{
+	for (int i = 0; i < num_frames; i++)
 	{
-		count2 = pos;
-		count1 = count - pos;
-		pos = len - count1;
+		const float *window = &lfe_history[i];
+		out[i * 6 + 3] = scalar ? DotProductScalar(window, lfe_coefs, LFE_TAPS) : DotProduct(window, lfe_coefs, LFE_TAPS);
 	}
-
-	// high part of window
-	const T *ptr = &buf[pos];
-
-	float r1 = DotProduct(count1, ptr, coefficients); coefficients += count1;
-	float r2 = DotProduct(count2, buf, coefficients);
-	return T(r1 + r2);
+	memmove(lfe_history, &lfe_history[num_frames], (LFE_TAPS - 1) * sizeof(float));
 }
 
 /*
@@ -182,33 +204,23 @@ static void OnSeek()
 	std::fill(rr.begin(), rr.end(), 0.0f);
 	std::fill(cf.begin(), cf.end(), 0.0f);
 	std::fill(cr.begin(), cr.end(), 0.0f);
-	lfe_pos = 0;
-	memset(LFE_buf, 0, sizeof(LFE_buf));
+	memset(lfe_history, 0, sizeof(lfe_history));
 }
 
-static void Done()
+static void CalculateCoefficients125HzLowpass(int rate)
 {
-	OnSeek();
-
-	if (filter_coefs_lfe)
-	{
-		free(filter_coefs_lfe);
-	}
-
-	filter_coefs_lfe = nullptr;
-}
-
-static float* CalculateCoefficients125HzLowpass(int rate)
-{
-	len125 = 256;
+	unsigned int len = LFE_TAPS;
 	float f = 125.0f / (rate / 2);
-	float *coeffs = DesignFIR(&len125, &f, 0);
+	float *coeffs = DesignFIR(&len, &f, 0);
 	static const float M3_01DB = 0.7071067812f;
-	for (unsigned int i = 0; i < len125; i++)
+	// The filter used to run over a ring buffer starting at the newest input,
+	// so the first tap applies to it and the rest to the oldest onwards.
+	lfe_coefs[LFE_TAPS - 1] = coeffs[0] * M3_01DB;
+	for (unsigned int i = 1; i < LFE_TAPS; i++)
 	{
-		coeffs[i] *= M3_01DB;
+		lfe_coefs[i - 1] = coeffs[i] * M3_01DB;
 	}
-	return coeffs;
+	free(coeffs);
 }
 
 static float PassiveLock(float x)
@@ -304,18 +316,16 @@ static void MatrixDecode(const float *in, const int k, const int il,
 	_cf[k] += c_agc_cfk + c_agc_cfk;
 }
 
-void DPL2Decode(float *samples, int numsamples, float *out)
+static void Decode(float *samples, int numsamples, float *out, bool scalar_lfe)
 {
 	static const unsigned int FWRDURATION = 240; // FWR average duration (samples)
 	static const int cfg_delay = 0;
 	static const unsigned int fmt_freq = 48000;
 	static const unsigned int fmt_nchannels = 2; // input channels
 
-	int cur = 0;
-
 	if (olddelay != cfg_delay || oldfreq != fmt_freq)
 	{
-		Done();
+		OnSeek();
 		olddelay = cfg_delay;
 		oldfreq = fmt_freq;
 		dlbuflen = std::max(FWRDURATION, (fmt_freq * cfg_delay / 1000)); //+(len7000-1);
@@ -328,62 +338,97 @@ void DPL2Decode(float *samples, int numsamples, float *out)
 		rr.resize(dlbuflen);
 		cf.resize(dlbuflen);
 		cr.resize(dlbuflen);
-		filter_coefs_lfe = CalculateCoefficients125HzLowpass(fmt_freq);
-		lfe_pos = 0;
-		memset(LFE_buf, 0, sizeof(LFE_buf));
+		CalculateCoefficients125HzLowpass(fmt_freq);
+		memset(lfe_history, 0, sizeof(lfe_history));
 	}
 
 	float *in = samples; // Input audio data
-	float *end = in + numsamples * fmt_nchannels; // Loop end
 
-	while (in < end)
+	while (numsamples > 0)
 	{
-		const int k = cyc_pos;
-
-		const int fwr_pos = (k + FWRDURATION) % dlbuflen;
-		/* Update the full wave rectified total amplitude */
-		/* Input matrix decoder */
-		l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
-		r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
-		lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
-		lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
-
-		/* Matrix encoded 2 channel sources */
-		fwrbuf_l[k] = in[0];
-		fwrbuf_r[k] = in[1];
-		MatrixDecode(in, k, 0, 1, true, dlbuflen,
-			l_fwr, r_fwr,
-			lpr_fwr, lmr_fwr,
-			&adapt_l_gain, &adapt_r_gain,
-			&adapt_lpr_gain, &adapt_lmr_gain,
-			&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
-
-		out[cur + 0] = lf[k];
-		out[cur + 1] = rf[k];
-		out[cur + 2] = cf[k];
-		LFE_buf[lfe_pos] = (out[0] + out[1]) / 2;
-		out[cur + 3] = FIRFilter(LFE_buf, lfe_pos, len125, len125, filter_coefs_lfe);
-		lfe_pos++;
-		if (lfe_pos == len125)
-		{
-			lfe_pos = 0;
-		}
-		out[cur + 4] = lr[k];
-		out[cur + 5] = rr[k];
-		// Next sample...
-		in += 2;
-		cur += 6;
-		cyc_pos--;
-		if (cyc_pos < 0)
+		const int block = std::min<int>(numsamples, BLOCK_FRAMES);
+
+		for (int i = 0; i < block; i++)
 		{
-			cyc_pos += dlbuflen;
+			const int k = cyc_pos;
+
+			const int fwr_pos = (k + FWRDURATION) % dlbuflen;
+			/* Update the full wave rectified total amplitude */
+			/* Input matrix decoder */
+			l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
+			r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
+			lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
+			lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
+
+			/* Matrix encoded 2 channel sources */
+			fwrbuf_l[k] = in[0];
+			fwrbuf_r[k] = in[1];
+			MatrixDecode(in, k, 0, 1, true, dlbuflen,
+				l_fwr, r_fwr,
+				lpr_fwr, lmr_fwr,
+				&adapt_l_gain, &adapt_r_gain,
+				&adapt_lpr_gain, &adapt_lmr_gain,
+				&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
+
+			out[i * 6 + 0] = lf[k];
+			out[i * 6 + 1] = rf[k];
+			out[i * 6 + 2] = cf[k];
+			lfe_history[LFE_TAPS - 1 + i] = (lf[k] + rf[k]) / 2;
+			out[i * 6 + 4] = lr[k];
+			out[i * 6 + 5] = rr[k];
+			// Next sample...
+			in += fmt_nchannels;
+			cyc_pos--;
+			if (cyc_pos < 0)
+			{
+				cyc_pos += dlbuflen;
+			}
 		}
+
+		LFEFilter(out, block, scalar_lfe);
+		out += block * 6;
+		numsamples -= block;
 	}
 }
 
+void DPL2Decode(float *samples, int numsamples, float *out)
+{
+	Decode(samples, numsamples, out, false);
+}
+
 void DPL2Reset()
 {
 	olddelay = -1;
 	oldfreq = 0;
-	filter_coefs_lfe = nullptr;
-}
\ No newline at end of file
+}
+
+const float* DPL2GetLFETaps(int* num_taps)
+{
+	CalculateCoefficients125HzLowpass(48000);
+	*num_taps = LFE_TAPS;
+	return lfe_coefs;
+}
+
+double DPL2Benchmark(bool scalar, unsigned int seconds)
+{
+	static const int FRAMES = 2048;
+	std::vector<float> in(FRAMES * 2), out(FRAMES * 6);
+	double elapsed = 0;
+	u32 t = 0;
+
+	DPL2Reset();
+	for (unsigned int done = 0; done < seconds * 48000; done += FRAMES)
+	{
+		for (int i = 0; i < FRAMES; i++, t++)
+		{
+			in[i * 2] = (float)(0.5 * sin(2 * M_PI * 440 * t / 48000));
+			in[i * 2 + 1] = (float)(0.5 * sin(2 * M_PI * 60 * t / 48000));
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		Decode(&in[0], FRAMES, &out[0], scalar);
+		elapsed += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	DPL2Reset();
+	return elapsed;
+}
@@ -4,5 +4,13 @@
 
 #pragma once
 
+// Decodes numsamples stereo frames at 48 kHz into 5.1 (L, R, C, LFE, Ls, Rs).
 void DPL2Decode(float *samples, int numsamples, float *out);
-void DPL2Reset();
\ No newline at end of file
+void DPL2Reset();
+
+// The taps of the LFE low pass as applied, the first to the oldest of the
+// num_taps inputs ending at each frame. For UnitTests.
+const float* DPL2GetLFETaps(int* num_taps);
+
+// Decodes the given seconds of synthetic audio and returns the time it took.
+double DPL2Benchmark(bool scalar, unsigned int seconds);
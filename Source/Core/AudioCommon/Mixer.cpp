@@ -3,9 +3,12 @@
 // Refer to the license.txt file included.
 // Modified For Ishiiruka By Tino
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
-#include "Common/Atomic.h"
 #include "Common/CPUDetect.h"
 #include "Common/MathUtil.h"
 #include "Core/ConfigManager.h"
@@ -16,35 +19,207 @@
 // UGLINESS
 #include "Core/PowerPC/PowerPC.h"
 
-#if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
-#include <tmmintrin.h>
+#if _M_X86
+#include <emmintrin.h>
 #endif
 
-// Executed from sound stream thread
-unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
-{
-	unsigned int currentSample = 0;
-
-	// Cache access in non-volatile variable
-	// This is the only function changing the read value, so it's safe to
-	// cache it locally although it's written here.
-	// The writing pointer will be modified outside, but it will only increase,
-	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
-	u32 indexR = Common::AtomicLoad(m_indexR);
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
-	float numLeft = (float)(((indexW - indexR) & INDEX_MASK) / 2);
-	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG - 1)) / CONTROL_AVG;
+static void ComputePolyphaseTaps(std::vector<float>& taps)
+{
+	const double pi = 3.14159265358979323846;
+	// Of the input Nyquist frequency, leaving room for the window's transition band
+	const double cutoff = 0.9;
+
+	taps.resize(RESAMPLER_PHASES * RESAMPLER_TAPS * 2);
+	for (int phase = 0; phase < RESAMPLER_PHASES; phase++)
+	{
+		double coefs[RESAMPLER_TAPS];
+		double sum = 0;
+		for (int t = 0; t < RESAMPLER_TAPS; t++)
+		{
+			// Distance of the tap from the output position, in input frames
+			const double x = t - RESAMPLER_HISTORY - (double)phase / RESAMPLER_PHASES;
+			const double sinc = x == 0 ? 1.0 : sin(pi * cutoff * x) / (pi * cutoff * x);
+			const double w = (x + RESAMPLER_TAPS / 2) / RESAMPLER_TAPS;
+			const double blackman = 0.42 - 0.5 * cos(2 * pi * w) + 0.08 * cos(4 * pi * w);
+			coefs[t] = sinc * blackman;
+			sum += coefs[t];
+		}
+
+		float* out = &taps[phase * RESAMPLER_TAPS * 2];
+		for (int t = 0; t < RESAMPLER_TAPS; t++)
+			out[t * 2] = out[t * 2 + 1] = (float)(coefs[t] / sum);
+	}
+}
+
+// Converts big endian (left, right) frames to floats in output order.
+static void ConvertFrames(const short* src, float* dst, u32 num_frames)
+{
+	u32 i = 0;
+#if _M_X86
+	for (; i + 4 <= num_frames; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps(dst + i * 2, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)));
+		_mm_storeu_ps(dst + i * 2 + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)));
+	}
+#endif
+	for (; i < num_frames; i++)
+	{
+		dst[i * 2] = (float)(s16)Common::swap16(src[i * 2 + 1]);
+		dst[i * 2 + 1] = (float)(s16)Common::swap16(src[i * 2]);
+	}
+}
+
+static inline void Advance(u32& idx, u32& frac, u32& frac_rem, const ResampleStep& step)
+{
+	frac += step.ratio;
+	frac_rem += step.rem;
+	if (frac_rem >= step.den)
+	{
+		frac_rem -= step.den;
+		frac++;
+	}
+	idx += frac >> 16;
+	frac &= 0xffff;
+}
+
+// in[0] is the frame at the read position, with RESAMPLER_HISTORY frames
+// before it.
+static void ResampleLinear(float* out, const float* in, u32 num_frames, u32 frac, u32 frac_rem, const ResampleStep& step,
+                           float lvolume, float rvolume)
+{
+	u32 idx = 0;
+	u32 i = 0;
+#if _M_X86
+	const __m128 volume = _mm_set_ps(lvolume, rvolume, lvolume, rvolume);
+	const __m128 scale = _mm_set1_ps(1.0f / 65536);
+	for (; i + 2 <= num_frames; i += 2)
+	{
+		const float* a = in + idx * 2;
+		const float fa = (float)frac;
+		Advance(idx, frac, frac_rem, step);
+
+		const float* b = in + idx * 2;
+		const float fb = (float)frac;
+		Advance(idx, frac, frac_rem, step);
+
+		const __m128 x0 = _mm_loadh_pi(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)a)), (const __m64*)b);
+		const __m128 x1 = _mm_loadh_pi(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(a + 2))), (const __m64*)(b + 2));
+		const __m128 f = _mm_mul_ps(_mm_set_ps(fb, fb, fa, fa), scale);
+		const __m128 r = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), f));
+		_mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(r, volume)));
+	}
+#endif
+	for (; i < num_frames; i++)
+	{
+		const float* a = in + idx * 2;
+		const float f = frac * (1.0f / 65536);
+		out[i * 2] += (a[0] + (a[2] - a[0]) * f) * rvolume;
+		out[i * 2 + 1] += (a[1] + (a[3] - a[1]) * f) * lvolume;
+		Advance(idx, frac, frac_rem, step);
+	}
+}
+
+static void ResamplePolyphase(float* out, const float* in, u32 num_frames, u32 frac, u32 frac_rem, const ResampleStep& step,
+                              float lvolume, float rvolume, const float* taps)
+{
+	u32 idx = 0;
+#if _M_X86
+	const __m128 volume = _mm_set_ps(0, 0, lvolume, rvolume);
+#endif
+	for (u32 i = 0; i < num_frames; i++)
+	{
+		const float* s = in + ((int)idx - RESAMPLER_HISTORY) * 2;
+		const float* h = taps + (frac >> (16 - 8)) * RESAMPLER_TAPS * 2;
+		static_assert(RESAMPLER_PHASES == 1 << 8, "phase is the top 8 bits of frac");
+#if _M_X86
+		__m128 acc = _mm_mul_ps(_mm_loadu_ps(s), _mm_loadu_ps(h));
+		for (int t = 2; t < RESAMPLER_TAPS; t += 2)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + t * 2), _mm_loadu_ps(h + t * 2)));
+		acc = _mm_mul_ps(_mm_add_ps(acc, _mm_movehl_ps(acc, acc)), volume);
+		_mm_storel_pi((__m64*)(out + i * 2), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(out + i * 2)), acc));
+#else
+		float r = 0, l = 0;
+		for (int t = 0; t < RESAMPLER_TAPS; t++)
+		{
+			r += s[t * 2] * h[t * 2];
+			l += s[t * 2 + 1] * h[t * 2];
+		}
+		out[i * 2] += r * rvolume;
+		out[i * 2 + 1] += l * lvolume;
+#endif
+		Advance(idx, frac, frac_rem, step);
+	}
+}
+
+// Read position after n output frames, in 1/den of the last bit of 16.16
+static u64 StepPosition(u32 frac, u32 frac_rem, const ResampleStep& step, u64 n)
+{
+	return (u64)frac * step.den + frac_rem + n * ((u64)step.ratio * step.den + step.rem);
+}
+
+// Returns how many output frames can be rendered from the available input
+// frames without running past them.
+static u32 CountOutputFrames(u32 available, u32 lookahead, u32 frac, u32 frac_rem, const ResampleStep& step)
+{
+	if (available <= lookahead)
+		return 0;
+	const u64 limit = ((u64)(available - lookahead) << 16) * step.den;
+	const u64 start = StepPosition(frac, frac_rem, step, 0);
+	if (start >= limit)
+		return 0;
+	return (u32)std::min<u64>((limit - start - 1) / StepPosition(0, 0, step, 1) + 1, UINT32_MAX);
+}
+
+CMixer::CMixer(unsigned int BackendSampleRate)
+	: m_dma_mixer(this, 32000)
+	, m_streaming_mixer(this, 48000)
+	, m_sampleRate(BackendSampleRate)
+	, m_logAudio(0)
+	, m_throttle(false)
+	, m_offline(false)
+	, m_speed(0)
+{
+	ComputePolyphaseTaps(m_polyphase_taps);
+	INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized");
+}
+
+void CMixer::MixerFifo::ReadFrames(float* frames, u32 indexR, u32 num_frames)
+{
+	const u32 start = indexR & INDEX_MASK;
+	const u32 first = std::min(num_frames, (MAX_SAMPLES * 2 - start) / 2);
+	ConvertFrames(&m_buffer[start], frames, first);
+	ConvertFrames(&m_buffer[0], frames + first * 2, num_frames - first);
+}
+
+ResampleStep CMixer::MixerFifo::GetOfflineStep() const
+{
+	const u64 step = (u64)m_input_sample_rate << 16;
+	ResampleStep result;
+	result.ratio = (u32)(step / m_mixer->m_sampleRate);
+	result.rem = (u32)(step % m_mixer->m_sampleRate);
+	result.den = m_mixer->m_sampleRate;
+	if (result.ratio == 0)
+	{
+		result.ratio = 1;
+		result.rem = 0;
+	}
+	return result;
+}
+
+ResampleStep CMixer::MixerFifo::GetStep(u32 available, bool consider_framelimit)
+{
+	if (m_mixer->m_offline)
+		return GetOfflineStep();
+
+	m_numLeftI = ((float)available + m_numLeftI*(CONTROL_AVG - 1)) / CONTROL_AVG;
 	float offset = (m_numLeftI - LOW_WATERMARK) * CONTROL_FACTOR;
 	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
-	//render numleft sample pairs to samples[]
-	//advance indexR with sample position
-	//remember fractional offset
-
 	u32 framelimit = SConfig::GetInstance().m_Framelimit;
 	float aid_sample_rate = m_input_sample_rate + offset;
 	if (consider_framelimit && framelimit > 2)
@@ -52,61 +227,88 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 		aid_sample_rate = aid_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	const u32 ratio = (u32)(65536.0f * aid_sample_rate / (float)m_mixer->m_sampleRate);
+	ResampleStep result;
+	result.ratio = std::max<u32>((u32)(65536.0f * aid_sample_rate / (float)m_mixer->m_sampleRate), 1);
+	result.rem = 0;
+	result.den = 1;
+	return result;
+}
+
+u32 CMixer::MixerFifo::FramesReady()
+{
+	const u32 available = ((m_indexW.load(std::memory_order_acquire) - m_indexR.load(std::memory_order_relaxed)) & INDEX_MASK) / 2;
+	const u32 lookahead = SConfig::GetInstance().m_PolyphaseResampler ? RESAMPLER_TAPS / 2 : 1;
+	const ResampleStep step = GetOfflineStep();
+	return CountOutputFrames(available, lookahead, m_frac, m_frac_rem < step.den ? m_frac_rem : 0, step);
+}
+
+// Executed from sound stream thread
+unsigned int CMixer::MixerFifo::Mix(float* samples, unsigned int numSamples, bool consider_framelimit)
+{
+	// New samples are only appended behind indexW, so whatever is read here
+	// stays valid until m_indexR is stored at the end.
+	u32 indexR = m_indexR.load(std::memory_order_relaxed);
+	const u32 indexW = m_indexW.load(std::memory_order_acquire);
+	const u32 available = ((indexW - indexR) & INDEX_MASK) / 2;
 
-	s32 lvolume = m_LVolume;
-	s32 rvolume = m_RVolume;
+	const ResampleStep step = GetStep(available, consider_framelimit);
+	// Left from another rate, or from offline mode
+	if (m_frac_rem >= step.den)
+		m_frac_rem = 0;
 
-	// TODO: consider a higher-quality resampling algorithm.
-	for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2) {
-		u32 indexR2 = indexR + 2; //next sample
+	const float lvolume = m_LVolume.load(std::memory_order_relaxed) / 256.0f;
+	const float rvolume = m_RVolume.load(std::memory_order_relaxed) / 256.0f;
 
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
-		sampleL = (sampleL * lvolume) >> 8;
-		sampleL += samples[currentSample + 1];
-		MathUtil::Clamp(&sampleL, -32767, 32767);
-		samples[currentSample + 1] = sampleL;
+	const bool polyphase = SConfig::GetInstance().m_PolyphaseResampler;
+	// Input frames read after the one at the current position
+	const u32 lookahead = polyphase ? RESAMPLER_TAPS / 2 : 1;
 
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
-		sampleR = (sampleR * rvolume) >> 8;
-		sampleR += samples[currentSample];
-		MathUtil::Clamp(&sampleR, -32767, 32767);
-		samples[currentSample] = sampleR;
+	// Render as many frames as the buffered input allows in one pass.
+	const u32 frames = std::min<u32>(CountOutputFrames(available, lookahead, m_frac, m_frac_rem, step), numSamples);
 
-		m_frac += ratio;
-		indexR += 2 * (u16)(m_frac >> 16);
-		m_frac &= 0xffff;
+	if (frames > 0)
+	{
+		const u64 end_pos = StepPosition(m_frac, m_frac_rem, step, frames);
+		const u64 end = end_pos / step.den;
+		const u32 last = (u32)((StepPosition(m_frac, m_frac_rem, step, frames - 1) / step.den) >> 16);
+		// Fast forward can step over more input than there is.
+		const u32 consumed = (u32)std::min<u64>(end >> 16, available);
+		const u32 window = std::max(last + lookahead + 1, consumed);
+
+		m_window.resize((RESAMPLER_HISTORY + window) * 2);
+		memcpy(&m_window[0], m_history, sizeof(m_history));
+		ReadFrames(&m_window[RESAMPLER_HISTORY * 2], indexR, window);
+
+		const float* input = &m_window[RESAMPLER_HISTORY * 2];
+		if (polyphase)
+			ResamplePolyphase(samples, input, frames, m_frac, m_frac_rem, step, lvolume, rvolume, &m_mixer->m_polyphase_taps[0]);
+		else
+			ResampleLinear(samples, input, frames, m_frac, m_frac_rem, step, lvolume, rvolume);
+
+		memcpy(m_history, &m_window[consumed * 2], sizeof(m_history));
+		indexR += consumed * 2;
+		const bool stepped_all = consumed == (end >> 16);
+		m_frac = stepped_all ? (u32)(end & 0xffff) : 0;
+		m_frac_rem = stepped_all ? (u32)(end_pos % step.den) : 0;
 	}
 
 	// Padding
-	short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
-	s[0] = (s[0] * rvolume) >> 8;
-	s[1] = (s[1] * lvolume) >> 8;
-	for (; currentSample < numSamples * 2; currentSample += 2)
+	const float* last_frame = &m_history[(RESAMPLER_HISTORY - 1) * 2];
+	for (u32 i = frames; i < numSamples; i++)
 	{
-		int sampleR = s[0] + samples[currentSample];
-		MathUtil::Clamp(&sampleR, -32767, 32767);
-		samples[currentSample] = sampleR;
-		int sampleL = s[1] + samples[currentSample + 1];
-		MathUtil::Clamp(&sampleL, -32767, 32767);
-		samples[currentSample + 1] = sampleL;
+		samples[i * 2] += last_frame[0] * rvolume;
+		samples[i * 2 + 1] += last_frame[1] * lvolume;
 	}
 
-	// Flush cached variable
-	Common::AtomicStore(m_indexR, indexR);
+	// Hands the consumed space back to PushSamples.
+	m_indexR.store(indexR, std::memory_order_release);
 
 	return numSamples;
 }
 
 u32 CMixer::MixerFifo::AvailableSamples()
 {
-	return ((m_indexW - m_indexR) & INDEX_MASK) / 2;
+	return ((m_indexW.load(std::memory_order_acquire) - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK) / 2;
 }
 
 u32 CMixer::AvailableSamples()
@@ -114,23 +316,71 @@ u32 CMixer::AvailableSamples()
 	return std::max(m_dma_mixer.AvailableSamples(), m_streaming_mixer.AvailableSamples());
 }
 
+u32 CMixer::FramesReady()
+{
+	// Mixing past the end of a FIFO that is still being fed would pad it and
+	// delay the rest of its input, so only mix as far as the FIFO with the
+	// least input. Both are pushed in emulated time, but the DTK stream stops
+	// when time stretching is on: once the other FIFO has backed up past the
+	// low watermark, an empty FIFO no longer holds it back.
+	const u32 dma = m_dma_mixer.FramesReady();
+	const u32 streaming = m_streaming_mixer.FramesReady();
+	if (dma == 0 && m_streaming_mixer.AvailableSamples() >= LOW_WATERMARK)
+		return streaming;
+	if (streaming == 0 && m_dma_mixer.AvailableSamples() >= LOW_WATERMARK)
+		return dma;
+	return std::min(dma, streaming);
+}
+
+void CMixer::MixFifos(short* samples, unsigned int num_samples, bool consider_framelimit)
+{
+	m_accumulator.assign(num_samples * 2, 0.0f);
+	m_dma_mixer.Mix(&m_accumulator[0], num_samples, consider_framelimit);
+	m_streaming_mixer.Mix(&m_accumulator[0], num_samples, consider_framelimit);
+
+	const float* in = &m_accumulator[0];
+	u32 i = 0;
+#if _M_X86
+	const __m128 max = _mm_set1_ps(32767.0f);
+	const __m128 min = _mm_set1_ps(-32767.0f);
+	for (; i + 8 <= num_samples * 2; i += 8)
+	{
+		const __m128i lo = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), max), min));
+		const __m128i hi = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i + 4), max), min));
+		_mm_storeu_si128((__m128i*)(samples + i), _mm_packs_epi32(lo, hi));
+	}
+#endif
+	for (; i < num_samples * 2; i++)
+	{
+		float sample = in[i];
+		MathUtil::Clamp(&sample, -32767.0f, 32767.0f);
+		samples[i] = (short)lrintf(sample);
+	}
+}
+
 unsigned int CMixer::Mix(short* samples, unsigned int num_samples, bool consider_framelimit)
 {
 	if (!samples)
 		return 0;
 
-	std::lock_guard<std::mutex> lk(m_csMixing);
-
-	memset(samples, 0, num_samples * 2 * sizeof(short));
+	// Don't make the audio callback wait out a savestate; play silence.
+	// Offline rendering runs on the CPU thread, which is never inside
+	// PauseAndLock, and has to consume the frames FramesReady counted even
+	// while a pause or frame advance is stopping the CPU.
+	std::unique_lock<std::mutex> lk(m_csMixing, std::defer_lock);
+	if (m_offline)
+		lk.lock();
+	else
+		lk.try_lock();
 
-	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+	if (num_samples == 0 || (!m_offline && (!lk.owns_lock() || PowerPC::GetState() != PowerPC::CPU_RUNNING)))
 	{
 		// Silence
+		memset(samples, 0, num_samples * 2 * sizeof(short));
 		return num_samples;
 	}
 
-	m_dma_mixer.Mix(samples, num_samples, consider_framelimit);
-	m_streaming_mixer.Mix(samples, num_samples, consider_framelimit);
+	MixFifos(samples, num_samples, consider_framelimit);
 	if (m_logAudio)
 		g_wave_writer.AddStereoSamples(samples, num_samples);
 	return num_samples;
@@ -138,15 +388,14 @@ unsigned int CMixer::Mix(short* samples, unsigned int num_samples, bool consider
 
 void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_samples)
 {
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
+	// Only this thread writes m_indexW. m_indexR has to be reloaded in the
+	// audio throttling loop to not deadlock.
+	const u32 indexW = m_indexW.load(std::memory_order_relaxed);
 
-	if (m_mixer->m_throttle)
+	if (m_mixer->m_throttle && !m_mixer->m_offline)
 	{
 		// The auto throttle function. This loop will put a ceiling on the CPU MHz.
-		while (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+		while (num_samples * 2 + ((indexW - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK) >= MAX_SAMPLES * 2)
 		{
 			if (*PowerPC::GetStatePtr() != PowerPC::CPU_RUNNING || soundStream->IsMuted())
 				break;
@@ -160,7 +409,7 @@ void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_sampl
 
 	// Check if we have enough free space
 	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+	if (num_samples * 2 + ((indexW - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK) >= MAX_SAMPLES * 2)
 		return;
 
 	// AyuanX: Actual re-sampling work has been moved to sound thread
@@ -177,7 +426,8 @@ void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_sampl
 		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
 	}
 
-	Common::AtomicAdd(m_indexW, num_samples * 2);
+	// Publishes the samples to Mix.
+	m_indexW.store(indexW + num_samples * 2, std::memory_order_release);
 
 	return;
 }
@@ -214,6 +464,40 @@ void CMixer::MixerFifo::SetInputSampleRate(unsigned int rate)
 
 void CMixer::MixerFifo::SetVolume(unsigned int lvolume, unsigned int rvolume)
 {
-	m_LVolume = lvolume + (lvolume >> 7);
-	m_RVolume = rvolume + (rvolume >> 7);
+	m_LVolume.store(lvolume + (lvolume >> 7), std::memory_order_relaxed);
+	m_RVolume.store(rvolume + (rvolume >> 7), std::memory_order_relaxed);
+}
+
+CMixer::BenchmarkResult CMixer::Benchmark(bool polyphase, unsigned int blocks)
+{
+	const double pi = 3.14159265358979323846;
+	const bool old_polyphase = SConfig::GetInstance().m_PolyphaseResampler;
+	SConfig::GetInstance().m_PolyphaseResampler = polyphase;
+
+	CMixer mixer(48000);
+	std::vector<short> dma(320 * 2), streaming(480 * 2), out(480 * 2);
+	BenchmarkResult result = { blocks, 0.0 };
+	u32 t = 0;
+	for (unsigned int b = 0; b < blocks; b++)
+	{
+		for (u32 i = 0; i < 320; i++)
+		{
+			dma[i * 2] = dma[i * 2 + 1] = Common::swap16((u16)(s16)(8000 * sin(2 * pi * 440 * (t + i) / 32000)));
+		}
+		for (u32 i = 0; i < 480; i++)
+		{
+			streaming[i * 2] = streaming[i * 2 + 1] = Common::swap16((u16)(s16)(8000 * sin(2 * pi * 1000 * (t + i) / 48000)));
+		}
+		t += 480;
+
+		mixer.m_dma_mixer.PushSamples(&dma[0], 320);
+		mixer.m_streaming_mixer.PushSamples(&streaming[0], 480);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		mixer.MixFifos(&out[0], 480, false);
+		result.seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	SConfig::GetInstance().m_PolyphaseResampler = old_polyphase;
+	return result;
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 // Modified For Ishiiruka By Tino
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include "AudioCommon/WaveFile.h"
 #include "Common/StdMutex.h"
@@ -18,19 +20,27 @@
 #define CONTROL_FACTOR 0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG 32
 
+// Windowed sinc filter used by the polyphase resampler
+#define RESAMPLER_TAPS 8
+#define RESAMPLER_PHASES 256
+// Input frames before the current one read by the filter
+#define RESAMPLER_HISTORY (RESAMPLER_TAPS / 2 - 1)
+
+// Input frames stepped per output frame: ratio in 16.16 fixed point, plus
+// rem / den of its last bit, which 16.16 can't hold for rates like 32 kHz
+// to 48 kHz. Without the remainder such a ratio runs slow and long offline
+// renders drift against the input.
+struct ResampleStep
+{
+	u32 ratio;
+	u32 rem;
+	u32 den;
+};
+
 class CMixer {
 
 public:
-	CMixer(unsigned int BackendSampleRate)
-		: m_dma_mixer(this, 32000)
-		, m_streaming_mixer(this, 48000)
-		, m_sampleRate(BackendSampleRate)
-		, m_logAudio(0)
-		, m_throttle(false)
-		, m_speed(0)
-	{
-		INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized");
-	}
+	CMixer(unsigned int BackendSampleRate);
 
 	virtual ~CMixer() {}
 
@@ -48,6 +58,24 @@ public:
 
 	void SetThrottle(bool use) { m_throttle = use; }
 
+	// Offline rendering: the FIFOs are resampled at the input to output rate,
+	// stepped as an exact fraction of the two, without throttling or the speed and buffer fill
+	// corrections, so the output only depends on the samples pushed.
+	void SetOffline(bool offline) { m_offline = offline; }
+	bool IsOffline() const { return m_offline; }
+	// Frames Mix can render without padding any FIFO that is still being
+	// fed, in offline mode
+	u32 FramesReady();
+
+	struct BenchmarkResult
+	{
+		unsigned int blocks; // of 10 ms
+		double seconds;      // spent mixing
+	};
+	// Pushes synthetic 32 kHz DMA and 48 kHz streaming audio through a
+	// 48 kHz mixer, 10 ms at a time, and times the mixing.
+	static BenchmarkResult Benchmark(bool polyphase, unsigned int blocks);
+
 
 	virtual void StartLogAudio(const std::string& filename)
 	{
@@ -95,26 +123,47 @@ protected:
 			, m_RVolume(256)
 			, m_numLeftI(0.0f)
 			, m_frac(0)
+			, m_frac_rem(0)
 		{
 			memset(m_buffer, 0, sizeof(m_buffer));
+			memset(m_history, 0, sizeof(m_history));
 		}
 		void PushSamples(const short* samples, unsigned int num_samples);
-		unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
+		// Adds numSamples resampled frames to samples, which holds floats in
+		// output order (right, left).
+		unsigned int Mix(float* samples, unsigned int numSamples, bool consider_framelimit = true);
 		void SetInputSampleRate(unsigned int rate);
 		void SetVolume(unsigned int lvolume, unsigned int rvolume);
 		u32 AvailableSamples();
+		u32 FramesReady();
 	private:
+		ResampleStep GetOfflineStep() const;
+		ResampleStep GetStep(u32 available, bool consider_framelimit);
+		void ReadFrames(float* frames, u32 indexR, u32 num_frames);
+
 		CMixer *m_mixer;
 		unsigned m_input_sample_rate;
 		short m_buffer[MAX_SAMPLES * 2];
-		volatile u32 m_indexW;
-		volatile u32 m_indexR;
+		// Single producer ring: only PushSamples writes m_indexW and only Mix
+		// writes m_indexR. Each release store hands the samples (or the space)
+		// to the other side.
+		std::atomic<u32> m_indexW;
+		std::atomic<u32> m_indexR;
 		// Volume ranges from 0-256
-		volatile s32 m_LVolume;
-		volatile s32 m_RVolume;
+		std::atomic<s32> m_LVolume;
+		std::atomic<s32> m_RVolume;
 		float m_numLeftI;
 		u32 m_frac;
+		// In 1/den of the last bit of m_frac, see ResampleStep
+		u32 m_frac_rem;
+		// The last frames consumed, for the filter taps before m_indexR
+		float m_history[RESAMPLER_HISTORY * 2];
+		// The frames being resampled, converted to floats
+		std::vector<float> m_window;
 	};
+
+	void MixFifos(short* samples, unsigned int num_samples, bool consider_framelimit);
+
 	MixerFifo m_dma_mixer;
 	MixerFifo m_streaming_mixer;
 	unsigned int m_sampleRate;
@@ -124,8 +173,16 @@ protected:
 	bool m_logAudio;
 
 	bool m_throttle;
+	bool m_offline;
 
+	// Only keeps Mix out while the emulator is paused and locked; the FIFOs
+	// don't need it.
 	std::mutex m_csMixing;
 
 	volatile float m_speed; // Current rate of the emulation (1.0 = 100% speed)
-};
\ No newline at end of file
+
+	std::vector<float> m_accumulator;
+	// RESAMPLER_PHASES sets of RESAMPLER_TAPS coefficients, each stored twice
+	// to multiply both channels of a frame at once
+	std::vector<float> m_polyphase_taps;
+};
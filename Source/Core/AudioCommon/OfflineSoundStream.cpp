@@ -0,0 +1,73 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "AudioCommon/OfflineSoundStream.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+
+OfflineSound::OfflineSound(CMixer *mixer)
+	: SoundStream(mixer)
+	, m_raw(false)
+	, m_frames(0)
+{
+}
+
+bool OfflineSound::Start()
+{
+	m_enablesoundloop = false;
+
+	m_filename = SConfig::GetInstance().m_OfflineAudioFile;
+	if (m_filename.empty())
+		m_filename = File::GetUserPath(D_DUMPAUDIO_IDX) + "offline.wav";
+	File::CreateFullPath(m_filename);
+
+	std::string extension;
+	SplitPath(m_filename, nullptr, nullptr, &extension);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	m_raw = extension == ".raw";
+
+	if (m_raw ? !m_file.Open(m_filename, "wb") : !m_wave.Start(m_filename, m_mixer->GetSampleRate()))
+	{
+		ERROR_LOG(AUDIO, "Could not open %s for offline audio", m_filename.c_str());
+		return false;
+	}
+
+	m_mixer->SetOffline(true);
+	m_frames = 0;
+	m_start = std::chrono::high_resolution_clock::now();
+	NOTICE_LOG(AUDIO, "Rendering audio offline to %s", m_filename.c_str());
+	return true;
+}
+
+void OfflineSound::Update()
+{
+	u32 frames = m_mixer->FramesReady();
+	while (frames > 0)
+	{
+		const u32 count = m_mixer->Mix(m_buffer, std::min<u32>(frames, BLOCK_FRAMES), false);
+		if (m_raw)
+			m_file.WriteArray(m_buffer, count * 2);
+		else
+			m_wave.AddStereoSamples(m_buffer, count);
+		m_frames += count;
+		frames -= count;
+	}
+}
+
+void OfflineSound::Stop()
+{
+	if (m_raw)
+		m_file.Close();
+	else
+		m_wave.Stop();
+
+	// How much faster than real time the game's audio was produced, which is
+	// the emulation speed with the DSP as the only clock.
+	const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_start).count();
+	const double audio_seconds = (double)m_frames / m_mixer->GetSampleRate();
+	NOTICE_LOG(AUDIO, "Rendered %.2f s of audio to %s in %.2f s (%.2fx)",
+		audio_seconds, m_filename.c_str(), seconds, seconds > 0 ? audio_seconds / seconds : 0.0);
+}
@@ -0,0 +1,42 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Renders the audio on the emulation thread as the game sends it, as fast as
+// the emulation runs, into a WAV or raw file. Each audio DMA block is mixed as
+// soon as the DTK stream has caught up with it, at a fixed resampling ratio,
+// so the file only depends on what the game played and can be compared bit
+// for bit between builds.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "AudioCommon/SoundStream.h"
+#include "AudioCommon/WaveFile.h"
+#include "Common/FileUtil.h"
+
+class OfflineSound final : public SoundStream
+{
+public:
+	OfflineSound(CMixer *mixer);
+	virtual ~OfflineSound() {}
+
+	virtual bool Start() override;
+	virtual void Stop() override;
+	// Called after every audio DMA block
+	virtual void Update() override;
+	static bool isValid() { return true; }
+
+private:
+	enum { BLOCK_FRAMES = 1024 };
+
+	std::string m_filename;
+	bool m_raw;
+	WaveFileWriter m_wave;
+	File::IOFile m_file;
+	u64 m_frames;
+	std::chrono::high_resolution_clock::time_point m_start;
+	short m_buffer[BLOCK_FRAMES * 2];
+};
@@ -14,6 +14,7 @@
 // - Serialization code for anything complex has to be manually written.
 
 #include <cstddef>
+#include <cstring>
 #include <deque>
 #include <list>
 #include <map>
@@ -59,16 +60,51 @@ public:
 		MODE_VERIFY, // compare
 	};
 
+	// A stretch of the stream between two markers, named after the marker
+	// that closes it. Offsets are relative to where SetSectionTable was called.
+	struct Section
+	{
+		std::string name;
+		u32 offset;
+		u32 size;
+	};
+
 	u8 **ptr;
 	Mode mode;
 
 public:
-	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
+	typedef void (*CopyFunc)(void* dest, const void* src, size_t size);
+
+	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_),
+		m_sections(nullptr), m_section_base(nullptr), m_section_start(0), m_section_alignment(1),
+		m_bulk_copy(nullptr), m_bulk_copy_min(0) {}
 
 	void SetMode(Mode mode_) { mode = mode_; }
 	Mode GetMode() const { return mode; }
 	u8** GetPPtr() { return ptr; }
 
+	// Records every marker from here on into table. Each new section is
+	// padded to start on an alignment boundary, so large arrays that follow
+	// a marker can be read or mapped in place. The padding is part of the
+	// stream, so the same table must be attached in every mode.
+	void SetSectionTable(std::vector<Section>* table, u32 alignment = 1)
+	{
+		m_sections = table;
+		m_section_base = *ptr;
+		m_section_start = 0;
+		m_section_alignment = alignment;
+		if (m_sections)
+			m_sections->clear();
+	}
+
+	// Reads and writes of min_size bytes or more go through func instead of
+	// memcpy, so the caller can spread the big memory arrays over threads.
+	void SetBulkCopy(CopyFunc func, u32 min_size)
+	{
+		m_bulk_copy = func;
+		m_bulk_copy_min = min_size;
+	}
+
 	template <typename K, class V>
 	void Do(std::map<K, V>& x)
 	{
@@ -141,7 +177,8 @@ public:
 	template <typename T>
 	void Do(std::vector<T>& x)
 	{
-		DoContainer(x);
+		// std::vector<bool> packs its bits, so it has no array to copy
+		DoVector(x, std::integral_constant<bool, IsPlainNumber<T>::value && !std::is_same<T, bool>::value>());
 	}
 
 	template <typename T>
@@ -172,8 +209,9 @@ public:
 	template <typename T>
 	void DoArray(T* x, u32 count)
 	{
-		for (u32 i = 0; i != count; ++i)
-			Do(x[i]);
+		// Arrays of plain numbers are serialized byte for byte either way,
+		// so copy them in one go instead of element by element.
+		DoArray(x, count, std::integral_constant<bool, IsPlainNumber<T>::value>());
 	}
 
 	template <typename T>
@@ -285,9 +323,70 @@ public:
 				prevName.c_str(), cookie, cookie, arbitraryNumber, arbitraryNumber);
 			mode = PointerWrap::MODE_MEASURE;
 		}
+
+		if (m_sections)
+		{
+			const u32 end = (u32)(*ptr - m_section_base);
+			Section section = { prevName, m_section_start, end - m_section_start };
+			m_sections->push_back(section);
+
+			const u32 padding = (m_section_alignment - end % m_section_alignment) % m_section_alignment;
+			if (mode == MODE_WRITE)
+				memset(*ptr, 0, padding);
+			*ptr += padding;
+			m_section_start = end + padding;
+		}
 	}
 
 private:
+	std::vector<Section>* m_sections;
+	u8* m_section_base;
+	u32 m_section_start;
+	u32 m_section_alignment;
+	CopyFunc m_bulk_copy;
+	u32 m_bulk_copy_min;
+
+	template <typename T>
+	struct IsPlainNumber : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> {};
+
+	template <typename T>
+	void DoVector(std::vector<T>& x, std::true_type)
+	{
+		u32 size = (u32)x.size();
+		Do(size);
+		x.resize(size);
+
+		if (size != 0)
+			DoArray(x.data(), size);
+	}
+
+	template <typename T>
+	void DoVector(std::vector<T>& x, std::false_type)
+	{
+		DoContainer(x);
+	}
+
+	void Copy(void* dest, const void* src, u32 size)
+	{
+		if (m_bulk_copy && size >= m_bulk_copy_min)
+			m_bulk_copy(dest, src, size);
+		else
+			memcpy(dest, src, size);
+	}
+
+	template <typename T>
+	void DoArray(T* x, u32 count, std::true_type)
+	{
+		DoVoid(x, count * sizeof(T));
+	}
+
+	template <typename T>
+	void DoArray(T* x, u32 count, std::false_type)
+	{
+		for (u32 i = 0; i != count; ++i)
+			Do(x[i]);
+	}
+
 	__forceinline void DoByte(u8& x)
 	{
 		switch (mode)
@@ -318,8 +417,30 @@ private:
 
 	void DoVoid(void *data, u32 size)
 	{
-		for (u32 i = 0; i != size; ++i)
-			DoByte(reinterpret_cast<u8*>(data)[i]);
+		switch (mode)
+		{
+		case MODE_READ:
+			Copy(data, *ptr, size);
+			break;
+
+		case MODE_WRITE:
+			Copy(*ptr, data, size);
+			break;
+
+		case MODE_MEASURE:
+			break;
+
+		case MODE_VERIFY:
+			// Go byte by byte so a mismatch reports where it happened.
+			for (u32 i = 0; i != size; ++i)
+				DoByte(reinterpret_cast<u8*>(data)[i]);
+			return;
+
+		default:
+			break;
+		}
+
+		*ptr += size;
 	}
 };
 
@@ -29,6 +29,7 @@
 #include <libgen.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -410,6 +411,21 @@ u64 GetSize(const std::string &filename)
 	return 0;
 }
 
+bool GetSizeAndModifiedTime(const std::string &filename, u64 &size, u64 &mtime)
+{
+	struct stat64 buf;
+#ifdef _WIN32
+	if (_tstat64(UTF8ToTStr(filename).c_str(), &buf) != 0 || S_ISDIR(buf.st_mode))
+#else
+	if (stat64(filename.c_str(), &buf) != 0 || S_ISDIR(buf.st_mode))
+#endif
+		return false;
+
+	size = buf.st_size;
+	mtime = buf.st_mtime;
+	return true;
+}
+
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd)
 {
@@ -1065,6 +1081,23 @@ bool IOFile::Flush()
 	return m_good;
 }
 
+bool IOFile::Sync()
+{
+	if (!Flush())
+		return false;
+
+	if (0 !=
+#ifdef _WIN32
+		_commit(_fileno(m_file))
+#else
+		fsync(fileno(m_file))
+#endif
+		)
+		m_good = false;
+
+	return m_good;
+}
+
 bool IOFile::Resize(u64 size)
 {
 	if (!IsOpen() || 0 !=
@@ -1082,4 +1115,110 @@ bool IOFile::Resize(u64 size)
 	return m_good;
 }
 
+MappedFile::MappedFile()
+	: m_data(nullptr), m_size(0)
+#ifdef _WIN32
+	, m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFile(UTF8ToTStr(filename).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+	                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_mapping = CreateFileMapping(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!m_mapping)
+		return false;
+
+	m_data = (u8*)MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!m_data)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+		return false;
+	}
+	m_size = size.QuadPart;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat64 file_info;
+	if (fstat64(fd, &file_info) != 0 || file_info.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (u8*)data;
+	m_size = file_info.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!m_data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	m_mapping = nullptr;
+#else
+	munmap(m_data, m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+void MappedFile::AdviseSequential()
+{
+#ifndef _WIN32
+	if (m_data)
+		madvise(m_data, m_size, MADV_SEQUENTIAL);
+#endif
+}
+
+void MappedFile::AdviseWillNeed(u64 offset, u64 length)
+{
+#ifndef _WIN32
+	if (!m_data || offset >= m_size)
+		return;
+
+	// madvise wants a page-aligned start.
+	const u64 page_mask = (u64)sysconf(_SC_PAGESIZE) - 1;
+	const u64 start = offset & ~page_mask;
+	length = std::min(length + (offset - start), m_size - start);
+	madvise(m_data + start, length, MADV_WILLNEED);
+#endif
+}
+
 } // namespace
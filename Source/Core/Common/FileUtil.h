@@ -79,6 +79,9 @@ u64 GetSize(const std::string &filename);
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd);
 
+// Gets the size and last modification time of filename with a single stat
+bool GetSizeAndModifiedTime(const std::string &filename, u64 &size, u64 &mtime);
+
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE *f);
 
@@ -216,6 +219,8 @@ public:
 	u64 GetSize();
 	bool Resize(u64 size);
 	bool Flush();
+	// Flush, then wait until the OS has written the file to the disk
+	bool Sync();
 
 	// clear error state
 	void Clear() { m_good = true; std::clearerr(m_file); }
@@ -227,6 +232,33 @@ private:
 	IOFile& operator=(IOFile& other);
 };
 
+// Read-only, copy-on-write memory mapping of a whole file. Reads through the
+// mapping come straight from the page cache, without a syscall per access.
+class MappedFile : public NonCopyable
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const u8* GetData() const { return m_data; }
+	u64 GetSize() const { return m_size; }
+
+	// Access pattern hints for the OS. They are only hints and may be no-ops.
+	void AdviseSequential();
+	void AdviseWillNeed(u64 offset, u64 length);
+
+private:
+	u8* m_data;
+	u64 m_size;
+#ifdef _WIN32
+	void* m_mapping;
+#endif
+};
+
 }  // namespace
 
 // To deal with Windows being dumb at unicode:
@@ -4,26 +4,47 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
-#include <fstream>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "Common.h"
 #include "FileUtil.h"
+#include "Hash.h"
 
 // On disk format:
 //header{
-// u32 'DCAC';
-// u32 version;  // svn_rev
+// u32 'DCIX';
 // u16 sizeof(key_type);
 // u16 sizeof(value_type);
+// char version[40]; // scm_rev_cache_str
+// u32 num_indexed;
+// u32 pad;
+// u64 journal_offset;
 //}
-
-//key_value_pair{
+//
+//index_entry[num_indexed]{ // sorted by the key's bytes
+// key_type key;
 // u32 value_size;
-// key_type   key;
-// value_type[value_size]   value;
+// u32 checksum;
+// u64 offset;       // of the value, from the start of the file
 //}
+//
+// value_type[value_size] values[num_indexed]; // each padded to 8 bytes
+//
+// From journal_offset to the end of the file, entries appended since the
+// index was last written:
+//journal_entry{
+// u32 value_size;
+// u32 checksum;
+// key_type key;
+// value_type[value_size] value; // padded to 8 bytes
+//}
+//
+// The checksum covers the key and the value. Entries whose checksum doesn't
+// match are treated as missing.
 
 template <typename K, typename V>
 class LinearDiskCacheReader
@@ -32,14 +53,18 @@ public:
 	virtual void Read(const K &key, const V *value, u32 value_size) = 0;
 };
 
-// Dead simple unsorted key-value store with append functionality.
-// No random read functionality, all reading is done in OpenAndRead.
+// Key-value store with append functionality, read through a memory mapping.
+// Opening a file only reads its index; values are paged in when looked up,
+// so a cache of thousands of shaders costs nothing until they are used.
+// Appended entries go to a journal at the end of the file, which is merged
+// into the sorted index (dropping stale and corrupt entries) on Close once
+// it grows large.
 // Keys and values can contain any characters, including \0.
 //
 // Suitable for caching generated shader bytecode between executions.
-// Not tuned for extreme performance but should be reasonably fast.
 // Does not support keys or values larger than 2GB, which should be reasonable.
 // Keys must have non-zero length; values can have zero length.
+// Not thread safe.
 
 // K and V are some POD type
 // K : the key type
@@ -48,141 +73,451 @@ template <typename K, typename V>
 class LinearDiskCache
 {
 public:
-	// return number of read entries
-	u32 OpenAndRead(const std::string& filename, LinearDiskCacheReader<K, V> &reader)
+	LinearDiskCache()
+		: m_index(nullptr)
+		, m_num_indexed(0)
+		, m_needs_compaction(false)
 	{
-		using std::ios_base;
+	}
 
-		// close any currently opened file
+	~LinearDiskCache()
+	{
 		Close();
-		m_num_entries = 0;
+	}
 
-		// try opening for reading/writing
-		OpenFStream(m_file, filename, ios_base::in | ios_base::out | ios_base::binary);
+	// Opens (or creates) the cache without reading any values.
+	// return number of entries
+	u32 Open(const std::string& filename)
+	{
+		Close();
+		m_filename = filename;
 
-		m_file.seekg(0, std::ios::end);
-		std::fstream::pos_type end_pos = m_file.tellg();
-		m_file.seekg(0, std::ios::beg);
-		std::fstream::pos_type start_pos = m_file.tellg();
-		std::streamoff file_size = end_pos - start_pos;
+		bool mapped = Map();
+		if (mapped && m_needs_compaction)
+		{
+			Compact();
+			mapped = Map();
+		}
 
-		if (m_file.is_open() && ValidateHeader())
+		// failed to open file for reading or bad header
+		// recreate file
+		if (!mapped && (!CreateEmpty(filename) || !Map()))
 		{
-			// good header, read some key/value pairs
-			K key;
+			ERROR_LOG(COMMON, "Failed to create disk cache %s", filename.c_str());
+			Close();
+			return 0;
+		}
 
-			V *value = nullptr;
-			u32 value_size;
-			u32 entry_number;
+		m_file.Open(filename, "r+b");
+		m_file.Seek(0, SEEK_END);
+		return GetNumEntries();
+	}
 
-			std::fstream::pos_type last_pos = m_file.tellg();
+	// Passes every entry to the reader.
+	// return number of read entries
+	u32 ForEach(LinearDiskCacheReader<K, V> &reader)
+	{
+		u32 num_read = 0;
+		for (u32 i = 0; i < m_num_indexed; i++)
+		{
+			const IndexEntry& entry = m_index[i];
+			if (m_journal.count(entry.key))
+				continue;
 
-			while (Read(&value_size))
+			const V* value = GetIndexedValue(entry);
+			if (value)
 			{
-				std::streamoff next_extent = (last_pos - start_pos) + sizeof(value_size) + value_size;
-				if (next_extent > file_size)
-					break;
-
-				delete[] value;
-				value = new V[value_size];
-
-				// read key/value and pass to reader
-				if (Read(&key) &&
-					Read(value, value_size) &&
-					Read(&entry_number) &&
-					entry_number == m_num_entries+1)
-				{
-					reader.Read(key, value, value_size);
-				}
-				else
-				{
-					break;
-				}
-
-				m_num_entries++;
-				last_pos = m_file.tellg();
+				reader.Read(entry.key, value, entry.value_size);
+				num_read++;
 			}
-			m_file.seekp(last_pos);
-			m_file.clear();
+		}
 
-			delete[] value;
-			return m_num_entries;
+		for (auto it = m_journal.begin(); it != m_journal.end(); )
+		{
+			const K key = it->first;
+			const V* value = GetJournalValue(it++);
+			if (value)
+			{
+				reader.Read(key, value, m_journal[key].value_size);
+				num_read++;
+			}
 		}
+		return num_read;
+	}
 
-		// failed to open file for reading or bad header
-		// close and recreate file
-		Close();
-		m_file.open(filename, ios_base::out | ios_base::trunc | ios_base::binary);
-		WriteHeader();
-		return 0;
+	// Reads everything up front, like callers of the old unindexed cache did.
+	// return number of read entries
+	u32 OpenAndRead(const std::string& filename, LinearDiskCacheReader<K, V> &reader)
+	{
+		Open(filename);
+		return ForEach(reader);
+	}
+
+	// Returns the value stored for the key, or nullptr if there is none or it
+	// is corrupt. The pointer stays valid until Close or until the key is
+	// appended again.
+	const V* Lookup(const K &key, u32* value_size)
+	{
+		auto it = m_journal.find(key);
+		if (it != m_journal.end())
+		{
+			*value_size = it->second.value_size;
+			return GetJournalValue(it);
+		}
+
+		const IndexEntry* entry = FindIndexed(key);
+		if (!entry)
+			return nullptr;
+
+		*value_size = entry->value_size;
+		return GetIndexedValue(*entry);
+	}
+
+	u32 GetNumEntries() const
+	{
+		u32 num_entries = (u32)m_journal.size();
+		for (u32 i = 0; i < m_num_indexed; i++)
+		{
+			if (!m_journal.count(m_index[i].key))
+				num_entries++;
+		}
+		return num_entries;
 	}
 
 	void Sync()
 	{
-		m_file.flush();
+		m_file.Flush();
 	}
 
 	void Close()
 	{
-		if (m_file.is_open())
-			m_file.close();
-		// clear any error flags
-		m_file.clear();
+		m_file.Close();
+		if (m_mapping.IsOpen() && (m_needs_compaction || m_journal.size() > std::max<size_t>(64, m_num_indexed / 8)))
+			Compact();
+
+		m_mapping.Close();
+		m_index = nullptr;
+		m_num_indexed = 0;
+		m_journal.clear();
+		m_needs_compaction = false;
 	}
 
 	// Appends a key-value pair to the store.
 	void Append(const K &key, const V *value, u32 value_size)
 	{
-		// TODO: Should do a check that we don't already have "key"? (I think each caller does that already.)
-		Write(&value_size);
-		Write(&key);
-		Write(value, value_size);
-		m_num_entries++;
-		Write(&m_num_entries);
+		if (!m_mapping.IsOpen())
+			return;
+
+		// The old value is left behind in the file until the next compaction.
+		if (m_journal.count(key) || FindIndexed(key))
+			m_needs_compaction = true;
+
+		JournalEntry& entry = m_journal[key];
+		entry.value_size = value_size;
+		entry.checksum = Checksum(key, value, value_size);
+		entry.offset = 0;
+		entry.value.assign(value, value + value_size);
+		entry.verified = true;
+
+		const u32 header[2] = { entry.value_size, entry.checksum };
+		m_file.WriteBytes(header, sizeof(header));
+		m_file.WriteBytes(&key, sizeof(K));
+		m_file.WriteBytes(value, value_size * sizeof(V));
+		WritePadding(m_file, sizeof(header) + sizeof(K) + value_size * sizeof(V));
 	}
 
 private:
-	void WriteHeader()
+	struct Header
 	{
-		Write(&m_header);
+		Header()
+			: id(*(u32*)"DCIX")
+			, key_t_size(sizeof(K))
+			, value_t_size(sizeof(V))
+			, num_indexed(0)
+			, pad(0)
+			, journal_offset(sizeof(Header))
+		{
+			memcpy(ver, scm_rev_cache_str, 40);
+		}
+
+		bool IsCompatible(const Header& other) const
+		{
+			return id == other.id && key_t_size == other.key_t_size &&
+			       value_t_size == other.value_t_size && !memcmp(ver, other.ver, sizeof(ver));
+		}
+
+		u32 id;
+		u16 key_t_size, value_t_size;
+		char ver[40];
+		u32 num_indexed;
+		u32 pad;
+		u64 journal_offset;
+	};
+
+	struct IndexEntry
+	{
+		K key;
+		u32 value_size;
+		u32 checksum;
+		u64 offset;
+	};
+
+	struct JournalEntry
+	{
+		JournalEntry() : value_size(0), checksum(0), offset(0), verified(false) {}
+
+		u32 value_size;
+		u32 checksum;
+		u64 offset;          // of the value in the mapping, or 0 if appended this session
+		std::vector<V> value; // only for appended entries
+		bool verified;
+	};
+
+	struct KeyLess
+	{
+		bool operator()(const K& a, const K& b) const
+		{
+			return memcmp(&a, &b, sizeof(K)) < 0;
+		}
+	};
+
+	typedef std::map<K, JournalEntry, KeyLess> Journal;
+
+	static const u32 ALIGNMENT = 8;
+
+	static u64 Align(u64 offset)
+	{
+		return (offset + ALIGNMENT - 1) & ~(u64)(ALIGNMENT - 1);
 	}
 
-	bool ValidateHeader()
+	static void WritePadding(File::IOFile& file, u64 written)
 	{
-		char file_header[sizeof(Header)];
+		static const u8 zeros[ALIGNMENT] = {};
+		file.WriteBytes(zeros, (size_t)(Align(written) - written));
+	}
 
-		return (Read(file_header, sizeof(Header)) &&
-		        !memcmp((const char*)&m_header, file_header, sizeof(Header)));
+	static u32 Checksum(const K& key, const V* value, u32 value_size)
+	{
+		return HashAdler32((const u8*)&key, sizeof(K)) * 31 +
+		       HashAdler32((const u8*)value, value_size * sizeof(V));
 	}
 
-	template <typename D>
-	bool Write(const D *data, u32 count = 1)
+	// Maps the file and reads its index and journal. Fails if the file is
+	// missing or was written by another version.
+	bool Map()
 	{
-		return m_file.write((const char*)data, count * sizeof(D)).good();
+		m_mapping.Close();
+		m_index = nullptr;
+		m_num_indexed = 0;
+		m_journal.clear();
+		m_needs_compaction = false;
+
+		if (!m_mapping.Open(m_filename) || m_mapping.GetSize() < sizeof(Header))
+			return false;
+
+		const u8* data = m_mapping.GetData();
+		const u64 size = m_mapping.GetSize();
+		Header header;
+		memcpy(&header, data, sizeof(Header));
+		if (!Header().IsCompatible(header) ||
+		    header.journal_offset > size ||
+		    sizeof(Header) + (u64)header.num_indexed * sizeof(IndexEntry) > header.journal_offset)
+		{
+			m_mapping.Close();
+			return false;
+		}
+
+		m_index = (const IndexEntry*)(data + sizeof(Header));
+		m_num_indexed = header.num_indexed;
+		for (u32 i = 0; i < m_num_indexed; i++)
+		{
+			if (m_index[i].offset + (u64)m_index[i].value_size * sizeof(V) > header.journal_offset)
+			{
+				m_mapping.Close();
+				return false;
+			}
+		}
+
+		// Only the journal's framing is read here; values are checked on lookup.
+		u64 pos = header.journal_offset;
+		while (pos < size)
+		{
+			u32 entry_header[2];
+			if (pos + sizeof(entry_header) + sizeof(K) > size)
+				break;
+			memcpy(entry_header, data + pos, sizeof(entry_header));
+			const u64 value_offset = pos + sizeof(entry_header) + sizeof(K);
+			const u64 end = value_offset + (u64)entry_header[0] * sizeof(V);
+			if (end > size)
+				break;
+
+			K key;
+			memcpy(&key, data + pos + sizeof(entry_header), sizeof(K));
+			JournalEntry& entry = m_journal[key];
+			if (entry.offset)
+				m_needs_compaction = true;
+			entry.value_size = entry_header[0];
+			entry.checksum = entry_header[1];
+			entry.offset = value_offset;
+			entry.verified = false;
+
+			pos = Align(end);
+		}
+
+		// A truncated last entry would make everything appended after it
+		// unreadable, so rewrite the file without it.
+		if (pos != size)
+		{
+			WARN_LOG(COMMON, "Disk cache %s has a truncated entry", m_filename.c_str());
+			m_needs_compaction = true;
+		}
+
+		return true;
 	}
 
-	template <typename D>
-	bool Read(const D *data, u32 count = 1)
+	const IndexEntry* FindIndexed(const K& key) const
 	{
-		return m_file.read((char*)data, count * sizeof(D)).good();
+		const IndexEntry* first = m_index;
+		const IndexEntry* last = m_index + m_num_indexed;
+		const IndexEntry* entry = std::lower_bound(first, last, key,
+			[](const IndexEntry& e, const K& k) { return KeyLess()(e.key, k); });
+		if (entry == last || memcmp(&entry->key, &key, sizeof(K)) != 0)
+			return nullptr;
+		return entry;
 	}
 
-	struct Header
+	const V* GetIndexedValue(const IndexEntry& entry)
 	{
-		Header()
-			: id(*(u32*)"DCAC")
-			, key_t_size(sizeof(K))
-			, value_t_size(sizeof(V))
+		const V* value = (const V*)(m_mapping.GetData() + entry.offset);
+		if (Checksum(entry.key, value, entry.value_size) != entry.checksum)
 		{
-			memcpy(ver, scm_rev_cache_str, 40);
+			WARN_LOG(COMMON, "Disk cache %s has a corrupt entry", m_filename.c_str());
+			m_needs_compaction = true;
+			return nullptr;
 		}
+		return value;
+	}
 
-		const u32 id;
-		const u16 key_t_size, value_t_size;
-		char ver[40];
+	const V* GetJournalValue(typename Journal::iterator it)
+	{
+		JournalEntry& entry = it->second;
+		if (entry.offset == 0)
+		{
+			static const V empty_value = V();
+			return entry.value.empty() ? &empty_value : entry.value.data();
+		}
+
+		const V* value = (const V*)(m_mapping.GetData() + entry.offset);
+		if (!entry.verified)
+		{
+			if (Checksum(it->first, value, entry.value_size) != entry.checksum)
+			{
+				WARN_LOG(COMMON, "Disk cache %s has a corrupt entry", m_filename.c_str());
+				m_journal.erase(it);
+				m_needs_compaction = true;
+				return nullptr;
+			}
+			entry.verified = true;
+		}
+		return value;
+	}
 
-	} m_header;
+	static bool CreateEmpty(const std::string& filename)
+	{
+		File::IOFile file(filename, "wb");
+		Header header;
+		return file.WriteBytes(&header, sizeof(Header));
+	}
+
+	// Writes all valid entries into a new sorted index and replaces the file
+	// with it. Leaves the file unmapped.
+	bool Compact()
+	{
+		struct LiveEntry
+		{
+			K key;
+			const V* value;
+			u32 value_size;
+			u32 checksum;
+		};
+		std::vector<LiveEntry> entries;
+		entries.reserve(m_num_indexed + m_journal.size());
+
+		for (u32 i = 0; i < m_num_indexed; i++)
+		{
+			const IndexEntry& entry = m_index[i];
+			if (m_journal.count(entry.key))
+				continue;
+
+			const V* value = GetIndexedValue(entry);
+			if (value)
+				entries.push_back({ entry.key, value, entry.value_size, entry.checksum });
+		}
+		for (auto it = m_journal.begin(); it != m_journal.end(); )
+		{
+			const K key = it->first;
+			const V* value = GetJournalValue(it++);
+			if (value)
+			{
+				const JournalEntry& entry = m_journal[key];
+				entries.push_back({ key, value, entry.value_size, entry.checksum });
+			}
+		}
+		std::sort(entries.begin(), entries.end(),
+			[](const LiveEntry& a, const LiveEntry& b) { return KeyLess()(a.key, b.key); });
+
+		Header header;
+		header.num_indexed = (u32)entries.size();
+		u64 offset = sizeof(Header) + entries.size() * sizeof(IndexEntry);
+		std::vector<IndexEntry> index(entries.size());
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			memset(&index[i], 0, sizeof(IndexEntry));
+			index[i].key = entries[i].key;
+			index[i].value_size = entries[i].value_size;
+			index[i].checksum = entries[i].checksum;
+			index[i].offset = offset;
+			offset = Align(offset + entries[i].value_size * sizeof(V));
+		}
+		header.journal_offset = offset;
+
+		const std::string temp_filename = m_filename + ".tmp";
+		bool success;
+		{
+			File::IOFile file(temp_filename, "wb");
+			success = file.WriteBytes(&header, sizeof(Header)) &&
+			          file.WriteBytes(index.data(), index.size() * sizeof(IndexEntry));
+			for (size_t i = 0; success && i < entries.size(); i++)
+			{
+				success = file.WriteBytes(entries[i].value, entries[i].value_size * sizeof(V));
+				WritePadding(file, entries[i].value_size * sizeof(V));
+			}
+		}
+
+		// The values written above may live in the mapping, and the file can't
+		// be replaced while it is mapped on Windows.
+		m_mapping.Close();
+		m_index = nullptr;
+		m_num_indexed = 0;
+		m_journal.clear();
+		m_needs_compaction = false;
+
+		if (!success || !File::Rename(temp_filename, m_filename))
+		{
+			ERROR_LOG(COMMON, "Failed to compact disk cache %s", m_filename.c_str());
+			File::Delete(temp_filename);
+			return false;
+		}
+
+		INFO_LOG(COMMON, "Compacted disk cache %s to %u entries", m_filename.c_str(), header.num_indexed);
+		return true;
+	}
 
-	std::fstream m_file;
-	u32 m_num_entries;
+	std::string m_filename;
+	File::MappedFile m_mapping;
+	File::IOFile m_file; // for appending
+	const IndexEntry* m_index;
+	u32 m_num_indexed;
+	Journal m_journal;
+	bool m_needs_compaction;
 };
@@ -2,8 +2,10 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <cstdarg>
 #include <cstring>
+#include <ctime>
 #include <mutex>
 #include <ostream>
 #include <set>
@@ -14,6 +16,7 @@
 #endif
 #include "Common/FileUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "Common/Timer.h"
 #include "Common/Logging/ConsoleListener.h"
 #include "Common/Logging/Log.h"
@@ -82,6 +85,18 @@ LogManager::LogManager()
 	m_Log[LogTypes::MEMCARD_MANAGER] = new LogContainer("MemCard Manager", "MemCard Manager");
 	m_Log[LogTypes::NETPLAY] = new LogContainer("NETPLAY", "Netplay");
 
+	m_queue = new QueuedMessage[LOG_QUEUE_SIZE];
+	for (u32 i = 0; i < LOG_QUEUE_SIZE; i++)
+		m_queue[i].sequence.store(i);
+	m_write_pos.store(0);
+	m_read_pos.store(0);
+	m_dropped.store(0);
+	m_dropped_reported = 0;
+	m_thread_sleeping.store(false);
+	m_stop = false;
+	m_time_seconds = 0;
+	m_time_str[0] = '\0';
+
 	m_fileLog = new FileLogListener(File::GetUserPath(F_MAINLOG_IDX));
 	m_consoleLog = new ConsoleListener();
 	m_debuggerLog = new DebuggerLogListener();
@@ -96,10 +111,20 @@ LogManager::LogManager()
 			container->AddListener(m_debuggerLog);
 #endif
 	}
+
+	m_thread = std::thread(&LogManager::ThreadFunc, this);
 }
 
 LogManager::~LogManager()
 {
+	// The thread writes out what's left before it exits
+	{
+		std::lock_guard<std::mutex> lk(m_thread_lock);
+		m_stop = true;
+		m_wake.notify_one();
+	}
+	m_thread.join();
+
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
 	{
 		m_logManager->RemoveListener((LogTypes::LOG_TYPE)i, m_fileLog);
@@ -113,28 +138,154 @@ LogManager::~LogManager()
 	delete m_fileLog;
 	delete m_consoleLog;
 	delete m_debuggerLog;
+	delete[] m_queue;
 }
 
 void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 	const char *file, int line, const char *format, va_list args)
 {
-	char temp[MAX_MSGLEN];
 	LogContainer *log = m_Log[type];
 
 	if (!log->IsEnabled() || level > log->GetLevel() || !log->HasListeners())
 		return;
 
-	CharArrayFromFormatV(temp, MAX_MSGLEN, format, args);
+	// Claim a slot. Its sequence number equals the write position while it's
+	// free, and trails it while the log thread hasn't written it out yet.
+	u32 pos = m_write_pos.load(std::memory_order_relaxed);
+	QueuedMessage* message;
+	while (true)
+	{
+		message = &m_queue[pos & (LOG_QUEUE_SIZE - 1)];
+		const s32 diff = (s32)(message->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0)
+		{
+			if (m_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			m_dropped++;
+			return;
+		}
+		else
+		{
+			pos = m_write_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Strings passed for %s may not outlive this call, so the message itself
+	// has to be formatted here.
+	CharArrayFromFormatV(message->text, MAX_MSGLEN, format, args);
+	message->level = level;
+	message->type = type;
+	message->file = file;
+	message->line = line;
+	message->time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	message->sequence.store(pos + 1, std::memory_order_release);
+
+	if (m_thread_sleeping.exchange(false))
+	{
+		std::lock_guard<std::mutex> lk(m_thread_lock);
+		m_wake.notify_one();
+	}
+}
+
+void LogManager::Flush()
+{
+	if (std::this_thread::get_id() == m_thread.get_id())
+		return;
+
+	const u32 target = m_write_pos.load();
+	std::unique_lock<std::mutex> lk(m_thread_lock);
+	m_wake.notify_one();
+	// A message still being formatted by another thread holds up the log
+	// thread, so don't wait on it forever.
+	m_drained.wait_for(lk, std::chrono::seconds(1), [&] { return (s32)(m_read_pos.load() - target) >= 0; });
+}
+
+void LogManager::WriteMessage(const QueuedMessage& message)
+{
+	LogContainer *log = m_Log[message.type];
+
+	// Same as Common::Timer::GetTimeFormatted, at the time the message was logged
+	const time_t seconds = (time_t)(message.time_ms / 1000);
+	if (seconds != m_time_seconds)
+	{
+		strftime(m_time_str, sizeof(m_time_str), "%M:%S", localtime(&seconds));
+		m_time_seconds = seconds;
+	}
 
-	std::string msg = StringFromFormat("%s %s:%u %c[%s]: %s\n",
-		Common::Timer::GetTimeFormatted().c_str(),
-		file, line,
-		LogTypes::LOG_LEVEL_TO_CHAR[(int)level],
-		log->GetShortName().c_str(), temp);
+	std::string msg = StringFromFormat("%s:%03u %s:%u %c[%s]: %s\n",
+		m_time_str, (u32)(message.time_ms % 1000),
+		message.file, message.line,
+		LogTypes::LOG_LEVEL_TO_CHAR[(int)message.level],
+		log->GetShortName().c_str(), message.text);
 #ifdef ANDROID
 	Host_SysMessage(msg.c_str());
 #endif
-	log->Trigger(level, msg.c_str());
+	log->Trigger(message.level, msg.c_str());
+}
+
+void LogManager::WriteQueued()
+{
+	u32 pos = m_read_pos.load(std::memory_order_relaxed);
+	const u32 start = pos;
+
+	while (true)
+	{
+		QueuedMessage& message = m_queue[pos & (LOG_QUEUE_SIZE - 1)];
+		if (message.sequence.load(std::memory_order_acquire) != pos + 1)
+			break;
+
+		WriteMessage(message);
+		message.sequence.store(pos + LOG_QUEUE_SIZE, std::memory_order_release);
+		m_read_pos.store(++pos);
+	}
+
+	const u32 dropped = m_dropped.load();
+	if (dropped != m_dropped_reported)
+	{
+		const std::string msg = StringFromFormat("%s %c[%s]: %u log messages dropped\n",
+			Common::Timer::GetTimeFormatted().c_str(),
+			LogTypes::LOG_LEVEL_TO_CHAR[(int)LogTypes::LWARNING],
+			m_Log[LogTypes::MASTER_LOG]->GetShortName().c_str(), dropped - m_dropped_reported);
+		m_Log[LogTypes::MASTER_LOG]->Trigger(LogTypes::LWARNING, msg.c_str());
+		m_dropped_reported = dropped;
+	}
+
+	// One write to the file for the whole batch
+	if (pos != start)
+		m_fileLog->Flush();
+}
+
+void LogManager::ThreadFunc()
+{
+	Common::SetCurrentThreadName("Log thread");
+
+	while (true)
+	{
+		WriteQueued();
+
+		std::unique_lock<std::mutex> lk(m_thread_lock);
+		m_drained.notify_all();
+		if (m_stop)
+			break;
+
+		// Ask the next Log() to wake us, then check that nothing was queued
+		// in between. The timeout is only a safety net.
+		m_thread_sleeping.store(true);
+		const u32 pos = m_read_pos.load();
+		if (m_queue[pos & (LOG_QUEUE_SIZE - 1)].sequence.load() == pos + 1)
+		{
+			m_thread_sleeping.store(false);
+			continue;
+		}
+		m_wake.wait_for(lk, std::chrono::milliseconds(100));
+		m_thread_sleeping.store(false);
+	}
+
+	WriteQueued();
 }
 
 void LogManager::Init()
@@ -191,7 +342,16 @@ void FileLogListener::Log(LogTypes::LOG_LEVELS, const char *msg)
 		return;
 
 	std::lock_guard<std::mutex> lk(m_log_lock);
-	m_logfile << msg << std::flush;
+	m_logfile << msg;
+}
+
+void FileLogListener::Flush()
+{
+	if (!IsValid())
+		return;
+
+	std::lock_guard<std::mutex> lk(m_log_lock);
+	m_logfile.flush();
 }
 
 void DebuggerLogListener::Log(LogTypes::LOG_LEVELS, const char *msg)
@@ -4,16 +4,22 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdarg>
+#include <ctime>
 #include <fstream>
 #include <set>
 #include <string>
 
 #include "Common/Common.h"
+#include "Common/StdConditionVariable.h"
 #include "Common/StdMutex.h"
+#include "Common/StdThread.h"
 
 #define MAX_MESSAGES 8000
 #define MAX_MSGLEN  1024
+// Messages waiting for the log thread; must be a power of two
+#define LOG_QUEUE_SIZE 2048
 
 
 // pure virtual interface
@@ -31,6 +37,7 @@ public:
 	FileLogListener(const std::string& filename);
 
 	void Log(LogTypes::LOG_LEVELS, const char *msg) override;
+	void Flush();
 
 	bool IsValid() { return !m_logfile.fail(); }
 	bool IsEnabled() const { return m_enable; }
@@ -83,17 +90,51 @@ private:
 
 class ConsoleListener;
 
+// Log() only formats the message into a free slot of a lock-free ring and
+// returns. The timestamp, the prefix and the listeners are left to the log
+// thread, which writes out everything queued at once. When the ring is full,
+// messages are dropped and counted rather than stalling the emulator.
 class LogManager : NonCopyable
 {
 private:
+	struct QueuedMessage
+	{
+		std::atomic<u32> sequence;
+		LogTypes::LOG_LEVELS level;
+		LogTypes::LOG_TYPE type;
+		const char *file;
+		int line;
+		u64 time_ms;
+		char text[MAX_MSGLEN];
+	};
+
 	LogContainer* m_Log[LogTypes::NUMBER_OF_LOGS];
 	FileLogListener *m_fileLog;
 	ConsoleListener *m_consoleLog;
 	DebuggerLogListener *m_debuggerLog;
 	static LogManager *m_logManager;  // Singleton. Ugh.
 
+	QueuedMessage *m_queue;
+	std::atomic<u32> m_write_pos;
+	std::atomic<u32> m_read_pos;
+	std::atomic<u32> m_dropped;
+	u32 m_dropped_reported;
+	// Only touched by the log thread
+	time_t m_time_seconds;
+	char m_time_str[6];
+	std::atomic<bool> m_thread_sleeping;
+	bool m_stop;
+	std::mutex m_thread_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_drained;
+	std::thread m_thread;
+
 	LogManager();
 	~LogManager();
+
+	void ThreadFunc();
+	void WriteQueued();
+	void WriteMessage(const QueuedMessage& message);
 public:
 
 	static u32 GetMaxLevel() { return MAX_LOGLEVEL; }
@@ -101,6 +142,12 @@ public:
 	void Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 		const char *file, int line, const char *fmt, va_list args);
 
+	// Waits until the listeners have seen every message logged so far.
+	void Flush();
+
+	// Messages lost because the log thread fell behind.
+	u32 GetDroppedMessages() const { return m_dropped.load(); }
+
 	void SetLogLevel(LogTypes::LOG_TYPE type, LogTypes::LOG_LEVELS level)
 	{
 		m_Log[type]->SetLevel(level);
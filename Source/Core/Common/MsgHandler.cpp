@@ -8,6 +8,7 @@
 
 #include "Common/Common.h"
 #include "Common/StringUtil.h"
+#include "Common/Logging/LogManager.h"
 
 bool DefaultMsgHandler(const char* caption, const char* text, bool yes_no, int Style);
 static MsgAlertHandler msg_handler = DefaultMsgHandler;
@@ -78,6 +79,9 @@ bool MsgAlert(bool yes_no, int Style, const char* format, ...)
 	va_end(args);
 
 	ERROR_LOG(MASTER_LOG, "%s: %s", caption.c_str(), buffer);
+	// The log is written on another thread; get it out before a crash
+	if (LogManager::GetInstance())
+		LogManager::GetInstance()->Flush();
 
 	// Don't ignore questions, especially AskYesNo, PanicYesNo could be ignored
 	if (msg_handler && (AlertEnabled || Style == QUESTION || Style == CRITICAL))
@@ -4,6 +4,7 @@
 
 #include "Common/Common.h"
 #include "Common/Thread.h"
+#include "Common/Timeline.h"
 
 #ifdef __APPLE__
 #include <mach/mach.h>
@@ -62,6 +63,8 @@ void SetCurrentThreadName(const char* szThreadName)
 {
 	static const DWORD MS_VC_EXCEPTION = 0x406D1388;
 
+	Timeline::SetThreadName(szThreadName);
+
 	#pragma pack(push,8)
 	struct THREADNAME_INFO
 	{
@@ -121,6 +124,8 @@ void SwitchCurrentThread()
 
 void SetCurrentThreadName(const char* szThreadName)
 {
+	Timeline::SetThreadName(szThreadName);
+
 #ifdef __APPLE__
 	pthread_setname_np(szThreadName);
 #else
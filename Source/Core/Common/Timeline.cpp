@@ -0,0 +1,246 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "Common/Timeline.h"
+
+#ifdef _WIN32
+#define TIMELINE_TLS __declspec(thread)
+#else
+#define TIMELINE_TLS __thread
+#endif
+
+namespace Timeline
+{
+
+// Events kept for each thread; must be a power of two. A busy video thread
+// records some 10000 a frame.
+static const u32 RING_SIZE = 1 << 16;
+static const u32 NAME_LENGTH = 32;
+
+static const char FRAME_MARKER[] = "Frame";
+
+struct Event
+{
+	const char* name;
+	u64 start;
+	u64 end;
+};
+
+struct ThreadRing
+{
+	u32 id;
+	char name[NAME_LENGTH];
+	// Events ever recorded; only the last RING_SIZE are kept
+	std::atomic<u32> count;
+	Event events[RING_SIZE];
+};
+
+struct ThreadEvents
+{
+	u32 id;
+	std::string name;
+	std::vector<Event> events;
+};
+
+bool g_enabled = false;
+
+static std::mutex s_lock;
+static std::vector<ThreadRing*> s_rings;
+// Rings from before the last Shutdown have an older generation
+static std::atomic<u32> s_generation(1);
+static std::thread s_export_thread;
+
+static TIMELINE_TLS ThreadRing* s_ring;
+static TIMELINE_TLS u32 s_ring_generation;
+static TIMELINE_TLS char s_thread_name[NAME_LENGTH];
+
+#ifdef _WIN32
+static double GetTicksToNs()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return 1e9 / (double)frequency.QuadPart;
+}
+
+static const double s_ticks_to_ns = GetTicksToNs();
+#endif
+
+u64 Now()
+{
+#ifdef _WIN32
+	// high_resolution_clock only has millisecond resolution on MSVC 2013
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return (u64)((double)ticks.QuadPart * s_ticks_to_ns);
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void SetEnabled(bool enabled)
+{
+	g_enabled = enabled;
+}
+
+static ThreadRing* GetRing()
+{
+	if (s_ring && s_ring_generation == s_generation.load(std::memory_order_relaxed))
+		return s_ring;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	ThreadRing* ring = new ThreadRing;
+	ring->id = (u32)s_rings.size() + 1;
+	if (s_thread_name[0])
+		strncpy(ring->name, s_thread_name, NAME_LENGTH);
+	else
+		snprintf(ring->name, NAME_LENGTH, "Thread %u", ring->id);
+	ring->name[NAME_LENGTH - 1] = '\0';
+	ring->count.store(0);
+	s_rings.push_back(ring);
+
+	s_ring = ring;
+	s_ring_generation = s_generation.load(std::memory_order_relaxed);
+	return ring;
+}
+
+void Record(const char* name, u64 start, u64 end)
+{
+	ThreadRing* ring = GetRing();
+	const u32 count = ring->count.load(std::memory_order_relaxed);
+	Event& event = ring->events[count & (RING_SIZE - 1)];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	ring->count.store(count + 1, std::memory_order_release);
+}
+
+void SetThreadName(const char* name)
+{
+	strncpy(s_thread_name, name, NAME_LENGTH);
+	s_thread_name[NAME_LENGTH - 1] = '\0';
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_ring && s_ring_generation == s_generation.load(std::memory_order_relaxed))
+		memcpy(s_ring->name, s_thread_name, NAME_LENGTH);
+}
+
+void MarkFrame()
+{
+	if (!g_enabled)
+		return;
+
+	const u64 now = Now();
+	Record(FRAME_MARKER, now, now);
+}
+
+static void WriteChromeTrace(const std::string& filename, const std::vector<ThreadEvents>& threads, u64 since)
+{
+	std::string json = "{\"traceEvents\":[\n";
+	char buffer[256];
+	bool first = true;
+
+	for (const ThreadEvents& thread : threads)
+	{
+		snprintf(buffer, sizeof(buffer),
+			"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+			first ? "" : ",\n", thread.id, thread.name.c_str());
+		json += buffer;
+		first = false;
+
+		for (const Event& event : thread.events)
+		{
+			// Microseconds, with the start of the export at 0
+			const double ts = (double)(s64)(event.start - since) / 1000.0;
+			if (event.name == FRAME_MARKER)
+			{
+				snprintf(buffer, sizeof(buffer),
+					",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+					event.name, thread.id, ts);
+			}
+			else
+			{
+				snprintf(buffer, sizeof(buffer),
+					",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					event.name, thread.id, ts, (double)(event.end - event.start) / 1000.0);
+			}
+			json += buffer;
+		}
+	}
+	json += "\n]}\n";
+
+	File::CreateFullPath(filename);
+	if (!File::WriteStringToFile(json, filename))
+		ERROR_LOG(COMMON, "Failed to write the timeline to %s", filename.c_str());
+}
+
+void ExportChromeTrace(const std::string& filename, u64 since)
+{
+	std::vector<ThreadEvents> threads;
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		threads.resize(s_rings.size());
+		for (size_t i = 0; i < s_rings.size(); i++)
+		{
+			const ThreadRing* ring = s_rings[i];
+			ThreadEvents& thread = threads[i];
+			thread.id = ring->id;
+			thread.name = ring->name;
+
+			const u32 count = ring->count.load(std::memory_order_acquire);
+			const u32 first = count > RING_SIZE ? count - RING_SIZE : 0;
+			std::vector<Event> events(count - first);
+			for (u32 n = first; n != count; n++)
+				events[n - first] = ring->events[n & (RING_SIZE - 1)];
+
+			// The thread kept recording while we copied, so the oldest events
+			// may have been overwritten in the meantime.
+			const u32 new_count = ring->count.load(std::memory_order_acquire);
+			const u32 valid = new_count > RING_SIZE ? new_count - RING_SIZE : 0;
+			const u32 skip = std::min<u32>(valid > first ? valid - first : 0, (u32)events.size());
+
+			thread.events.reserve(events.size() - skip);
+			for (size_t e = skip; e < events.size(); e++)
+			{
+				if (events[e].end >= since)
+					thread.events.push_back(events[e]);
+			}
+		}
+	}
+
+	// Formatting takes a few milliseconds, which the caller can't spare
+	if (s_export_thread.joinable())
+		s_export_thread.join();
+	s_export_thread = std::thread(WriteChromeTrace, filename, std::move(threads), since);
+}
+
+void Shutdown()
+{
+	g_enabled = false;
+	if (s_export_thread.joinable())
+		s_export_thread.join();
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	for (ThreadRing* ring : s_rings)
+		delete ring;
+	s_rings.clear();
+	s_generation++;
+}
+
+}  // namespace
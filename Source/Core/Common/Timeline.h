@@ -0,0 +1,68 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Records when each thread enters and leaves the interesting parts of a
+// frame, to find out where the time went when a frame is late. Every thread
+// writes to a ring of its own, so recording a zone costs two timer reads and
+// a store, and nothing when the timeline is disabled. The rings can be saved
+// in the Chrome trace format, which chrome://tracing and Perfetto load.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+namespace Timeline
+{
+
+extern bool g_enabled;
+
+inline bool IsEnabled() { return g_enabled; }
+void SetEnabled(bool enabled);
+
+// Nanoseconds on a monotonic clock
+u64 Now();
+
+// name must outlive the recording, so use string literals
+void Record(const char* name, u64 start, u64 end);
+
+// Called by Common::SetCurrentThreadName
+void SetThreadName(const char* name);
+
+// Marks the end of a frame on the calling thread's track
+void MarkFrame();
+
+// Writes everything recorded since the given time to filename as Chrome
+// trace JSON. The events are copied on the calling thread and formatted and
+// written on another one.
+void ExportChromeTrace(const std::string& filename, u64 since);
+
+// Called when emulation stops, with the threads that record gone. Waits for
+// the last export and frees the rings.
+void Shutdown();
+
+class Zone
+{
+public:
+	explicit Zone(const char* name)
+		: m_name(g_enabled ? name : nullptr)
+		, m_start(m_name ? Now() : 0)
+	{
+	}
+
+	~Zone()
+	{
+		if (m_name)
+			Record(m_name, m_start, Now());
+	}
+
+private:
+	const char* m_name;
+	u64 m_start;
+};
+
+}  // namespace
+
+#define TIMELINE_ZONE(name) Timeline::Zone timeline_zone(name)
@@ -329,6 +329,8 @@ void SConfig::SaveDSPSettings(IniFile& ini)
 	dsp->Set("Backend", sBackend);
 	dsp->Set("Volume", m_Volume);
 	dsp->Set("CaptureLog", m_DSPCaptureLog);
+	dsp->Set("PolyphaseResampler", m_PolyphaseResampler);
+	dsp->Set("OfflineFile", m_OfflineAudioFile);
 }
 
 void SConfig::SaveInputSettings(IniFile& ini)
@@ -531,7 +533,12 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("BBDumpPort",                &m_LocalCoreStartupParameter.iBBDumpPort,       -1);
 	core->Get("VBeam",                     &m_LocalCoreStartupParameter.bVBeamSpeedHack,   false);
 	core->Get("SyncGPU",                   &m_LocalCoreStartupParameter.bSyncGPU,          false);
+	core->Get("HostTimeProfiling",         &m_LocalCoreStartupParameter.bHostTimeProfiling, false);
 	core->Get("FastDiscSpeed",             &m_LocalCoreStartupParameter.bFastDiscSpeed,    false);
+	core->Get("Rewind",                    &m_LocalCoreStartupParameter.bRewind,           false);
+	core->Get("RewindInterval",            &m_LocalCoreStartupParameter.iRewindInterval,   60);
+	core->Get("RewindMemoryMB",            &m_LocalCoreStartupParameter.iRewindMemoryMB,   512);
+	core->Get("DeltaSavestates",           &m_LocalCoreStartupParameter.bDeltaSavestates,  false);
 	core->Get("DCBZ",                      &m_LocalCoreStartupParameter.bDCBZOFF,          false);
 	core->Get("FrameLimit",                &m_Framelimit,                                  1); // auto frame limit by default
 	core->Get("FrameSkip",                 &m_FrameSkip,                                   0);
@@ -565,6 +572,8 @@ void SConfig::LoadDSPSettings(IniFile& ini)
 #endif
 	dsp->Get("Volume", &m_Volume, 100);
 	dsp->Get("CaptureLog", &m_DSPCaptureLog, false);
+	dsp->Get("PolyphaseResampler", &m_PolyphaseResampler, false);
+	dsp->Get("OfflineFile", &m_OfflineAudioFile, "");
 }
 
 void SConfig::LoadInputSettings(IniFile& ini)
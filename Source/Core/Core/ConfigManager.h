@@ -22,6 +22,7 @@
 #define BACKEND_PULSEAUDIO  "Pulse"
 #define BACKEND_XAUDIO2     "XAudio2"
 #define BACKEND_OPENSLES    "OpenSLES"
+#define BACKEND_OFFLINE     "Offline"
 struct SConfig : NonCopyable
 {
 	// Wii Devices
@@ -93,9 +94,12 @@ struct SConfig : NonCopyable
 	// DSP settings
 	bool m_DSPEnableJIT;
 	bool m_DSPCaptureLog;
+	bool m_PolyphaseResampler;
 	bool m_DumpAudio;
 	int m_Volume;
 	std::string sBackend;
+	// Written by the offline backend; .raw for headerless samples, else WAV
+	std::string m_OfflineAudioFile;
 
 	// Input settings
 	bool m_BackgroundInput;
@@ -18,6 +18,7 @@
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Common/Timeline.h"
 #include "Common/Timer.h"
 #include "Common/Logging/LogManager.h"
 
@@ -486,6 +487,7 @@ void EmuThread()
 	Wiimote::Shutdown();
 	g_video_backend->Shutdown();
 	AudioCommon::ShutdownSoundStream();
+	Timeline::Shutdown();
 
 	INFO_LOG(CONSOLE, "%s", StopMessage(true, "Main Emu thread stopped").c_str());
 
@@ -36,11 +36,12 @@ SCoreStartupParameter::SCoreStartupParameter()
   bCPUThread(true), bDSPThread(false), bDSPHLE(true),
   bSkipIdle(true), bNTSC(false), bForceNTSCJ(false),
   bHLE_BS2(true), bEnableCheats(false),
-  bMergeBlocks(false), bEnableMemcardSaving(true),
+  bMergeBlocks(false), bEnableMemcardSaving(true), bHostTimeProfiling(false),
   bDPL2Decoder(false), bTimeStretching(false), iLatency(14),
   bRunCompareServer(false), bRunCompareClient(false),
   bMMU(false), bDCBZOFF(false), bTLBHack(false), iBBDumpPort(0), bVBeamSpeedHack(false),
   bSyncGPU(false), bFastDiscSpeed(false),
+  bRewind(false), iRewindInterval(60), iRewindMemoryMB(512), bDeltaSavestates(false),
   SelectedLanguage(0), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -80,8 +81,13 @@ void SCoreStartupParameter::LoadDefaults()
 	bVBeamSpeedHack = false;
 	bSyncGPU = false;
 	bFastDiscSpeed = false;
+	bRewind = false;
+	iRewindInterval = 60;
+	iRewindMemoryMB = 512;
+	bDeltaSavestates = false;
 	bMergeBlocks = false;
 	bEnableMemcardSaving = true;
+	bHostTimeProfiling = false;
 	SelectedLanguage = 0;
 	bWii = false;
 	bDPL2Decoder = false;
@@ -132,6 +138,7 @@ bool SCoreStartupParameter::AutoSetup(EBootBS2 _BootBS2)
 				!strcasecmp(Extension.c_str(), ".wbfs") ||
 				!strcasecmp(Extension.c_str(), ".ciso") ||
 				!strcasecmp(Extension.c_str(), ".gcz") ||
+				!strcasecmp(Extension.c_str(), ".dcz") ||
 				bootDrive)
 			{
 				m_BootType = BOOT_ISO;
@@ -128,6 +128,7 @@ struct SCoreStartupParameter
 	bool bEnableCheats;
 	bool bMergeBlocks;
 	bool bEnableMemcardSaving;
+	bool bHostTimeProfiling;
 
 	bool bDPL2Decoder;
 	bool bTimeStretching;
@@ -144,6 +145,13 @@ struct SCoreStartupParameter
 	bool bSyncGPU;
 	bool bFastDiscSpeed;
 
+	// In-memory rewind history (see Core/Rewind.h)
+	bool bRewind;
+	int iRewindInterval;
+	int iRewindMemoryMB;
+	// Slot saves hold only the pages changed since a base state (see Core/State.h)
+	bool bDeltaSavestates;
+
 	int SelectedLanguage;
 
 	bool bWii;
@@ -2,17 +2,22 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "Common/ChunkFile.h"
 #include "Common/FifoQueue.h"
+#include "Common/FileUtil.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Common/Timeline.h"
 
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/HW/SystemTimers.h"
 #include "Core/PowerPC/PowerPC.h"
 
 #include "VideoCommon/VideoBackendBase.h"
@@ -22,10 +27,25 @@
 namespace CoreTiming
 {
 
+struct HostTime
+{
+	HostTime() : ns(0), calls(0) {}
+
+	void Add(u64 time)
+	{
+		ns += time;
+		calls++;
+	}
+
+	u64 ns;
+	u64 calls;
+};
+
 struct EventType
 {
 	TimedCallback callback;
 	std::string name;
+	HostTime host_time;
 };
 
 static std::vector<EventType> event_types;
@@ -63,6 +83,24 @@ static int ev_lost;
 
 static void (*advanceCallback)(int cyclesExecuted) = nullptr;
 
+bool g_host_time_profiling = false;
+
+// MMIO handlers are keyed by (write << 32) | address, HLE functions by the
+// name in their patch table entry. Both are almost always called on the CPU
+// thread, but the lock keeps the debugger's accesses from racing it.
+static std::mutex s_host_time_lock;
+static std::map<u64, HostTime> s_mmio_host_time;
+static std::map<const char*, HostTime> s_hle_host_time;
+// Events, MMIO accesses and HLE functions can nest inside each other, so only
+// the outermost measurement on the CPU thread counts towards the time the
+// rows add up to.
+static int s_host_time_depth;
+static u64 s_attributed_ns;
+static u64 s_idle_wait_ns;
+static u64 s_start_ns;
+static s64 s_start_ticks;
+static s64 s_start_idled_cycles;
+
 static Event* GetNewEvent()
 {
 	if (!eventPool)
@@ -120,6 +158,16 @@ void Init()
 	idledCycles = 0;
 
 	ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
+
+	g_host_time_profiling = Core::g_CoreStartupParameter.bHostTimeProfiling;
+	s_mmio_host_time.clear();
+	s_hle_host_time.clear();
+	s_host_time_depth = 0;
+	s_attributed_ns = 0;
+	s_idle_wait_ns = 0;
+	s_start_ns = Timeline::Now();
+	s_start_ticks = globalTimer;
+	s_start_idled_cycles = idledCycles;
 }
 
 void Shutdown()
@@ -127,6 +175,19 @@ void Shutdown()
 	std::lock_guard<std::mutex> lk(tsWriteLock);
 	MoveEvents();
 	ClearPendingEvents();
+
+	if (g_host_time_profiling)
+	{
+		const std::string summary = GetHostTimeSummary();
+		const std::string filename = File::GetUserPath(D_LOGS_IDX) + "host_time.txt";
+		File::CreateFullPath(filename);
+		if (File::WriteStringToFile(summary, filename))
+			NOTICE_LOG(POWERPC, "Wrote the host time profile to %s", filename.c_str());
+		else
+			ERROR_LOG(POWERPC, "Failed to write the host time profile to %s", filename.c_str());
+		g_host_time_profiling = false;
+	}
+
 	UnregisterAllEvents();
 
 	while (eventPool)
@@ -199,6 +260,24 @@ u64 GetIdleTicks()
 	return (u64)idledCycles;
 }
 
+static void RunEvent(int event_type, u64 userdata, int cyclesLate)
+{
+	if (!g_host_time_profiling)
+	{
+		event_types[event_type].callback(userdata, cyclesLate);
+		return;
+	}
+
+	s_host_time_depth++;
+	const u64 start = Timeline::Now();
+	event_types[event_type].callback(userdata, cyclesLate);
+	const u64 time = Timeline::Now() - start;
+	// Index again, the callback may have registered events
+	event_types[event_type].host_time.Add(time);
+	if (--s_host_time_depth == 0)
+		s_attributed_ns += time;
+}
+
 // This is to be called when outside threads, such as the graphics thread, wants to
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata)
@@ -217,7 +296,7 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 {
 	if (Core::IsCPUThread())
 	{
-		event_types[event_type].callback(userdata, 0);
+		RunEvent(event_type, userdata, 0);
 	}
 	else
 	{
@@ -363,7 +442,7 @@ void ProcessFifoWaitEvents()
 		{
 			Event* evt = first;
 			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
+			RunEvent(evt->type, evt->userdata, (int)(globalTimer - evt->time));
 			FreeEvent(evt);
 		}
 		else
@@ -402,7 +481,7 @@ void Advance()
 			//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
 			Event* evt = first;
 			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
+			RunEvent(evt->type, evt->userdata, (int)(globalTimer - evt->time));
 			FreeEvent(evt);
 		}
 		else
@@ -448,7 +527,19 @@ void Idle()
 	while (g_video_backend->Video_IsPossibleWaitingSetDrawDone())
 	{
 		ProcessFifoWaitEvents();
-		Common::YieldCPU();
+		if (g_host_time_profiling)
+		{
+			const u64 start = Timeline::Now();
+			Common::YieldCPU();
+			const u64 time = Timeline::Now() - start;
+			s_idle_wait_ns += time;
+			if (s_host_time_depth == 0)
+				s_attributed_ns += time;
+		}
+		else
+		{
+			Common::YieldCPU();
+		}
 	}
 
 	idledCycles += PowerPC::ppcState.downcount;
@@ -476,6 +567,136 @@ std::string GetScheduledEventsSummary()
 	return text;
 }
 
+u64 BeginHostTime()
+{
+	if (Core::IsCPUThread())
+		s_host_time_depth++;
+	return Timeline::Now();
+}
+
+static void EndHostTime(u64 ns)
+{
+	if (Core::IsCPUThread() && --s_host_time_depth == 0)
+		s_attributed_ns += ns;
+}
+
+void EndMMIOHostTime(u32 address, bool write, u64 start)
+{
+	const u64 ns = Timeline::Now() - start;
+	{
+		std::lock_guard<std::mutex> lk(s_host_time_lock);
+		s_mmio_host_time[((u64)write << 32) | address].Add(ns);
+	}
+	EndHostTime(ns);
+}
+
+void EndHLEHostTime(const char* function, u64 start)
+{
+	const u64 ns = Timeline::Now() - start;
+	{
+		std::lock_guard<std::mutex> lk(s_host_time_lock);
+		s_hle_host_time[function].Add(ns);
+	}
+	EndHostTime(ns);
+}
+
+static const char* GetMMIOBlockName(u32 address)
+{
+	const u32 offset = address & 0xFFFF;
+	if (offset >= 0x6000)
+	{
+		switch (offset & 0xFC00)
+		{
+		case 0x6000: return "DI";
+		case 0x6400: return "SI";
+		case 0x6800: return "EXI";
+		case 0x6C00: return "AI";
+		}
+		return "?";
+	}
+	// The Wii's own registers live at 0xCD000000
+	if (address & 0x01000000)
+		return "IPC";
+
+	switch (offset & 0xF000)
+	{
+	case 0x0000: return "CP";
+	case 0x1000: return "PE";
+	case 0x2000: return "VI";
+	case 0x3000: return "PI";
+	case 0x4000: return "MI";
+	case 0x5000: return "DSP";
+	}
+	return "?";
+}
+
+std::string GetHostTimeSummary()
+{
+	struct Row
+	{
+		std::string name;
+		HostTime time;
+	};
+	std::vector<Row> rows;
+
+	for (const EventType& type : event_types)
+	{
+		if (type.host_time.calls)
+		{
+			Row row = { "Event " + type.name, type.host_time };
+			rows.push_back(row);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lk(s_host_time_lock);
+		for (const auto& mmio : s_mmio_host_time)
+		{
+			const u32 address = (u32)mmio.first;
+			Row row = { StringFromFormat("MMIO %s %08x (%s)", (mmio.first >> 32) ? "write" : "read",
+			                             address, GetMMIOBlockName(address)), mmio.second };
+			rows.push_back(row);
+		}
+		for (const auto& hle : s_hle_host_time)
+		{
+			Row row = { std::string("HLE ") + hle.first, hle.second };
+			rows.push_back(row);
+		}
+	}
+	if (s_idle_wait_ns)
+	{
+		Row row = { "Waiting for the GPU while idle", HostTime() };
+		row.time.ns = s_idle_wait_ns;
+		rows.push_back(row);
+	}
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.time.ns > b.time.ns; });
+
+	const u64 host_ns = Timeline::Now() - s_start_ns;
+	const s64 ticks = globalTimer - s_start_ticks;
+	const s64 idled = idledCycles - s_start_idled_cycles;
+	const double host_seconds = host_ns / 1e9;
+	const double emulated_seconds = (double)ticks / SystemTimers::GetTicksPerSecond();
+
+	std::string text = "Host time on the CPU thread, including time paused\n";
+	text += StringFromFormat("Host: %.3f s, emulated: %.3f s, speed: %.1f%%\n",
+	                         host_seconds, emulated_seconds,
+	                         host_seconds > 0 ? 100.0 * emulated_seconds / host_seconds : 0.0);
+	text += StringFromFormat("Idle skipping: %.1f%% of emulated cycles, %.3f s waiting for the GPU\n\n",
+	                         ticks > 0 ? 100.0 * idled / ticks : 0.0, s_idle_wait_ns / 1e9);
+	text += StringFromFormat("%-48s %10s %7s %12s %10s\n", "", "ms", "%", "calls", "ns/call");
+
+	const auto add_row = [&](const std::string& name, u64 ns, u64 calls) {
+		text += StringFromFormat("%-48s %10.1f %6.2f%% %12" PRIu64 " %10" PRIu64 "\n",
+		                         name.c_str(), ns / 1e6, host_ns ? 100.0 * ns / host_ns : 0.0,
+		                         calls, calls ? ns / calls : 0);
+	};
+	for (const Row& row : rows)
+		add_row(row.name, row.time.ns, row.time.calls);
+	// Telling the two apart would mean timing generated code
+	add_row("JIT code and interpreter", host_ns > s_attributed_ns ? host_ns - s_attributed_ns : 0, 0);
+
+	return text;
+}
+
 u32 GetFakeDecStartValue()
 {
 	return fakeDecStartValue;
@@ -67,6 +67,18 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted));
 
 std::string GetScheduledEventsSummary();
 
+// Opt-in accounting of where the CPU thread spends host time, enabled by
+// Core/HostTimeProfiling in the ini: per event type, per MMIO register and
+// per HLE function, with JIT code and interpreter fallbacks making up the
+// rest. The summary is written to Logs/host_time.txt when emulation stops.
+extern bool g_host_time_profiling;
+// Brackets an MMIO access or HLE function. Time spent inside an event or
+// another bracketed call is only counted once towards the total.
+u64 BeginHostTime();
+void EndMMIOHostTime(u32 address, bool write, u64 start);
+void EndHLEHostTime(const char* function, u64 start);
+std::string GetHostTimeSummary();
+
 u32 GetFakeDecStartValue();
 void SetFakeDecStartValue(u32 val);
 u64 GetFakeDecStartTicks();
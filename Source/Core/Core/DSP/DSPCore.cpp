@@ -23,6 +23,9 @@
 
    ====================================================================*/
 
+#include <algorithm>
+#include <cinttypes>
+
 #include "Common/Common.h"
 #include "Common/Event.h"
 #include "Common/FileUtil.h"
@@ -40,10 +43,12 @@ SDSP g_dsp;
 DSPBreakpoints dsp_breakpoints;
 static DSPCoreState core_state = DSPCORE_STOP;
 u16 cyclesLeft = 0;
+u32 cyclesIdle = 0;
 bool init_hax = false;
 DSPEmitter *dspjit = nullptr;
 std::unique_ptr<DSPCaptureLogger> g_dsp_cap;
 static Common::Event step_event;
+static DSPCoreStats s_stats;
 
 // Returns false if the hash fails and the user hits "Yes"
 static bool VerifyRoms()
@@ -111,6 +116,7 @@ bool DSPCore_Init(const DSPInitOptions& opts)
 {
 	g_dsp.step_counter = 0;
 	cyclesLeft = 0;
+	s_stats = DSPCoreStats();
 	init_hax = false;
 	dspjit = nullptr;
 
@@ -178,6 +184,11 @@ bool DSPCore_Init(const DSPInitOptions& opts)
 	return true;
 }
 
+DSPCoreStats DSPCore_GetStats()
+{
+	return s_stats;
+}
+
 void DSPCore_Shutdown()
 {
 	if (core_state == DSPCORE_STOP)
@@ -186,6 +197,11 @@ void DSPCore_Shutdown()
 	core_state = DSPCORE_STOP;
 
 	if (dspjit) {
+		const u64 total = s_stats.cycles_run + s_stats.cycles_idle;
+		INFO_LOG(DSPLLE, "DSP JIT: %" PRIu64 " slices (%" PRIu64 " ended idle), %" PRIu64 " cycles run, "
+		         "%" PRIu64 " idle (%.1f%%)",
+		         s_stats.slices, s_stats.idle_slices, s_stats.cycles_run, s_stats.cycles_idle,
+		         total ? 100.0 * s_stats.cycles_idle / total : 0.0);
 		delete dspjit;
 		dspjit = nullptr;
 	}
@@ -279,12 +295,22 @@ int DSPCore_RunCycles(int cycles)
 		}
 
 		cyclesLeft = cycles;
+		cyclesIdle = 0;
 		DSPCompiledCode pExecAddr = (DSPCompiledCode)dspjit->enterDispatcher;
 		pExecAddr();
 
 		if (g_dsp.reset_dspjit_codespace)
 			dspjit->ClearIRAMandDSPJITCodespaceReset();
 
+		// The last block may overrun the slice, which wraps cyclesLeft.
+		const int left = (s16)cyclesLeft > 0 ? cyclesLeft : 0;
+		const int idle = std::min<int>(cyclesIdle + left, cycles);
+		s_stats.slices++;
+		if (cyclesIdle)
+			s_stats.idle_slices++;
+		s_stats.cycles_idle += idle;
+		s_stats.cycles_run += cycles - idle;
+
 		return cyclesLeft;
 	}
 
@@ -271,6 +271,8 @@ extern SDSP g_dsp;
 extern DSPBreakpoints dsp_breakpoints;
 extern DSPEmitter *dspjit;
 extern u16 cyclesLeft;
+// Cycles the JIT gave up in mail wait loops during the current slice.
+extern u32 cyclesIdle;
 extern bool init_hax;
 extern std::unique_ptr<DSPCaptureLogger> g_dsp_cap;
 
@@ -327,6 +329,17 @@ enum DSPCoreState
 
 int DSPCore_RunCycles(int cycles);
 
+// Where the JIT's slices went since DSPCore_Init. Only read while the DSP
+// isn't running.
+struct DSPCoreStats
+{
+	u64 slices;
+	u64 idle_slices;  // slices that ended in a mail wait loop
+	u64 cycles_run;
+	u64 cycles_idle;  // skipped in wait loops, or left over after a halt
+};
+DSPCoreStats DSPCore_GetStats();
+
 // These are meant to be called from the UI thread.
 void DSPCore_SetState(DSPCoreState new_state);
 DSPCoreState DSPCore_GetState();
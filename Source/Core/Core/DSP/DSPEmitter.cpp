@@ -12,7 +12,6 @@
 #include "Core/DSP/DSPMemoryMap.h"
 
 #define MAX_BLOCK_SIZE 250
-#define DSP_IDLE_SKIP_CYCLES 0x1000
 
 using namespace Gen;
 
@@ -264,14 +263,7 @@ void DSPEmitter::Compile(u16 start_addr)
 			DSPJitRegCache c(gpr);
 			HandleLoop();
 			gpr.saveRegs();
-			if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
-			{
-				MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
-			}
-			else
-			{
-				MOV(16, R(EAX), Imm16(blockSize[start_addr]));
-			}
+			WriteExitCycles();
 			JMP(returnDispatcher, true);
 			gpr.loadRegs(false);
 			gpr.flushRegs(c,false);
@@ -298,14 +290,7 @@ void DSPEmitter::Compile(u16 start_addr)
 				DSPJitRegCache c(gpr);
 				//don't update g_dsp.pc -- the branch insn already did
 				gpr.saveRegs();
-				if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
-				{
-					MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
-				}
-				else
-				{
-					MOV(16, R(EAX), Imm16(blockSize[start_addr]));
-				}
+				WriteExitCycles();
 				JMP(returnDispatcher, true);
 				gpr.loadRegs(false);
 				gpr.flushRegs(c,false);
@@ -324,6 +309,8 @@ void DSPEmitter::Compile(u16 start_addr)
 	if (fixup_pc)
 	{
 		MOV(16, M(&(g_dsp.pc)), Imm16(compilePC));
+		// The block ran into the start of another one.
+		WriteBlockLink(compilePC);
 	}
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
@@ -361,15 +348,51 @@ void DSPEmitter::Compile(u16 start_addr)
 	}
 
 	gpr.saveRegs();
-	if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
+	WriteExitCycles();
+	JMP(returnDispatcher, true);
+}
+
+void DSPEmitter::WriteBlockLink(u16 dest)
+{
+	// Idle loops have to get back to the dispatcher to give up the slice.
+	if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+		return;
+
+	if (blockLinks[dest] != nullptr)
 	{
-		MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
+		gpr.flushRegs();
+		// Check if we have enough cycles to execute the next block
+		MOV(16, R(ECX), M(&cyclesLeft));
+		CMP(16, R(ECX), Imm16(blockSize[startAddr] + blockSize[dest]));
+		FixupBranch notEnoughCycles = J_CC(CC_BE);
+
+		SUB(16, R(ECX), Imm16(blockSize[startAddr]));
+		MOV(16, M(&cyclesLeft), R(ECX));
+		JMP(blockLinks[dest], true);
+		SetJumpTarget(notEnoughCycles);
 	}
 	else
 	{
-		MOV(16, R(EAX), Imm16(blockSize[start_addr]));
+		// The destination has not been compiled yet.  Add it to the list
+		// of blocks that this block is waiting on.
+		unresolvedJumps[startAddr].push_back(dest);
+	}
+}
+
+void DSPEmitter::WriteExitCycles()
+{
+	// Mail wait loops poll a mailbox that only the CPU fills. After giving up
+	// the rest of the slice, new mail is seen at the start of the next one at
+	// the latest, which is always the case when the DSP runs in lockstep.
+	if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+	{
+		MOVZX(32, 16, EAX, M(&cyclesLeft));
+		ADD(32, M(&cyclesIdle), R(EAX));
+	}
+	else
+	{
+		MOV(16, R(EAX), Imm16(blockSize[startAddr]));
 	}
-	JMP(returnDispatcher, true);
 }
 
 const u8 *DSPEmitter::CompileStub()
@@ -35,6 +35,13 @@ public:
 	void Compile(u16 start_addr);
 	void ClearCallFlag();
 
+	// Jumps straight to the block at dest if it's compiled and there are
+	// enough cycles left, instead of returning to the dispatcher.
+	void WriteBlockLink(u16 dest);
+	// Loads the cycles used by the block into EAX before returning to the
+	// dispatcher. Mail wait loops give up the rest of the slice.
+	void WriteExitCycles();
+
 	bool FlagsNeeded();
 
 	void Default(UDSPInstruction inst);
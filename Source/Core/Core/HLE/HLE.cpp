@@ -6,6 +6,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/CoreTiming.h"
 #include "Core/Debugger/Debugger_SymbolMap.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/HLE_Misc.h"
@@ -115,7 +116,16 @@ void Execute(u32 _CurrentPC, u32 _Instruction)
 	unsigned int FunctionIndex = _Instruction & 0xFFFFF;
 	if ((FunctionIndex > 0) && (FunctionIndex < (sizeof(OSPatches) / sizeof(SPatch))))
 	{
-		OSPatches[FunctionIndex].PatchFunction();
+		if (CoreTiming::g_host_time_profiling)
+		{
+			const u64 start = CoreTiming::BeginHostTime();
+			OSPatches[FunctionIndex].PatchFunction();
+			CoreTiming::EndHLEHostTime(OSPatches[FunctionIndex].m_szPatchName, start);
+		}
+		else
+		{
+			OSPatches[FunctionIndex].PatchFunction();
+		}
 	}
 	else
 	{
@@ -11,6 +11,7 @@
 #include "Common/IniFile.h"
 #include "Common/StdMutex.h"
 #include "Common/StdThread.h"
+#include "Common/Timeline.h"
 #include "Common/Logging/LogManager.h"
 
 #include "Core/ConfigManager.h"
@@ -90,6 +91,7 @@ void DSPLLE::dsp_thread(DSPLLE *dsp_lle)
 		int cycles = (int)dsp_lle->m_cycle_count;
 		if (cycles > 0)
 		{
+			TIMELINE_ZONE("DSP LLE");
 			std::lock_guard<std::mutex> lk(dsp_lle->m_csDSPThreadActive);
 			if (dspjit)
 			{
@@ -17,6 +17,7 @@
 #include "Core/VolumeHandler.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/DVDInterface.h"
+#include "Core/HW/DVDThread.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/ProcessorInterface.h"
@@ -360,10 +361,13 @@ void Init()
 	dtk = CoreTiming::RegisterEvent("StreamingTimer", DTKStreamingCallback);
 
 	CoreTiming::ScheduleEvent(0, dtk);
+
+	DVDThread::Start();
 }
 
 void Shutdown()
 {
+	DVDThread::Stop();
 }
 
 void SetDiscInside(bool _DiscInside)
@@ -441,7 +445,7 @@ void ClearCoverInterrupt()
 
 bool DVDRead(u32 _iDVDOffset, u32 _iRamAddress, u32 _iLength)
 {
-	return VolumeHandler::ReadToPtr(Memory::GetPointer(_iRamAddress), _iDVDOffset, _iLength);
+	return DVDThread::Read(_iDVDOffset, _iLength, Memory::GetPointer(_iRamAddress));
 }
 
 void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
@@ -762,6 +766,12 @@ void ExecuteCommand()
 						return;
 					}
 
+					// Let the DVD thread read the data while the transfer is
+					// emulated; FinishExecuteRead picks it up. Wii discs are
+					// also read directly by the DI HLE device, so keep those
+					// reads on the CPU thread.
+					if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
+						DVDThread::StartRead(iDVDOffset, m_DILENGTH.Length);
 					CoreTiming::ScheduleEvent((int)ticksUntilTC, tc);
 
 					// Early return; we'll finish executing the command in FinishExecuteRead.
@@ -1085,7 +1095,7 @@ void FinishExecuteRead()
 {
 	u32 iDVDOffset = m_DICMDBUF[1].Hex << 2;
 
-	if (!DVDRead(iDVDOffset, m_DIMAR.Address, m_DILENGTH.Length))
+	if (!DVDThread::FinishRead(iDVDOffset, m_DILENGTH.Length, Memory::GetPointer(m_DIMAR.Address)))
 	{
 		PanicAlertT("Can't read from DVD_Plugin - DVD-Interface: Fatal Error");
 	}
@@ -0,0 +1,332 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/Thread.h"
+
+#include "Core/VolumeHandler.h"
+#include "Core/HW/DVDThread.h"
+
+namespace DVDThread
+{
+
+// The size of an ECC block on the disc, and a multiple of the block size of
+// every compressed format we read.
+static const u32 BLOCK_SIZE = 0x8000;
+// 32 MiB of decoded blocks.
+static const size_t CACHE_BLOCKS = 1024;
+// The drive buffers about 1 MiB past the end of a read; do the same.
+static const u32 READ_AHEAD_BLOCKS = 0x100000 / BLOCK_SIZE;
+
+struct CachedBlock
+{
+	std::vector<u8> data;
+	std::list<u64>::iterator lru_pos;
+};
+
+static std::thread s_thread;
+static std::mutex s_lock;
+static std::condition_variable s_request_cv;
+static std::condition_variable s_done_cv;
+
+// Everything below is guarded by s_lock.
+static bool s_quit;
+
+// The read queued by StartRead.
+static u32 s_request_id;
+static bool s_request_pending; // not yet picked up by the thread
+static bool s_request_valid;   // not yet collected by FinishRead
+static bool s_request_done;
+static bool s_request_result;
+static u64 s_request_offset;
+static u32 s_request_length;
+static std::vector<u8> s_request_data;
+
+static std::unordered_map<u64, CachedBlock> s_cache;
+static std::list<u64> s_lru; // most recently used first
+// Bumped by ClearCache so blocks read from an old volume are dropped.
+static u32 s_cache_generation;
+
+static u64 s_last_read_end;
+static Stats s_stats;
+
+static bool CopyFromCache(u64 block, u32 offset, u32 length, u8* out_ptr)
+{
+	auto it = s_cache.find(block);
+	if (it == s_cache.end())
+		return false;
+
+	s_lru.splice(s_lru.begin(), s_lru, it->second.lru_pos);
+	memcpy(out_ptr, it->second.data.data() + offset, length);
+	return true;
+}
+
+static void InsertBlock(u64 block, std::vector<u8>& data)
+{
+	if (s_cache.count(block))
+		return;
+
+	if (s_cache.size() >= CACHE_BLOCKS)
+	{
+		s_cache.erase(s_lru.back());
+		s_lru.pop_back();
+	}
+
+	s_lru.push_front(block);
+	CachedBlock& entry = s_cache[block];
+	entry.data.swap(data);
+	entry.lru_pos = s_lru.begin();
+}
+
+// Reads a whole block from the volume, without holding s_lock. Fails for the
+// partial block at the end of the volume, which is never cached.
+static bool FetchBlock(u64 block, std::vector<u8>& data)
+{
+	const u64 start = block * BLOCK_SIZE;
+	if (start + BLOCK_SIZE > VolumeHandler::GetSize())
+		return false;
+
+	data.resize(BLOCK_SIZE);
+	return VolumeHandler::ReadToPtr(data.data(), start, BLOCK_SIZE);
+}
+
+static bool ReadCached(u64 dvd_offset, u32 length, u8* out_ptr)
+{
+	// Memory-mapped images are already a copy from the page cache away, and
+	// the reader asks the OS to read ahead itself.
+	if (VolumeHandler::IsMemoryMapped())
+		return VolumeHandler::ReadToPtr(out_ptr, dvd_offset, length);
+
+	while (length > 0)
+	{
+		const u64 block = dvd_offset / BLOCK_SIZE;
+		const u32 offset_in_block = (u32)(dvd_offset % BLOCK_SIZE);
+		const u32 chunk = std::min(length, BLOCK_SIZE - offset_in_block);
+
+		bool hit;
+		u32 generation;
+		{
+			std::lock_guard<std::mutex> lk(s_lock);
+			hit = CopyFromCache(block, offset_in_block, chunk, out_ptr);
+			if (hit)
+				s_stats.hits++;
+			else
+				s_stats.misses++;
+			generation = s_cache_generation;
+		}
+
+		if (!hit)
+		{
+			std::vector<u8> data;
+			if (FetchBlock(block, data))
+			{
+				memcpy(out_ptr, data.data() + offset_in_block, chunk);
+
+				std::lock_guard<std::mutex> lk(s_lock);
+				if (generation == s_cache_generation)
+					InsertBlock(block, data);
+			}
+			else if (!VolumeHandler::ReadToPtr(out_ptr, dvd_offset, chunk))
+			{
+				return false;
+			}
+		}
+
+		dvd_offset += chunk;
+		out_ptr += chunk;
+		length -= chunk;
+	}
+
+	return true;
+}
+
+static void Prefetch(u64 block)
+{
+	u32 generation;
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		if (s_cache.count(block))
+			return;
+		generation = s_cache_generation;
+	}
+
+	std::vector<u8> data;
+	if (!FetchBlock(block, data))
+		return;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (generation == s_cache_generation)
+	{
+		InsertBlock(block, data);
+		s_stats.prefetched++;
+	}
+}
+
+static void DVDThreadFunc()
+{
+	Common::SetCurrentThreadName("DVD thread");
+
+	std::unique_lock<std::mutex> lk(s_lock);
+	while (true)
+	{
+		s_request_cv.wait(lk, [] { return s_quit || s_request_pending; });
+		if (s_quit)
+			break;
+
+		s_request_pending = false;
+		const u32 id = s_request_id;
+		const u64 offset = s_request_offset;
+		const u32 length = s_request_length;
+
+		lk.unlock();
+		std::vector<u8> data(length);
+		bool result = ReadCached(offset, length, data.data());
+		lk.lock();
+
+		if (s_request_valid && s_request_id == id)
+		{
+			s_request_data.swap(data);
+			s_request_result = result;
+			s_request_done = true;
+			s_done_cv.notify_all();
+		}
+
+		// Games mostly stream files front to back, so once a read continues
+		// the previous one, fetch what comes next until a new request arrives.
+		const bool sequential = offset + BLOCK_SIZE >= s_last_read_end && offset <= s_last_read_end + BLOCK_SIZE;
+		s_last_read_end = offset + length;
+		if (!sequential)
+			continue;
+
+		const u64 first_block = (offset + length) / BLOCK_SIZE;
+		for (u64 block = first_block; block < first_block + READ_AHEAD_BLOCKS; block++)
+		{
+			if (s_quit || s_request_pending)
+				break;
+
+			lk.unlock();
+			Prefetch(block);
+			lk.lock();
+		}
+	}
+}
+
+void Start()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_quit = false;
+	s_request_pending = false;
+	s_request_valid = false;
+	s_last_read_end = 0;
+	s_stats = Stats();
+	s_thread = std::thread(DVDThreadFunc);
+}
+
+void Stop()
+{
+	if (!s_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		s_quit = true;
+		s_request_cv.notify_one();
+	}
+	s_thread.join();
+
+	const u64 reads = s_stats.hits + s_stats.misses;
+	INFO_LOG(DVDINTERFACE, "DVD cache: %" PRIu64 " of %" PRIu64 " block reads hit (%.1f%%), %" PRIu64 " blocks read ahead, "
+	         "%" PRIu64 " stalls totalling %" PRIu64 " ms",
+	         s_stats.hits, reads, reads ? 100.0 * s_stats.hits / reads : 0.0, s_stats.prefetched,
+	         s_stats.stalls, s_stats.stall_us / 1000);
+
+	ClearCache();
+}
+
+void StartRead(u64 dvd_offset, u32 length)
+{
+	// Reading a mapped image on the thread would only add a copy.
+	if (!s_thread.joinable() || VolumeHandler::IsMemoryMapped())
+		return;
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_request_id++;
+	s_request_offset = dvd_offset;
+	s_request_length = length;
+	s_request_pending = true;
+	s_request_valid = true;
+	s_request_done = false;
+	s_request_cv.notify_one();
+}
+
+bool FinishRead(u64 dvd_offset, u32 length, u8* out_ptr)
+{
+	if (!out_ptr)
+		return false;
+
+	{
+		std::unique_lock<std::mutex> lk(s_lock);
+		if (s_request_valid && s_request_offset == dvd_offset && s_request_length == length)
+		{
+			if (!s_request_done)
+			{
+				// The emulated transfer time has passed but the host is still
+				// reading; this is the time the CPU thread loses.
+				auto start = std::chrono::high_resolution_clock::now();
+				s_done_cv.wait(lk, [] { return s_request_done || !s_request_valid; });
+				s_stats.stalls++;
+				s_stats.stall_us += std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::high_resolution_clock::now() - start).count();
+			}
+
+			if (s_request_done)
+			{
+				s_request_valid = false;
+				memcpy(out_ptr, s_request_data.data(), length);
+				return s_request_result;
+			}
+		}
+		s_request_valid = false;
+	}
+
+	return ReadCached(dvd_offset, length, out_ptr);
+}
+
+bool Read(u64 dvd_offset, u32 length, u8* out_ptr)
+{
+	if (!out_ptr)
+		return false;
+
+	return ReadCached(dvd_offset, length, out_ptr);
+}
+
+void ClearCache()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_cache.clear();
+	s_lru.clear();
+	s_cache_generation++;
+	// A queued read may have been served from the old volume.
+	s_request_valid = false;
+	s_done_cv.notify_all();
+}
+
+Stats GetStats()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	return s_stats;
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Services disc reads on a worker thread so that GCZ decompression and Wii
+// decryption don't run on the CPU thread. Reads go through a LRU cache of
+// decoded blocks, and sequential access patterns are read ahead.
+namespace DVDThread
+{
+
+struct Stats
+{
+	u64 hits;
+	u64 misses;
+	u64 prefetched;
+	u64 stalls;
+	u64 stall_us;
+};
+
+void Start();
+void Stop();
+
+// Queues a read that will be collected with FinishRead once the emulated
+// transfer time has passed. Only one read can be in flight.
+void StartRead(u64 dvd_offset, u32 length);
+// Waits for the read queued by StartRead and copies it to out_ptr. Falls back
+// to a synchronous read if no matching read is queued (e.g. after loading a
+// savestate).
+bool FinishRead(u64 dvd_offset, u32 length, u8* out_ptr);
+
+// Synchronous read through the block cache.
+bool Read(u64 dvd_offset, u32 length, u8* out_ptr);
+
+// Must be called when the volume changes.
+void ClearCache();
+
+Stats GetStats();
+
+}  // namespace
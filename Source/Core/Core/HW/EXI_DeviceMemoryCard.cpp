@@ -264,9 +264,6 @@ void CEXIMemoryCard::CmdDoneLater(u64 cycles)
 
 void CEXIMemoryCard::SetCS(int cs)
 {
-	// So that memory card won't be invalidated during flushing
-	memorycard->JoinThread();
-
 	if (cs)  // not-selected to selected
 	{
 		m_uPosition = 0;
@@ -555,7 +552,7 @@ void CEXIMemoryCard::DMAWrite(u32 _uAddr, u32 _uSize)
 		INFO_LOG(EXPANSIONINTERFACE, "writing to block: %x", address / BLOCK_SIZE);
 		// Page written to memory card, not just to buffer - let's schedule a flush 0.5b cycles into the future (1 sec)
 		// But first we unschedule already scheduled flushes - no point in flushing once per page for a large write
-		// Scheduling event is mainly for raw memory cards as the flush the whole 16MB to disk
+		// Scheduling event is mainly for raw memory cards, which write every changed block
 		// Flushing the gci folder is free in comparison
 		CoreTiming::RemoveEvent(et_this_card);
 		CoreTiming::ScheduleEvent(500000000, et_this_card, (u64)card_index);
@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common/ChunkFile.h"
 #include "Core/Core.h"
 #include "Core/HW/GCMemcard.h"
@@ -10,7 +12,34 @@
 #define SIZE_TO_Mb (1024 * 8 * 16)
 #define MC_HDR_SIZE 0xA000
 
-static void innerFlush(FlushData *data)
+// Writes the runs of consecutive blocks in either the system area (header,
+// directory and block allocation map) or the rest of the card.
+static u64 WriteBlocks(File::IOFile& pFile, const FlushData& data, bool system_area)
+{
+	u64 bytes = 0;
+	size_t i = 0;
+	while (i < data.blocks.size())
+	{
+		if ((data.blocks[i] < MC_FST_BLOCKS) != system_area)
+		{
+			i++;
+			continue;
+		}
+
+		size_t end = i + 1;
+		while (end < data.blocks.size() && data.blocks[end] == data.blocks[i] + (end - i) &&
+		       (data.blocks[end] < MC_FST_BLOCKS) == system_area)
+			end++;
+
+		pFile.Seek((s64)data.blocks[i] * BLOCK_SIZE, SEEK_SET);
+		pFile.WriteBytes(&data.content[i * BLOCK_SIZE], (end - i) * BLOCK_SIZE);
+		bytes += (end - i) * BLOCK_SIZE;
+		i = end;
+	}
+	return bytes;
+}
+
+static u64 innerFlush(FlushData *data)
 {
 	File::IOFile pFile(data->filename, "r+b");
 	if (!pFile)
@@ -29,22 +58,41 @@ static void innerFlush(FlushData *data)
 					"Are you receiving this after moving the emulator directory?\nIf so, then you may "
 					"need to re-specify your memory card location in the options.",
 					data->filename.c_str());
-		return;
+		return 0;
 	}
 
-	pFile.WriteBytes(data->memcardContent, data->memcardSize);
+	// Games write a save's blocks before the directory and allocation map
+	// that point to them, and the two copies of those are updated one after
+	// the other. Keep that order on disk, so that if we're interrupted the
+	// card still has a valid directory pointing to complete saves.
+	u64 bytes = WriteBlocks(pFile, *data, false);
+	if (bytes)
+		pFile.Sync();
+	bytes += WriteBlocks(pFile, *data, true);
+	pFile.Sync();
+
+	if (!pFile.IsGood())
+		ERROR_LOG(EXPANSIONINTERFACE, "Error writing memory card %s", data->filename.c_str());
+
+	INFO_LOG(EXPANSIONINTERFACE, "Memory card %c: wrote %u of %u blocks to %s", data->memcardIndex ? 'B' : 'A',
+	         (u32)data->blocks.size(), (u32)(data->memcardSize / BLOCK_SIZE), data->filename.c_str());
 
 	if (!data->bExiting)
 		Core::DisplayMessage(StringFromFormat("Wrote memory card %c contents to %s", data->memcardIndex ? 'B' : 'A',
 											  data->filename.c_str()).c_str(),
 							 4000);
-	return;
+	return bytes;
 }
 
 MemoryCard::MemoryCard(std::string filename, int _card_index, u16 sizeMb)
 	: MemoryCardBase(_card_index, sizeMb)
 	, m_bDirty(false)
+	, m_rewrite_all(false)
 	, m_strFilename(filename)
+	, flushPending(false)
+	, flushStop(false)
+	, m_bytes_written(0)
+	, m_flushes(0)
 {
 	File::IOFile pFile(m_strFilename, "rb");
 	if (pFile)
@@ -69,23 +117,70 @@ MemoryCard::MemoryCard(std::string filename, int _card_index, u16 sizeMb)
 		memset(memory_card_content + MC_HDR_SIZE, 0xFF, memory_card_size - MC_HDR_SIZE);
 
 		WARN_LOG(EXPANSIONINTERFACE, "No memory card found. Will create a new one.");
+		m_rewrite_all = true;
 	}
+
+	m_dirty_blocks.assign(memory_card_size / BLOCK_SIZE, 0);
+	flushThread = std::thread(&MemoryCard::FlushThread, this);
 }
 
 MemoryCard::~MemoryCard()
 {
 	Flush(true);
+
+	{
+		std::lock_guard<std::mutex> lk(flushLock);
+		flushStop = true;
+		flushWake.notify_one();
+	}
+	flushThread.join();
+
+	if (m_flushes)
+		INFO_LOG(EXPANSIONINTERFACE, "Memory card %c: wrote %u KiB in %u flushes", card_index ? 'B' : 'A',
+		         (u32)(m_bytes_written / 1024), m_flushes);
+
 	delete[] memory_card_content;
 }
 
-void MemoryCard::JoinThread()
+void MemoryCard::FlushThread()
 {
-	if (flushThread.joinable())
+	Common::SetCurrentThreadName(card_index ? "Memcard B flush" : "Memcard A flush");
+
+	std::unique_lock<std::mutex> lk(flushLock);
+	while (true)
 	{
-		flushThread.join();
+		flushWake.wait(lk, [this] { return flushPending || flushStop; });
+		if (!flushPending)
+			break;
+
+		lk.unlock();
+		const u64 bytes = innerFlush(&flushData);
+		lk.lock();
+
+		m_bytes_written += bytes;
+		m_flushes++;
+		flushPending = false;
+		flushDone.notify_all();
 	}
 }
 
+void MemoryCard::JoinThread()
+{
+	std::unique_lock<std::mutex> lk(flushLock);
+	flushDone.wait(lk, [this] { return !flushPending; });
+}
+
+void MemoryCard::SetDirty(u32 address, u32 length)
+{
+	m_bDirty = true;
+	if (length == 0)
+		return;
+
+	const u32 last = std::min<u32>((address + length - 1) / BLOCK_SIZE, (u32)m_dirty_blocks.size() - 1);
+	for (u32 block = address / BLOCK_SIZE; block <= last; block++)
+		m_dirty_blocks[block] = 1;
+}
+
 // Flush memory card contents to disc
 void MemoryCard::Flush(bool exiting)
 {
@@ -95,23 +190,39 @@ void MemoryCard::Flush(bool exiting)
 	if (!Core::g_CoreStartupParameter.bEnableMemcardSaving)
 		return;
 
-	if (flushThread.joinable())
-	{
-		flushThread.join();
-	}
-
 	if (!exiting)
 		Core::DisplayMessage(StringFromFormat("Writing to memory card %c", card_index ? 'B' : 'A'), 1000);
 
+	std::unique_lock<std::mutex> lk(flushLock);
+	flushDone.wait(lk, [this] { return !flushPending; });
+
+	if (m_rewrite_all || !File::Exists(m_strFilename))
+	{
+		std::fill(m_dirty_blocks.begin(), m_dirty_blocks.end(), 1);
+		m_rewrite_all = false;
+	}
+
 	flushData.filename = m_strFilename;
-	flushData.memcardContent = memory_card_content;
 	flushData.memcardIndex = card_index;
 	flushData.memcardSize = memory_card_size;
 	flushData.bExiting = exiting;
+	flushData.blocks.clear();
+	flushData.content.clear();
+	for (u32 block = 0; block < m_dirty_blocks.size(); block++)
+	{
+		if (!m_dirty_blocks[block])
+			continue;
+
+		m_dirty_blocks[block] = 0;
+		flushData.blocks.push_back((u16)block);
+		const u8* data = memory_card_content + block * BLOCK_SIZE;
+		flushData.content.insert(flushData.content.end(), data, data + BLOCK_SIZE);
+	}
 
-	flushThread = std::thread(innerFlush, &flushData);
+	flushPending = true;
+	flushWake.notify_one();
 	if (exiting)
-		flushThread.join();
+		flushDone.wait(lk, [this] { return !flushPending; });
 
 	m_bDirty = false;
 }
@@ -141,7 +252,7 @@ s32 MemoryCard::Write(u32 destaddress, s32 length, u8 *srcaddress)
 		return -1;
 	}
 
-	m_bDirty = true;
+	SetDirty(destaddress, length);
 	memcpy(&(memory_card_content[destaddress]), srcaddress, length);
 	return length;
 }
@@ -152,14 +263,14 @@ void MemoryCard::ClearBlock(u32 address)
 		PanicAlertT("MemoryCard: ClearBlock called on invalid address %x", address);
 	else
 	{
-		m_bDirty = true;
+		SetDirty(address, BLOCK_SIZE);
 		memset(memory_card_content + address, 0xFF, BLOCK_SIZE);
 	}
 }
 
 void MemoryCard::ClearAll()
 {
-	m_bDirty = true;
+	SetDirty(0, memory_card_size);
 	memset(memory_card_content, 0xFF, memory_card_size);
 }
 
@@ -168,4 +279,11 @@ void MemoryCard::DoState(PointerWrap &p)
 	p.Do(card_index);
 	p.Do(memory_card_size);
 	p.DoArray(memory_card_content, memory_card_size);
+
+	// Whatever is written next, the rest of the file is from before the state
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		m_dirty_blocks.assign(memory_card_size / BLOCK_SIZE, 0);
+		m_rewrite_all = true;
+	}
 }
@@ -4,18 +4,24 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "Common/Thread.h"
 #include "Core/HW/GCMemcard.h"
 
 class PointerWrap;
 
-// Data structure to be passed to the flushing thread.
+// Data structure to be passed to the flushing thread: copies of the blocks
+// that changed since the last flush, so the card can keep being written while
+// they go to disk.
 struct FlushData
 {
 	bool bExiting;
 	std::string filename;
-	u8 *memcardContent;
 	int memcardSize, memcardIndex;
+	std::vector<u16> blocks;
+	std::vector<u8> content; // BLOCK_SIZE bytes for each of blocks
 };
 
 class MemoryCard : public MemoryCardBase
@@ -33,10 +39,26 @@ public:
 	void JoinThread() override;
 
 private:
+	void FlushThread();
+	void SetDirty(u32 address, u32 length);
+
 	u8 *memory_card_content;
 	bool m_bDirty;
+	// One flag for each BLOCK_SIZE block of the card
+	std::vector<u8> m_dirty_blocks;
+	// The file doesn't match the card, write all of it next time
+	bool m_rewrite_all;
 	std::string m_strFilename;
 
+	// Owned by the flush thread while flushPending is set
 	FlushData flushData;
+	bool flushPending;
+	bool flushStop;
+	std::mutex flushLock;
+	std::condition_variable flushWake;
+	std::condition_variable flushDone;
 	std::thread flushThread;
+
+	u64 m_bytes_written;
+	u32 m_flushes;
 };
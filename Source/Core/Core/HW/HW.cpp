@@ -8,6 +8,7 @@
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/CPU.h"
@@ -34,6 +35,7 @@ namespace HW
 		SystemTimers::PreInit();
 
 		State::Init();
+		Rewind::Init();
 
 		// Init the whole Hardware
 		AudioInterface::Init();
@@ -72,6 +74,7 @@ namespace HW
 			WII_IPC_HLE_Interface::Shutdown();
 		}
 
+		Rewind::Shutdown();
 		State::Shutdown();
 		CoreTiming::Shutdown();
 	}
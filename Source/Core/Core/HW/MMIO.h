@@ -11,6 +11,15 @@
 #include "Common/Common.h"
 #include "Core/HW/MMIOHandlers.h"
 
+// Declared in CoreTiming.h, which this header shouldn't pull into every file
+// that accesses MMIO.
+namespace CoreTiming
+{
+extern bool g_host_time_profiling;
+u64 BeginHostTime();
+void EndMMIOHostTime(u32 address, bool write, u64 start);
+}
+
 namespace MMIO
 {
 
@@ -103,12 +112,26 @@ public:
 	template<typename Unit>
 	Unit Read(u32 addr)
 	{
+		if (CoreTiming::g_host_time_profiling)
+		{
+			const u64 start = CoreTiming::BeginHostTime();
+			const Unit val = GetHandlerForRead<Unit>(addr).Read(addr);
+			CoreTiming::EndMMIOHostTime(addr, false, start);
+			return val;
+		}
 		return GetHandlerForRead<Unit>(addr).Read(addr);
 	}
 
 	template<typename Unit>
 	void Write(u32 addr, Unit val)
 	{
+		if (CoreTiming::g_host_time_profiling)
+		{
+			const u64 start = CoreTiming::BeginHostTime();
+			GetHandlerForWrite<Unit>(addr).Write(addr, val);
+			CoreTiming::EndMMIOHostTime(addr, true, start);
+			return;
+		}
 		GetHandlerForWrite<Unit>(addr).Write(addr, val);
 	}
 
@@ -17,6 +17,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/DSP/DSPCore.h"
 #include "Core/HW/DVDInterface.h"
@@ -152,6 +153,8 @@ void FrameUpdate()
 	if (g_framesToSkip)
 		FrameSkipping();
 
+	Rewind::FrameUpdate(g_currentFrame);
+
 	g_bPolled = false;
 }
 
@@ -2,7 +2,9 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <climits>
 
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
@@ -30,22 +32,32 @@ void RegCache::Start()
 		regs[i].away = false;
 		regs[i].locked = false;
 	}
+}
 
-	// todo: sort to find the most popular regs
-	/*
-	int maxPreload = 2;
-	for (int i = 0; i < 32; i++)
+void RegCache::Preload(const PPCAnalyst::BlockRegStats& stats, u32 regsInUse)
+{
+	// Every register held across the block has to be saved around calls to
+	// C code, so only take the few that are read most.
+#if _M_X86_64
+	const size_t maxPreload = 4;
+#else
+	const size_t maxPreload = 2;
+#endif
+	std::vector<size_t> candidates;
+	for (size_t i = 0; i < regs.size(); i++)
 	{
-		if (stats.numReads[i] > 2 || stats.numWrites[i] >= 2)
-		{
-			LoadToX64(i, true, false); //stats.firstRead[i] <= stats.firstWrite[i], false);
-			maxPreload--;
-			if (!maxPreload)
-				break;
-		}
-	}*/
-	//Find top regs - preload them (load bursts ain't bad)
-	//But only preload IF written OR reads >= 3
+		// Only registers whose incoming value is read, at least three times
+		if ((regsInUse & (1 << i)) && stats.numReads[i] >= 3)
+			candidates.push_back(i);
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) {
+		return stats.numReads[a] > stats.numReads[b];
+	});
+	if (candidates.size() > maxPreload)
+		candidates.resize(maxPreload);
+
+	for (size_t preg : candidates)
+		BindToRegister(preg, true, false);
 }
 
 // these are powerpc reg indices
@@ -95,19 +107,30 @@ X64Reg RegCache::GetFreeXReg()
 	}
 	//Okay, not found :( Force grab one
 
-	//TODO - add a pass to grab xregs whose ppcreg is not used in the next 3 instructions
+	// Evict the register whose guest value is needed furthest in the future;
+	// ones the rest of the block doesn't read go first.
+	X64Reg victim = INVALID_REG;
+	int victimDistance = -1;
 	for (size_t i = 0; i < aCount; i++)
 	{
 		X64Reg xr = (X64Reg)aOrder[i];
 		if (xregs[xr].locked)
 			continue;
 		size_t preg = xregs[xr].ppcReg;
-		if (!regs[preg].locked)
+		if (regs[preg].locked)
+			continue;
+		int distance = NextUse(preg);
+		if (distance > victimDistance)
 		{
-			StoreFromRegister(preg);
-			return xr;
+			victim = xr;
+			victimDistance = distance;
 		}
 	}
+	if (victim != INVALID_REG)
+	{
+		StoreFromRegister(xregs[victim].ppcReg);
+		return victim;
+	}
 	//Still no dice? Die!
 	_assert_msg_(DYNA_REC, 0, "Regcache ran out of regs");
 	return INVALID_REG;
@@ -186,6 +209,20 @@ const int* GPRRegCache::GetAllocationOrder(size_t& count)
 	return allocationOrder;
 }
 
+int GPRRegCache::NextUse(size_t preg) const
+{
+	const PPCAnalyst::CodeOp* op = jit->js.op;
+	for (int distance = 0; op->gprInUse & (1 << preg); op++, distance++)
+	{
+		for (s8 reg : op->regsIn)
+		{
+			if (reg == (s8)preg)
+				return distance;
+		}
+	}
+	return INT_MAX;
+}
+
 const int* FPURegCache::GetAllocationOrder(size_t& count)
 {
 	static const int allocationOrder[] =
@@ -47,6 +47,10 @@ protected:
 
 	virtual const int *GetAllocationOrder(size_t& count) = 0;
 
+	// Instructions until the guest register is next read, INT_MAX if the
+	// block doesn't read its current value again
+	virtual int NextUse(size_t preg) const { return 0; }
+
 	Gen::XEmitter *emit;
 
 public:
@@ -54,6 +58,9 @@ public:
 
 	virtual ~RegCache() {}
 	void Start();
+	// Loads the block's most read registers up front, using the analyst's
+	// register statistics and liveness
+	void Preload(const PPCAnalyst::BlockRegStats& stats, u32 regsInUse);
 
 	void DiscardRegContentsIfCached(size_t preg);
 	void SetEmitter(Gen::XEmitter *emitter) {emit = emitter;}
@@ -118,6 +125,7 @@ public:
 	void LoadRegister(size_t preg, Gen::X64Reg newLoc) override;
 	Gen::OpArg GetDefaultLocation(size_t reg) const override;
 	const int* GetAllocationOrder(size_t& count) override;
+	int NextUse(size_t preg) const override;
 	void SetImmediate32(size_t preg, u32 immValue);
 };
 
@@ -7,6 +7,7 @@
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 
+#include "Core/CoreTiming.h"
 #include "Core/HW/MMIO.h"
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
@@ -322,13 +323,16 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 			//    access the RAM buffer and load from there).
 			// 2. If the address is in the MMIO range, find the appropriate
 			//    MMIO handler and generate the code to load using the handler.
+			//    Not while profiling host time, which only counts accesses
+			//    that go through MMIO::Mapping::Read.
 			// 3. Otherwise, just generate a call to Memory::Read_* with the
 			//    address hardcoded.
 			if ((address & mem_mask) == 0)
 			{
 				UnsafeLoadToReg(reg_value, opAddress, accessSize, offset, signExtend);
 			}
-			else if (!Core::g_CoreStartupParameter.bMMU && MMIO::IsMMIOAddress(address) && accessSize != 64)
+			else if (!Core::g_CoreStartupParameter.bMMU && MMIO::IsMMIOAddress(address) && accessSize != 64 &&
+			         !CoreTiming::g_host_time_profiling)
 			{
 				MMIOLoadToReg(Memory::mmio_mapping, reg_value, registersInUse,
 				              address, accessSize, signExtend);
@@ -4,12 +4,15 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <map>
 #include <string>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+#include "Common/StringUtil.h"
+
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitInterface.h"
@@ -171,6 +174,97 @@ namespace JitInterface
 		}
 		#endif
 	}
+	// Whether any block has measured ticks, which the JIT only records on
+	// Windows. A profile uses one unit for all of its blocks: ticks if there
+	// are any, otherwise executed guest instructions.
+	static bool HasBlockTicks()
+	{
+	#ifdef _WIN32
+		for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
+		{
+			if (jit->GetBlockCache()->GetBlock(i)->ticCounter)
+				return true;
+		}
+	#endif
+		return false;
+	}
+
+	static u64 GetBlockCost(const JitBlock *block, bool use_ticks)
+	{
+	#ifdef _WIN32
+		if (use_ticks)
+			return block->ticCounter;
+	#endif
+		return (u64)block->originalSize * block->runCount;
+	}
+
+	static std::string GetBlockFunctionName(u32 address)
+	{
+		Symbol *symbol = g_symbolDB.GetSymbolFromAddr(address);
+		if (symbol && !symbol->name.empty())
+			return symbol->name;
+		return StringFromFormat("zz_%08x", address);
+	}
+
+	void WritePerfMap(const std::string& filename)
+	{
+		#if _M_X86
+		File::IOFile f(filename, "w");
+		if (!f)
+		{
+			PanicAlert("Failed to open %s", filename.c_str());
+			return;
+		}
+		for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
+		{
+			const JitBlock *block = jit->GetBlockCache()->GetBlock(i);
+			if (block->invalid || !block->checkedEntry)
+				continue;
+			// perf expects "START SIZE symbolname" in hex, covering the
+			// host code from the checked entry to the end of the block.
+			u64 start = (u64)block->checkedEntry;
+			u64 size = (u64)(block->normalEntry + block->codeSize - block->checkedEntry);
+			fprintf(f.GetHandle(), "%" PRIx64 " %" PRIx64 " ppc:%s@%08x\n",
+					start, size, GetBlockFunctionName(block->originalAddress).c_str(),
+					block->originalAddress);
+		}
+		#endif
+	}
+
+	void WriteCollapsedProfile(const std::string& filename)
+	{
+		#if _M_X86
+		// function name -> (block address -> cost), so every guest function
+		// is emitted as one contiguous group of frames.
+		std::map<std::string, std::map<u32, u64>> functions;
+		bool use_ticks = HasBlockTicks();
+		for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
+		{
+			const JitBlock *block = jit->GetBlockCache()->GetBlock(i);
+			if (block->runCount < 1)
+				continue;
+			u64 cost = GetBlockCost(block, use_ticks);
+			if (cost)
+				functions[GetBlockFunctionName(block->originalAddress)][block->originalAddress] += cost;
+		}
+
+		File::IOFile f(filename, "w");
+		if (!f)
+		{
+			PanicAlert("Failed to open %s", filename.c_str());
+			return;
+		}
+		for (const auto& function : functions)
+		{
+			for (const auto& block : function.second)
+			{
+				fprintf(f.GetHandle(), "%s;blk_%08x %" PRIu64 "\n",
+						function.first.c_str(), block.first, block.second);
+			}
+		}
+		#endif
+	}
+
 	bool IsInCodeSpace(u8 *ptr)
 	{
 		return jit->IsInCodeSpace(ptr);
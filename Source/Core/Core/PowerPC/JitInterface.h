@@ -18,6 +18,8 @@ namespace JitInterface
 
 	// Debugging
 	void WriteProfileResults(const std::string& filename);
+	void WritePerfMap(const std::string& filename);
+	void WriteCollapsedProfile(const std::string& filename);
 
 	// Memory Utilities
 	bool IsInCodeSpace(u8 *ptr);
@@ -730,6 +730,24 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 		code[i].wantsPS1 = wantsPS1;
 	}
 	block->m_num_instructions = num_inst;
+
+	// Scan for GPR liveness, which the register cache uses to decide what to
+	// keep in host registers
+	u32 gprInUse = 0;
+	for (int i = num_inst - 1; i >= 0; i--)
+	{
+		for (s8 reg : code[i].regsOut)
+		{
+			if (reg >= 0)
+				gprInUse &= ~(1 << reg);
+		}
+		for (s8 reg : code[i].regsIn)
+		{
+			if (reg >= 0)
+				gprInUse |= 1 << reg;
+		}
+		code[i].gprInUse = gprInUse;
+	}
 	return address;
 }
 
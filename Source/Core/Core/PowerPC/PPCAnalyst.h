@@ -38,6 +38,8 @@ struct CodeOp //16B
 	bool outputCR1;
 	bool outputPS1;
 	bool skip;  // followed BL-s for example
+	// GPRs whose current value this or a later instruction in the block reads
+	u32 gprInUse;
 };
 
 struct BlockStats
@@ -3,6 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <string>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "Common/StringUtil.h"
+
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/Profiler.h"
 
@@ -16,4 +23,21 @@ void WriteProfileResults(const std::string& filename)
 	JitInterface::WriteProfileResults(filename);
 }
 
+void WritePerfMap(const std::string& filename)
+{
+	if (!filename.empty())
+	{
+		JitInterface::WritePerfMap(filename);
+		return;
+	}
+#ifndef _WIN32
+	JitInterface::WritePerfMap(StringFromFormat("/tmp/perf-%d.map", getpid()));
+#endif
+}
+
+void WriteCollapsedProfile(const std::string& filename)
+{
+	JitInterface::WriteCollapsedProfile(filename);
+}
+
 }  // namespace
@@ -60,4 +60,15 @@ namespace Profiler
 extern bool g_ProfileBlocks;
 
 void WriteProfileResults(const std::string& filename);
+
+// Writes a perf-compatible map of the JIT code cache so that `perf report`
+// can symbolize samples taken in generated code. With an empty filename the
+// map goes to /tmp/perf-<pid>.map, where perf looks for it.
+void WritePerfMap(const std::string& filename = "");
+
+// Writes per-block cost grouped by guest function in collapsed-stack format
+// ("function;block cost"), readable by flamegraph.pl and speedscope. The cost
+// is in timer ticks where the JIT measures them, otherwise in executed guest
+// instructions; one file never mixes the two.
+void WriteCollapsedProfile(const std::string& filename);
 }
@@ -0,0 +1,259 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <deque>
+
+#include "Common/Common.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Movie.h"
+#include "Core/Rewind.h"
+#include "Core/State.h"
+
+namespace Rewind
+{
+
+struct Entry
+{
+	u64 frame;
+	// Delta that turns the next newer capture back into this one.
+	std::vector<u8> delta;
+};
+
+static int s_capture_event;
+
+// History, oldest first. The newest capture is s_latest.
+static std::deque<Entry> s_history;
+static std::vector<u8> s_latest;
+static u64 s_latest_frame;
+static size_t s_history_bytes;
+static std::mutex s_history_lock;
+
+// Capture handed from the CPU thread to the worker. Once packed it holds
+// the previous newest capture, so the next capture writes to memory that
+// is already allocated and faulted in.
+static std::vector<u8> s_pending;
+static u64 s_pending_frame;
+static Common::Flag s_pending_busy;
+static Common::Event s_pending_event;
+
+static std::thread s_worker;
+static Common::Flag s_worker_quit;
+
+static u32 s_captures;
+static u32 s_skipped;
+
+static size_t GetMemoryLimit()
+{
+	return (size_t)SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindMemoryMB * 1024 * 1024;
+}
+
+// Must be called with s_history_lock held, and not while a capture is
+// being written to s_pending.
+static size_t GetMemoryUsed()
+{
+	return s_history_bytes + s_latest.size() + s_pending.capacity();
+}
+
+// Must be called with s_history_lock held, and not while a capture is
+// being written to s_pending.
+static void TrimHistory()
+{
+	while (!s_history.empty() && GetMemoryUsed() > GetMemoryLimit())
+	{
+		s_history_bytes -= s_history.front().delta.size();
+		s_history.pop_front();
+	}
+}
+
+static void WorkerThread()
+{
+	Common::SetCurrentThreadName("Rewind thread");
+
+	while (true)
+	{
+		s_pending_event.Wait();
+		if (s_worker_quit.IsSet())
+			break;
+
+		u32 start = Common::Timer::GetTimeMs();
+		{
+			std::lock_guard<std::mutex> lk(s_history_lock);
+			if (!s_latest.empty())
+			{
+				Entry entry;
+				entry.frame = s_latest_frame;
+				State::PackDelta(s_pending, s_latest, entry.delta);
+				s_history_bytes += entry.delta.size();
+				s_history.push_back(std::move(entry));
+			}
+			s_latest.swap(s_pending);
+			s_latest_frame = s_pending_frame;
+			TrimHistory();
+
+			DEBUG_LOG(COMMON, "Rewind: captured frame %u in %u ms, %u entries, %u KB",
+			          (u32)s_latest_frame, Common::Timer::GetTimeMs() - start, (u32)s_history.size(),
+			          (u32)(GetMemoryUsed() / 1024));
+		}
+		s_pending_busy.Clear();
+	}
+}
+
+// Runs on the CPU thread, between instructions.
+static void CaptureCallback(u64 userdata, int cyclesLate)
+{
+	// Never block emulation on the worker: if it's still packing the
+	// previous capture, skip this one.
+	if (!s_pending_busy.TestAndSet())
+	{
+		s_skipped++;
+		return;
+	}
+
+	// Only the raw savestate copy is done here; delta encoding and
+	// compression happen on the worker so emulation is not held up. The
+	// memory arrays, which are most of the copy, are spread over the
+	// savestate workers, into a buffer that is reused from capture to
+	// capture.
+	State::SaveToBuffer(s_pending);
+	// Not the frame FrameUpdate passed: a state may have been loaded since
+	s_pending_frame = Movie::g_currentFrame;
+	s_captures++;
+	s_pending_event.Set();
+}
+
+void Init()
+{
+	s_capture_event = CoreTiming::RegisterEvent("RewindCapture", CaptureCallback);
+
+	if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bRewind)
+		return;
+
+	s_captures = 0;
+	s_skipped = 0;
+	s_worker_quit.Clear();
+	s_pending_busy.Clear();
+	s_worker = std::thread(WorkerThread);
+}
+
+void Shutdown()
+{
+	if (s_worker.joinable())
+	{
+		s_worker_quit.Set();
+		s_pending_event.Set();
+		s_worker.join();
+
+		NOTICE_LOG(COMMON, "Rewind: %u captures, %u skipped while the previous capture was still packing",
+		           s_captures, s_skipped);
+	}
+
+	Clear();
+	std::vector<u8>().swap(s_pending);
+}
+
+void FrameUpdate(u64 frame)
+{
+	if (!s_worker.joinable())
+		return;
+
+	const u32 interval = std::max(SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval, 1);
+	if (frame % interval)
+		return;
+
+	CoreTiming::ScheduleEvent_Threadsafe(0, s_capture_event, frame);
+}
+
+void Clear()
+{
+	// Let the worker finish a capture it may be packing, or it would land
+	// in the fresh history.
+	while (s_worker.joinable() && s_pending_busy.IsSet())
+		Common::YieldCPU();
+
+	std::lock_guard<std::mutex> lk(s_history_lock);
+	s_history.clear();
+	std::vector<u8>().swap(s_latest);
+	s_history_bytes = 0;
+}
+
+std::vector<u64> GetCapturedFrames()
+{
+	std::lock_guard<std::mutex> lk(s_history_lock);
+	std::vector<u64> frames;
+	for (const Entry& entry : s_history)
+		frames.push_back(entry.frame);
+	if (!s_latest.empty())
+		frames.push_back(s_latest_frame);
+	return frames;
+}
+
+bool JumpTo(u64 frame)
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+
+	// The CPU is paused, so no new capture can start; wait for the worker
+	// to finish the one it may be packing.
+	while (s_pending_busy.IsSet())
+		Common::YieldCPU();
+
+	std::vector<u8> state;
+	{
+		std::lock_guard<std::mutex> lk(s_history_lock);
+
+		size_t index = s_history.size();
+		if (s_latest.empty() || s_latest_frame != frame)
+		{
+			while (index > 0 && s_history[index - 1].frame != frame)
+				index--;
+			if (index == 0)
+			{
+				Core::PauseAndLock(false, wasUnpaused);
+				return false;
+			}
+			index--;
+		}
+
+		// Walk back from the newest capture, undoing one delta at a time.
+		state = s_latest;
+		for (size_t i = s_history.size(); i > index; i--)
+		{
+			std::vector<u8> older;
+			if (!State::UnpackDelta(state, s_history[i - 1].delta, older))
+			{
+				PanicAlert("Rewind history is corrupt at frame %u", (u32)s_history[i - 1].frame);
+				Core::PauseAndLock(false, wasUnpaused);
+				return false;
+			}
+			state.swap(older);
+		}
+
+		// The restored capture becomes the newest one.
+		while (s_history.size() > index)
+		{
+			s_history_bytes -= s_history.back().delta.size();
+			s_history.pop_back();
+		}
+		s_latest = state;
+		s_latest_frame = frame;
+	}
+
+	State::LoadFromBuffer(state);
+	Core::DisplayMessage(StringFromFormat("Rewound to frame %u", (u32)frame), 2000);
+
+	Core::PauseAndLock(false, wasUnpaused);
+	return true;
+}
+
+}
@@ -0,0 +1,38 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// In-memory rewind history built on savestates.
+//
+// Every N frames a savestate is captured into memory. The newest capture is
+// kept whole; each older capture is stored as a compressed delta against the
+// capture that followed it, so dropping the oldest entries to stay under the
+// memory cap never invalidates the rest of the history.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Rewind
+{
+
+void Init();
+void Shutdown();
+
+// Called by Movie for every emulated frame.
+void FrameUpdate(u64 frame);
+
+// Drop all captured states. State calls this when a state is loaded, since
+// the history no longer leads up to the emulation.
+void Clear();
+
+// Frame numbers of all captures, oldest first.
+std::vector<u64> GetCapturedFrames();
+
+// Restore the state captured at the given frame. Captures newer than it are
+// discarded. Returns false if no capture of that frame is in the history.
+bool JumpTo(u64 frame);
+
+}
@@ -2,10 +2,17 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <lzo/lzo1x.h>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/Event.h"
+#include "Common/Flag.h"
+#include "Common/Hash.h"
+#include "Common/StdConditionVariable.h"
 #include "Common/StdMutex.h"
 #include "Common/StdThread.h"
 #include "Common/StringUtil.h"
@@ -15,6 +22,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/Movie.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/CPU.h"
 #include "Core/HW/DSP.h"
@@ -40,12 +48,20 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
+// Savestate sections (the data between two PointerWrap markers) start on
+// this boundary, so the big memory arrays are page-aligned in the stream and
+// in uncompressed state files.
+static const u32 SECTION_ALIGNMENT = 4096;
 
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+// Arrays this big are copied in and out of the stream by all the workers,
+// in pieces of PARALLEL_COPY_PIECE bytes. Only RAM, EXRAM, ARAM and the
+// like qualify.
+static const u32 PARALLEL_COPY_MIN = 1024 * 1024;
+static const u32 PARALLEL_COPY_PIECE = 256 * 1024;
 
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// Granularity of delta states. Matches the host page size so that the
+// memory regions, which dominate the state, line up with delta pages.
+static const u32 DELTA_PAGE_SIZE = 4096;
 
 static std::string g_last_filename;
 
@@ -54,6 +70,12 @@ static CallbackFunc g_onAfterLoadCb = nullptr;
 // Temporary undo state buffer
 static std::vector<u8> g_undo_load_buffer;
 static std::vector<u8> g_current_buffer;
+static std::vector<PointerWrap::Section> g_current_sections;
+// The base of delta saves, kept so each save is only compared against it.
+// Only used by the save thread.
+static std::vector<u8> g_delta_base;
+static std::string g_delta_base_name;
+static u32 g_delta_base_checksum;
 static int g_loadDepth = 0;
 
 static std::mutex g_cs_undo_load_buffer;
@@ -62,8 +84,23 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+// Workers for ForEachChunkParallel. They live as long as the emulation, so
+// the several passes of a save or load don't each start a set of threads.
+static std::vector<std::thread> g_chunk_workers;
+// Held by the thread running a parallel job; one job at a time
+static std::mutex g_chunk_job_lock;
+static std::mutex g_chunk_worker_lock;
+static std::condition_variable g_chunk_worker_wake;
+static std::condition_variable g_chunk_job_done;
+static const std::function<void(size_t)>* g_chunk_job;
+static size_t g_chunk_job_size;
+static std::atomic<size_t> g_chunk_job_next;
+static size_t g_chunk_workers_busy;
+static u32 g_chunk_job_id;
+static bool g_chunk_workers_quit;
+
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 30;
+static const u32 STATE_VERSION = 31;
 
 enum
 {
@@ -79,8 +116,16 @@ void EnableCompression(bool compression)
 	g_use_compression = compression;
 }
 
-static void DoState(PointerWrap &p)
+static void ParallelCopy(void* dest, const void* src, size_t size);
+
+static void DoState(PointerWrap &p, std::vector<PointerWrap::Section>* sections = nullptr)
 {
+	// Section padding is part of the stream, so the table is attached in
+	// every mode even if nobody looks at it.
+	std::vector<PointerWrap::Section> unused_sections;
+	p.SetSectionTable(sections ? sections : &unused_sections, SECTION_ALIGNMENT);
+	p.SetBulkCopy(ParallelCopy, PARALLEL_COPY_MIN);
+
 	u32 version = STATE_VERSION;
 	{
 		static const u32 COOKIE_BASE = 0xBAADBABE;
@@ -118,6 +163,460 @@ static void DoState(PointerWrap &p)
 	p.DoMarker("Movie");
 }
 
+static size_t GetNumChunks(size_t size)
+{
+	// The stream always ends with a chunk shorter than IN_LEN, which may be empty.
+	return size / IN_LEN + 1;
+}
+
+static void RunChunkJob(const std::function<void(size_t)>& func, size_t num_chunks)
+{
+	size_t i;
+	while ((i = g_chunk_job_next++) < num_chunks)
+		func(i);
+}
+
+static void ChunkWorker()
+{
+	Common::SetCurrentThreadName("Savestate worker");
+
+	u32 last_job_id = 0;
+	std::unique_lock<std::mutex> lk(g_chunk_worker_lock);
+	while (true)
+	{
+		g_chunk_worker_wake.wait(lk, [&] { return g_chunk_workers_quit || g_chunk_job_id != last_job_id; });
+		if (g_chunk_workers_quit)
+			return;
+
+		last_job_id = g_chunk_job_id;
+		const std::function<void(size_t)>& job = *g_chunk_job;
+		const size_t num_chunks = g_chunk_job_size;
+		lk.unlock();
+		RunChunkJob(job, num_chunks);
+		lk.lock();
+
+		if (--g_chunk_workers_busy == 0)
+			g_chunk_job_done.notify_one();
+	}
+}
+
+// Runs func(chunk_index) for every chunk, spread over the workers and the
+// calling thread. If another thread is running a job, the chunks are done
+// serially rather than waiting for it.
+template <typename F>
+static void ForEachChunkParallel(size_t num_chunks, F func)
+{
+	std::unique_lock<std::mutex> job_lk(g_chunk_job_lock, std::try_to_lock);
+	if (num_chunks <= 1 || g_chunk_workers.empty() || !job_lk.owns_lock())
+	{
+		for (size_t i = 0; i < num_chunks; i++)
+			func(i);
+		return;
+	}
+
+	const std::function<void(size_t)> job(func);
+	{
+		std::lock_guard<std::mutex> lk(g_chunk_worker_lock);
+		g_chunk_job = &job;
+		g_chunk_job_size = num_chunks;
+		g_chunk_job_next = 0;
+		g_chunk_workers_busy = g_chunk_workers.size();
+		g_chunk_job_id++;
+	}
+	g_chunk_worker_wake.notify_all();
+
+	RunChunkJob(job, num_chunks);
+
+	std::unique_lock<std::mutex> lk(g_chunk_worker_lock);
+	g_chunk_job_done.wait(lk, [] { return g_chunk_workers_busy == 0; });
+}
+
+static void ParallelCopy(void* dest, const void* src, size_t size)
+{
+	ForEachChunkParallel((size + PARALLEL_COPY_PIECE - 1) / PARALLEL_COPY_PIECE, [&](size_t i) {
+		const size_t offset = i * PARALLEL_COPY_PIECE;
+		memcpy((u8*)dest + offset, (const u8*)src + offset, std::min<size_t>(PARALLEL_COPY_PIECE, size - offset));
+	});
+}
+
+// Compresses data into a stream of (u32 length, lzo1x_1 block) chunks, each
+// covering IN_LEN bytes of input. Chunks are independent, so they are
+// compressed in parallel; the output is identical to compressing serially.
+static void CompressChunks(const u8* data, size_t size, std::vector<u8>& out)
+{
+	const size_t num_chunks = GetNumChunks(size);
+	std::vector<std::vector<u8>> compressed(num_chunks);
+
+	ForEachChunkParallel(num_chunks, [&](size_t i) {
+		std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+		const size_t offset = i * IN_LEN;
+		const lzo_uint cur_len = (lzo_uint)std::min<size_t>(IN_LEN, size - offset);
+		lzo_uint out_len = 0;
+
+		compressed[i].resize(OUT_LEN);
+		if (lzo1x_1_compress(data + offset, cur_len, &compressed[i][0], &out_len, &wrkmem[0]) != LZO_E_OK)
+			PanicAlertT("Internal LZO Error - compression failed");
+		compressed[i].resize(out_len);
+	});
+
+	size_t total = 0;
+	for (const std::vector<u8>& chunk : compressed)
+		total += sizeof(lzo_uint32) + chunk.size();
+
+	out.resize(total);
+	u8* dest = out.data();
+	for (const std::vector<u8>& chunk : compressed)
+	{
+		const lzo_uint32 len = (lzo_uint32)chunk.size();
+		memcpy(dest, &len, sizeof(len));
+		dest += sizeof(len);
+		if (len)
+			memcpy(dest, chunk.data(), len);
+		dest += len;
+	}
+}
+
+// Inverse of CompressChunks. The chunk table is walked serially (it has no
+// index), then the chunks are decompressed in parallel directly into out.
+static bool DecompressChunks(const u8* data, size_t size, u8* out, size_t out_size)
+{
+	std::vector<std::pair<size_t, lzo_uint32>> chunks;
+	size_t pos = 0;
+	while (pos + sizeof(lzo_uint32) <= size)
+	{
+		lzo_uint32 len;
+		memcpy(&len, data + pos, sizeof(len));
+		pos += sizeof(len);
+		if (pos + len > size)
+			return false;
+		chunks.emplace_back(pos, len);
+		pos += len;
+	}
+
+	if (chunks.size() != GetNumChunks(out_size))
+		return false;
+
+	Common::Flag failed;
+	ForEachChunkParallel(chunks.size(), [&](size_t i) {
+		const size_t offset = i * IN_LEN;
+		const lzo_uint expected_len = (lzo_uint)std::min<size_t>(IN_LEN, out_size - offset);
+		lzo_uint new_len = expected_len;
+		const int res = lzo1x_decompress_safe(data + chunks[i].first, chunks[i].second, out + offset, &new_len, nullptr);
+		// A short chunk would leave whatever out held before in its place.
+		if (res != LZO_E_OK || new_len != expected_len)
+		{
+			ERROR_LOG(COMMON, "Internal LZO Error - decompression failed (%d) in chunk %u", res, (u32)i);
+			failed.Set();
+		}
+	});
+	return !failed.IsSet();
+}
+
+// Compressed states are stored in a sectioned container following the
+// StateHeader. Each PointerWrap section is checksummed and split into
+// independently compressed blocks, so blocks can be compressed and
+// decompressed in parallel and single sections read without the rest.
+//
+// Layout: ContainerHeader, SectionEntry[num_sections],
+//         BlockEntry[num_blocks], block data.
+//
+// States from before the container start with the u32 length of their first
+// lzo chunk, which is at most OUT_LEN and so never equals the magic.
+static const u32 CONTAINER_MAGIC = 0x43535344; // "DSSC"
+static const u32 CONTAINER_VERSION = 1;
+
+struct ContainerHeader
+{
+	u32 magic;
+	u32 version;
+	u32 num_sections;
+	u32 num_blocks;
+	u64 stream_size;
+};
+
+struct SectionEntry
+{
+	char name[48];
+	u32 offset;
+	u32 size;
+	u32 checksum; // Adler-32 of the uncompressed section
+	u32 first_block;
+	u32 num_blocks;
+};
+
+struct BlockEntry
+{
+	u64 file_offset; // relative to the ContainerHeader
+	u32 compressed_size; // equal to raw_size if the block is stored as is
+	u32 raw_size;
+};
+
+static void CompressSectioned(const u8* data, size_t size, const std::vector<PointerWrap::Section>& sections,
+                              std::vector<u8>& out)
+{
+	// Sections cover everything up to the last marker; anything after it
+	// goes into a trailing section.
+	std::vector<SectionEntry> entries;
+	u32 covered = 0;
+	for (const PointerWrap::Section& section : sections)
+	{
+		SectionEntry entry = {};
+		strncpy(entry.name, section.name.c_str(), sizeof(entry.name) - 1);
+		entry.offset = section.offset;
+		entry.size = section.size;
+		entries.push_back(entry);
+		covered = section.offset + section.size;
+	}
+	if (covered < size)
+	{
+		SectionEntry entry = {};
+		strncpy(entry.name, "Tail", sizeof(entry.name) - 1);
+		entry.offset = covered;
+		entry.size = (u32)(size - covered);
+		entries.push_back(entry);
+	}
+
+	std::vector<BlockEntry> blocks;
+	for (SectionEntry& entry : entries)
+	{
+		entry.first_block = (u32)blocks.size();
+		entry.num_blocks = (entry.size + IN_LEN - 1) / IN_LEN;
+		for (u32 i = 0; i < entry.num_blocks; i++)
+		{
+			BlockEntry block = {};
+			block.file_offset = entry.offset + (u64)i * IN_LEN; // stream offset until laid out below
+			block.raw_size = std::min(IN_LEN, entry.size - i * IN_LEN);
+			blocks.push_back(block);
+		}
+	}
+
+	ForEachChunkParallel(entries.size(), [&](size_t i) {
+		entries[i].checksum = HashAdler32(data + entries[i].offset, entries[i].size);
+	});
+
+	std::vector<std::vector<u8>> compressed(blocks.size());
+	ForEachChunkParallel(blocks.size(), [&](size_t i) {
+		std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+		const u8* src = data + blocks[i].file_offset;
+		lzo_uint out_len = 0;
+
+		compressed[i].resize(OUT_LEN);
+		if (lzo1x_1_compress(src, blocks[i].raw_size, &compressed[i][0], &out_len, &wrkmem[0]) != LZO_E_OK)
+			PanicAlertT("Internal LZO Error - compression failed");
+
+		if (out_len < blocks[i].raw_size)
+			compressed[i].resize(out_len);
+		else
+			compressed[i].assign(src, src + blocks[i].raw_size);
+	});
+
+	ContainerHeader header;
+	header.magic = CONTAINER_MAGIC;
+	header.version = CONTAINER_VERSION;
+	header.num_sections = (u32)entries.size();
+	header.num_blocks = (u32)blocks.size();
+	header.stream_size = size;
+
+	u64 offset = sizeof(header) + entries.size() * sizeof(SectionEntry) + blocks.size() * sizeof(BlockEntry);
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		blocks[i].file_offset = offset;
+		blocks[i].compressed_size = (u32)compressed[i].size();
+		offset += compressed[i].size();
+	}
+
+	out.resize((size_t)offset);
+	u8* dest = out.data();
+	memcpy(dest, &header, sizeof(header));
+	dest += sizeof(header);
+	if (!entries.empty())
+		memcpy(dest, entries.data(), entries.size() * sizeof(SectionEntry));
+	dest += entries.size() * sizeof(SectionEntry);
+	if (!blocks.empty())
+		memcpy(dest, blocks.data(), blocks.size() * sizeof(BlockEntry));
+	dest += blocks.size() * sizeof(BlockEntry);
+	for (const std::vector<u8>& block : compressed)
+	{
+		if (!block.empty())
+			memcpy(dest, block.data(), block.size());
+		dest += block.size();
+	}
+}
+
+static bool ReadContainerDirectory(const u8* data, size_t size, ContainerHeader& header,
+                                   std::vector<SectionEntry>& entries, std::vector<BlockEntry>& blocks)
+{
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != CONTAINER_MAGIC || header.version != CONTAINER_VERSION)
+		return false;
+
+	const size_t directory_size = sizeof(header) + (size_t)header.num_sections * sizeof(SectionEntry) +
+	                              (size_t)header.num_blocks * sizeof(BlockEntry);
+	if (directory_size > size)
+		return false;
+
+	entries.resize(header.num_sections);
+	blocks.resize(header.num_blocks);
+	if (!entries.empty())
+		memcpy(entries.data(), data + sizeof(header), entries.size() * sizeof(SectionEntry));
+	if (!blocks.empty())
+		memcpy(blocks.data(), data + sizeof(header) + entries.size() * sizeof(SectionEntry), blocks.size() * sizeof(BlockEntry));
+
+	for (const SectionEntry& entry : entries)
+	{
+		if ((u64)entry.offset + entry.size > header.stream_size ||
+		    (u64)entry.first_block + entry.num_blocks > header.num_blocks)
+			return false;
+	}
+	for (const BlockEntry& block : blocks)
+	{
+		if (block.file_offset + block.compressed_size > size || block.raw_size > IN_LEN)
+			return false;
+	}
+	return true;
+}
+
+// Decompresses and verifies the given sections of a container into out,
+// which is indexed by stream offset.
+static bool DecompressSections(const u8* data, const std::vector<SectionEntry>& entries,
+                               const std::vector<BlockEntry>& blocks, u8* out)
+{
+	// Flatten to (section, block) pairs so one huge section (RAM, EXRAM)
+	// doesn't end up on a single thread.
+	std::vector<std::pair<u32, u32>> work;
+	for (u32 i = 0; i < entries.size(); i++)
+	{
+		for (u32 b = 0; b < entries[i].num_blocks; b++)
+			work.emplace_back(i, b);
+	}
+
+	Common::Flag failed;
+	ForEachChunkParallel(work.size(), [&](size_t i) {
+		const SectionEntry& entry = entries[work[i].first];
+		const BlockEntry& block = blocks[entry.first_block + work[i].second];
+		u8* dest = out + entry.offset + (size_t)work[i].second * IN_LEN;
+		if ((size_t)work[i].second * IN_LEN + block.raw_size > entry.size)
+		{
+			failed.Set();
+			return;
+		}
+
+		if (block.compressed_size == block.raw_size)
+		{
+			memcpy(dest, data + block.file_offset, block.raw_size);
+			return;
+		}
+
+		lzo_uint new_len = block.raw_size;
+		const int res = lzo1x_decompress_safe(data + block.file_offset, block.compressed_size, dest, &new_len, nullptr);
+		if (res != LZO_E_OK || new_len != block.raw_size)
+		{
+			ERROR_LOG(COMMON, "Internal LZO Error - decompression failed (%d) in section %s", res, entry.name);
+			failed.Set();
+		}
+	});
+	if (failed.IsSet())
+		return false;
+
+	ForEachChunkParallel(entries.size(), [&](size_t i) {
+		if (HashAdler32(out + entries[i].offset, entries[i].size) != entries[i].checksum)
+		{
+			ERROR_LOG(COMMON, "Savestate section %s failed its checksum", entries[i].name);
+			failed.Set();
+		}
+	});
+	return !failed.IsSet();
+}
+
+static bool DecompressSectioned(const u8* data, size_t size, std::vector<u8>& out)
+{
+	ContainerHeader header;
+	std::vector<SectionEntry> entries;
+	std::vector<BlockEntry> blocks;
+	if (!ReadContainerDirectory(data, size, header, entries, blocks))
+		return false;
+
+	// Zero-filled, which is also what the padding between sections holds.
+	out.assign((size_t)header.stream_size, 0);
+	return DecompressSections(data, entries, blocks, out.data());
+}
+
+struct DeltaHeader
+{
+	u32 state_size;
+	u32 num_pages;
+};
+
+// A delta lists the DELTA_PAGE_SIZE pages of state that differ from base,
+// as a table of page indices followed by the page contents. Since the
+// emulated memory is serialized at fixed offsets, unchanged RAM, EXRAM and
+// ARAM pages drop out of the delta.
+static void CreateDelta(const std::vector<u8>& base, const std::vector<u8>& state, std::vector<u8>& delta)
+{
+	std::vector<u32> pages;
+	const size_t num_pages = (state.size() + DELTA_PAGE_SIZE - 1) / DELTA_PAGE_SIZE;
+	for (size_t i = 0; i < num_pages; i++)
+	{
+		const size_t offset = i * DELTA_PAGE_SIZE;
+		const size_t len = std::min<size_t>(DELTA_PAGE_SIZE, state.size() - offset);
+		if (offset + len > base.size() || memcmp(&base[offset], &state[offset], len))
+			pages.push_back((u32)i);
+	}
+
+	DeltaHeader header;
+	header.state_size = (u32)state.size();
+	header.num_pages = (u32)pages.size();
+
+	delta.resize(sizeof(header) + pages.size() * (sizeof(u32) + DELTA_PAGE_SIZE));
+	u8* dest = delta.data();
+	memcpy(dest, &header, sizeof(header));
+	dest += sizeof(header);
+	if (!pages.empty())
+		memcpy(dest, pages.data(), pages.size() * sizeof(u32));
+	dest += pages.size() * sizeof(u32);
+	for (u32 page : pages)
+	{
+		const size_t offset = page * DELTA_PAGE_SIZE;
+		const size_t len = std::min<size_t>(DELTA_PAGE_SIZE, state.size() - offset);
+		memcpy(dest, &state[offset], len);
+		dest += len;
+	}
+	delta.resize(dest - delta.data());
+}
+
+static bool ApplyDelta(const std::vector<u8>& base, const std::vector<u8>& delta, std::vector<u8>& state)
+{
+	DeltaHeader header;
+	if (delta.size() < sizeof(header))
+		return false;
+	memcpy(&header, delta.data(), sizeof(header));
+
+	const u8* pages = delta.data() + sizeof(header);
+	const u8* src = pages + header.num_pages * sizeof(u32);
+	const u8* const end = delta.data() + delta.size();
+	if (src > end)
+		return false;
+
+	state.resize(header.state_size);
+	memcpy(state.data(), base.data(), std::min(base.size(), state.size()));
+	for (u32 i = 0; i < header.num_pages; i++)
+	{
+		u32 page;
+		memcpy(&page, pages + i * sizeof(u32), sizeof(page));
+		const size_t offset = (size_t)page * DELTA_PAGE_SIZE;
+		if (offset >= state.size())
+			return false;
+		const size_t len = std::min<size_t>(DELTA_PAGE_SIZE, state.size() - offset);
+		if (src + len > end)
+			return false;
+		memcpy(&state[offset], src, len);
+		src += len;
+	}
+	return true;
+}
+
 void LoadFromBuffer(std::vector<u8>& buffer)
 {
 	bool wasUnpaused = Core::PauseAndLock(true);
@@ -147,6 +646,39 @@ void SaveToBuffer(std::vector<u8>& buffer)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+u32 PackDelta(const std::vector<u8>& base, const std::vector<u8>& state, std::vector<u8>& delta)
+{
+	std::vector<u8> raw_delta;
+	CreateDelta(base, state, raw_delta);
+
+	// Stored as the raw delta size followed by the compressed chunk stream.
+	std::vector<u8> compressed;
+	CompressChunks(raw_delta.data(), raw_delta.size(), compressed);
+	const u32 raw_size = (u32)raw_delta.size();
+	delta.resize(sizeof(raw_size) + compressed.size());
+	memcpy(delta.data(), &raw_size, sizeof(raw_size));
+	memcpy(delta.data() + sizeof(raw_size), compressed.data(), compressed.size());
+
+	DeltaHeader header;
+	memcpy(&header, raw_delta.data(), sizeof(header));
+	INFO_LOG(COMMON, "Delta state: %u of %u pages changed, %u bytes compressed",
+	         header.num_pages, (u32)((state.size() + DELTA_PAGE_SIZE - 1) / DELTA_PAGE_SIZE), (u32)delta.size());
+	return header.num_pages;
+}
+
+bool UnpackDelta(const std::vector<u8>& base, const std::vector<u8>& delta, std::vector<u8>& state)
+{
+	u32 raw_size;
+	if (delta.size() < sizeof(raw_size))
+		return false;
+	memcpy(&raw_size, delta.data(), sizeof(raw_size));
+
+	std::vector<u8> raw_delta(raw_size);
+	if (!DecompressChunks(delta.data() + sizeof(raw_size), delta.size() - sizeof(raw_size), raw_delta.data(), raw_delta.size()))
+		return false;
+	return ApplyDelta(base, raw_delta, state);
+}
+
 void VerifyBuffer(std::vector<u8>& buffer)
 {
 	bool wasUnpaused = Core::PauseAndLock(true);
@@ -204,11 +736,100 @@ static std::map<double, int> GetSavedStates()
 struct CompressAndDumpState_args
 {
 	std::vector<u8>* buffer_vector;
+	std::vector<PointerWrap::Section>* sections;
 	std::mutex* buffer_mutex;
 	std::string filename;
 	bool wait;
+	bool delta;
 };
 
+// Writes the state as a sectioned container, after its StateHeader.
+static void WriteCompressedState(File::IOFile& f, const u8* data, size_t size, const std::vector<PointerWrap::Section>& sections)
+{
+	u32 start = Common::Timer::GetTimeMs();
+	std::vector<u8> compressed;
+	CompressSectioned(data, size, sections, compressed);
+	u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start, 1);
+	INFO_LOG(COMMON, "Compressed %u MB state to %u MB in %u ms (%.1f MB/s)",
+	         (u32)(size >> 20), (u32)(compressed.size() >> 20), elapsed,
+	         size / 1048576.0 * 1000.0 / elapsed);
+	f.WriteBytes(compressed.data(), compressed.size());
+}
+
+// Delta saves hold the pages of the state that changed since a base state,
+// which is written in full to "<game ID>.<checksum>.base" next to them. A
+// new base is written whenever a save has moved too far from the current
+// one; older bases stay behind for the deltas that still refer to them.
+//
+// The changed pages are found by comparing against the base in memory.
+// Guest memory is written by JIT stores through fastmem, by DMA and by
+// the DSP without a common hook, so writes aren't tracked.
+static const u32 DELTA_MAGIC = 0x44535344; // "DSSD"
+
+struct DeltaFileHeader
+{
+	u32 magic;
+	u32 base_checksum; // Adler-32 of the base's stream
+	char base_name[64];
+};
+
+static bool WriteDeltaBase(const std::string& dir, const std::vector<u8>& state, const std::vector<PointerWrap::Section>& sections)
+{
+	const u32 checksum = HashAdler32(state.data(), state.size());
+	const std::string name = StringFromFormat("%s.%08x.base",
+		SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), checksum);
+
+	File::IOFile f(dir + name, "wb");
+	StateHeader header;
+	memcpy(header.gameID, SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), 6);
+	header.size = (u32)state.size();
+	header.time = Common::Timer::GetDoubleTime();
+	f.WriteArray(&header, 1);
+	WriteCompressedState(f, state.data(), state.size(), sections);
+	if (!f.IsGood())
+	{
+		f.Close();
+		File::Delete(dir + name);
+		return false;
+	}
+
+	g_delta_base = state;
+	g_delta_base_name = name;
+	g_delta_base_checksum = checksum;
+	return true;
+}
+
+// Writes the delta of state against the base after its StateHeader, first
+// writing a new base if needed.
+static bool WriteDeltaState(File::IOFile& f, const std::string& filename, const std::vector<u8>& state,
+                            const std::vector<PointerWrap::Section>& sections, u32* changed_pages)
+{
+	std::string dir;
+	SplitPath(filename, &dir, nullptr, nullptr);
+
+	std::vector<u8> delta;
+	const u32 num_pages = (u32)((state.size() + DELTA_PAGE_SIZE - 1) / DELTA_PAGE_SIZE);
+	if (!g_delta_base.empty() && File::Exists(dir + g_delta_base_name))
+		*changed_pages = PackDelta(g_delta_base, state, delta);
+
+	// Loading a delta reads the whole base as well, so past half the
+	// pages a new base is cheaper.
+	if (delta.empty() || *changed_pages > num_pages / 2)
+	{
+		if (!WriteDeltaBase(dir, state, sections))
+			return false;
+		*changed_pages = PackDelta(g_delta_base, state, delta);
+	}
+
+	DeltaFileHeader header = {};
+	header.magic = DELTA_MAGIC;
+	header.base_checksum = g_delta_base_checksum;
+	strncpy(header.base_name, g_delta_base_name.c_str(), sizeof(header.base_name) - 1);
+	f.WriteArray(&header, 1);
+	f.WriteBytes(delta.data(), delta.size());
+	return f.IsGood();
+}
+
 static void CompressAndDumpState(CompressAndDumpState_args save_args)
 {
 	std::lock_guard<std::mutex> lk(*save_args.buffer_mutex);
@@ -252,47 +873,47 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 	// Setting up the header
 	StateHeader header;
 	memcpy(header.gameID, SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), 6);
-	header.size = g_use_compression ? (u32)buffer_size : 0;
+	header.size = (g_use_compression || save_args.delta) ? (u32)buffer_size : 0;
 	header.time = Common::Timer::GetDoubleTime();
 
 	f.WriteArray(&header, 1);
 
-	if (header.size != 0) // non-zero header size means the state is compressed
+	u32 start = Common::Timer::GetTimeMs();
+	if (save_args.delta)
 	{
-		lzo_uint i = 0;
-		while (true)
+		u32 changed_pages = 0;
+		if (!WriteDeltaState(f, filename, *save_args.buffer_vector, *save_args.sections, &changed_pages))
 		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
+			Core::DisplayMessage("Could not save state", 2000);
+			g_compressAndDumpStateSyncEvent.Set();
+			return;
+		}
 
-			if (cur_len != IN_LEN)
-				break;
+		Core::DisplayMessage(StringFromFormat("Saved delta state to %s (%u of %u pages, %u ms)", filename.c_str(),
+			changed_pages, (u32)((buffer_size + DELTA_PAGE_SIZE - 1) / DELTA_PAGE_SIZE),
+			Common::Timer::GetTimeMs() - start), 2000);
+		g_compressAndDumpStateSyncEvent.Set();
+		return;
+	}
 
-			i += cur_len;
-		}
+	if (header.size != 0) // non-zero header size means the state is compressed
+	{
+		WriteCompressedState(f, buffer_data, buffer_size, *save_args.sections);
 	}
 	else // uncompressed
 	{
+		// Pad the header out to a full page so the stream, and with it every
+		// section, is page-aligned in the file and can be mapped in place.
+		// The padding starts with the size of the stream.
+		static const u8 padding[SECTION_ALIGNMENT] = {};
+		const u64 stream_size = buffer_size;
+		f.WriteArray(&stream_size, 1);
+		f.WriteBytes(padding, SECTION_ALIGNMENT - sizeof(StateHeader) - sizeof(stream_size));
 		f.WriteBytes(buffer_data, buffer_size);
 	}
 
-	Core::DisplayMessage(StringFromFormat("Saved State to %s", filename.c_str()), 2000);
+	Core::DisplayMessage(StringFromFormat("Saved State to %s (%u ms)", filename.c_str(),
+		Common::Timer::GetTimeMs() - start), 2000);
 	g_compressAndDumpStateSyncEvent.Set();
 }
 
@@ -313,7 +934,7 @@ void SaveAs(const std::string& filename, bool wait)
 		g_current_buffer.resize(buffer_size);
 		ptr = &g_current_buffer[0];
 		p.SetMode(PointerWrap::MODE_WRITE);
-		DoState(p);
+		DoState(p, &g_current_sections);
 	}
 
 	if (p.GetMode() == PointerWrap::MODE_WRITE)
@@ -322,9 +943,11 @@ void SaveAs(const std::string& filename, bool wait)
 
 		CompressAndDumpState_args save_args;
 		save_args.buffer_vector = &g_current_buffer;
+		save_args.sections = &g_current_sections;
 		save_args.buffer_mutex = &g_cs_current_buffer;
 		save_args.filename = filename;
 		save_args.wait = wait;
+		save_args.delta = SConfig::GetInstance().m_LocalCoreStartupParameter.bDeltaSavestates;
 
 		Flush();
 		g_save_thread = std::thread(CompressAndDumpState, save_args);
@@ -356,14 +979,63 @@ bool ReadHeader(const std::string& filename, StateHeader& header)
 	return true;
 }
 
-static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
+static u8* LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data, File::MappedFile& mapping,
+                             bool allow_delta = true);
+
+// Rebuilds the stream of a delta state from its base.
+static bool LoadDelta(const std::string& filename, const u8* data, size_t size, std::vector<u8>& state)
+{
+	DeltaFileHeader header;
+	if (size < sizeof(header))
+	{
+		PanicAlertT("The state file %s is corrupt.", filename.c_str());
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	header.base_name[sizeof(header.base_name) - 1] = '\0';
+
+	// Next to the delta, or in the state directory for lastState.sav
+	std::string dir;
+	SplitPath(filename, &dir, nullptr, nullptr);
+	std::string base_filename = dir + header.base_name;
+	if (!File::Exists(base_filename))
+		base_filename = File::GetUserPath(D_STATESAVES_IDX) + header.base_name;
+
+	std::vector<u8> base;
+	File::MappedFile base_mapping;
+	if (!LoadFileStateData(base_filename, base, base_mapping, false) || base.empty())
+	{
+		PanicAlertT("The base state %s of %s could not be loaded.", header.base_name, filename.c_str());
+		return false;
+	}
+	if (HashAdler32(base.data(), base.size()) != header.base_checksum)
+	{
+		PanicAlertT("The base state %s of %s has changed.", header.base_name, filename.c_str());
+		return false;
+	}
+
+	const std::vector<u8> delta(data + sizeof(header), data + size);
+	if (!UnpackDelta(base, delta, state))
+	{
+		PanicAlertT("The state file %s is corrupt.", filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Returns a pointer to the state stream, or nullptr on failure. Compressed
+// and delta states are decompressed into ret_data; uncompressed ones are
+// mapped, so loading them copies straight from the page cache into emulated
+// memory.
+static u8* LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data, File::MappedFile& mapping,
+                             bool allow_delta)
 {
 	Flush();
 	File::IOFile f(filename, "rb");
 	if (!f)
 	{
 		Core::DisplayMessage("State not found", 2000);
-		return;
+		return nullptr;
 	}
 
 	StateHeader header;
@@ -373,53 +1045,116 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 	{
 		Core::DisplayMessage(StringFromFormat("State belongs to a different game (ID %.*s)",
 			6, header.gameID), 2000);
-		return;
+		return nullptr;
 	}
 
-	std::vector<u8> buffer;
-
-	if (header.size != 0) // non-zero size means the state is compressed
+	if (header.size == 0) // uncompressed
 	{
-		Core::DisplayMessage("Decompressing State...", 500);
-
-		buffer.resize(header.size);
+		if (!mapping.Open(filename) || mapping.GetSize() <= SECTION_ALIGNMENT)
+		{
+			PanicAlert("Failed to map state file %s", filename.c_str());
+			return nullptr;
+		}
 
-		lzo_uint i = 0;
-		while (true)
+		// DoState reads the mapping at fixed offsets, so a short file would
+		// fault instead of failing to load.
+		u64 stream_size;
+		memcpy(&stream_size, mapping.GetData() + sizeof(StateHeader), sizeof(stream_size));
+		if (stream_size == 0 || mapping.GetSize() - SECTION_ALIGNMENT < stream_size)
 		{
-			lzo_uint32 cur_len = 0;  // number of bytes to read
-			lzo_uint new_len = 0;  // number of bytes to write
+			PanicAlertT("The state file %s is truncated.", filename.c_str());
+			mapping.Close();
+			return nullptr;
+		}
+		mapping.AdviseSequential();
+		return const_cast<u8*>(mapping.GetData()) + SECTION_ALIGNMENT;
+	}
 
-			if (!f.ReadArray(&cur_len, 1))
-				break;
+	Core::DisplayMessage("Decompressing State...", 500);
 
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-			if (res != LZO_E_OK)
-			{
-				// This doesn't seem to happen anymore.
-				PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-					"Try loading the state again", res, i, new_len);
-				return;
-			}
+	if (!mapping.Open(filename) || mapping.GetSize() < sizeof(StateHeader) + sizeof(u32))
+	{
+		PanicAlert("Failed to map state file %s", filename.c_str());
+		return nullptr;
+	}
+	const u8* compressed = mapping.GetData() + sizeof(StateHeader);
+	const size_t compressed_size = (size_t)(mapping.GetSize() - sizeof(StateHeader));
+
+	u32 magic;
+	memcpy(&magic, compressed, sizeof(magic));
 
-			i += new_len;
+	if (magic == DELTA_MAGIC && allow_delta)
+	{
+		u32 start = Common::Timer::GetTimeMs();
+		std::vector<u8> buffer;
+		if (!LoadDelta(filename, compressed, compressed_size, buffer))
+			return nullptr;
+		mapping.Close();
+		INFO_LOG(COMMON, "Rebuilt %u MB delta state in %u ms", (u32)(buffer.size() >> 20),
+		         Common::Timer::GetTimeMs() - start);
+
+		ret_data.swap(buffer);
+		return ret_data.data();
+	}
+
+	u32 start = Common::Timer::GetTimeMs();
+	std::vector<u8> buffer;
+	if (magic == CONTAINER_MAGIC)
+	{
+		if (!DecompressSectioned(compressed, compressed_size, buffer))
+		{
+			PanicAlertT("The state file %s is corrupt.", filename.c_str());
+			return nullptr;
 		}
 	}
-	else // uncompressed
+	else
 	{
-		const size_t size = (size_t)(f.GetSize() - sizeof(StateHeader));
-		buffer.resize(size);
-
-		if (!f.ReadBytes(&buffer[0], size))
+		// States from before the sectioned container: one lzo stream.
+		// DoState still rejects those saved by an older STATE_VERSION.
+		buffer.resize(header.size);
+		if (!DecompressChunks(compressed, compressed_size, buffer.data(), buffer.size()))
 		{
-			PanicAlert("wtf? reading bytes: %i", (int)size);
-			return;
+			PanicAlertT("Internal LZO Error - decompression failed\n"
+				"Try loading the state again");
+			return nullptr;
 		}
 	}
+	mapping.Close();
+
+	u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start, 1);
+	INFO_LOG(COMMON, "Decompressed %u MB state in %u ms (%.1f MB/s)",
+	         (u32)(buffer.size() >> 20), elapsed, buffer.size() / 1048576.0 * 1000.0 / elapsed);
 
 	// all good
 	ret_data.swap(buffer);
+	return ret_data.data();
+}
+
+bool ReadSection(const std::string& filename, const std::string& name, std::vector<u8>& data)
+{
+	Flush();
+	File::MappedFile mapping;
+	if (!mapping.Open(filename) || mapping.GetSize() < sizeof(StateHeader))
+		return false;
+
+	ContainerHeader header;
+	std::vector<SectionEntry> entries;
+	std::vector<BlockEntry> blocks;
+	const u8* container = mapping.GetData() + sizeof(StateHeader);
+	if (!ReadContainerDirectory(container, (size_t)(mapping.GetSize() - sizeof(StateHeader)), header, entries, blocks))
+		return false;
+
+	for (SectionEntry entry : entries)
+	{
+		if (name != entry.name)
+			continue;
+
+		// Decompress just this section into a buffer of its own.
+		data.resize(entry.size);
+		entry.offset = 0;
+		return DecompressSections(container, std::vector<SectionEntry>(1, entry), blocks, data.data());
+	}
+	return false;
 }
 
 void LoadAs(const std::string& filename)
@@ -445,15 +1180,16 @@ void LoadAs(const std::string& filename)
 
 	bool loaded = false;
 	bool loadedSuccessfully = false;
+	u32 start = Common::Timer::GetTimeMs();
 
 	// brackets here are so buffer gets freed ASAP
 	{
 		std::vector<u8> buffer;
-		LoadFileStateData(filename, buffer);
+		File::MappedFile mapping;
+		u8 *ptr = LoadFileStateData(filename, buffer, mapping);
 
-		if (!buffer.empty())
+		if (ptr)
 		{
-			u8 *ptr = &buffer[0];
 			PointerWrap p(&ptr, PointerWrap::MODE_READ);
 			DoState(p);
 			loaded = true;
@@ -463,9 +1199,13 @@ void LoadAs(const std::string& filename)
 
 	if (loaded)
 	{
+		// Either way the emulation is somewhere else now
+		Rewind::Clear();
+
 		if (loadedSuccessfully)
 		{
-			Core::DisplayMessage(StringFromFormat("Loaded state from %s", filename.c_str()), 2000);
+			Core::DisplayMessage(StringFromFormat("Loaded state from %s (%u ms)", filename.c_str(),
+				Common::Timer::GetTimeMs() - start), 2000);
 			if (File::Exists(filename + ".dtm"))
 				Movie::LoadInput(filename + ".dtm");
 			else if (!Movie::IsJustStartingRecordingInputFromSaveState() && !Movie::IsJustStartingPlayingInputFromSaveState())
@@ -501,11 +1241,11 @@ void VerifyAt(const std::string& filename)
 	bool wasUnpaused = Core::PauseAndLock(true);
 
 	std::vector<u8> buffer;
-	LoadFileStateData(filename, buffer);
+	File::MappedFile mapping;
+	u8 *ptr = LoadFileStateData(filename, buffer, mapping);
 
-	if (!buffer.empty())
+	if (ptr)
 	{
-		u8 *ptr = &buffer[0];
 		PointerWrap p(&ptr, PointerWrap::MODE_VERIFY);
 		DoState(p);
 
@@ -523,12 +1263,30 @@ void Init()
 {
 	if (lzo_init() != LZO_E_OK)
 		PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+	g_chunk_workers_quit = false;
+	// The thread running a job works on it too
+	for (int i = 1; i < cpu_info.num_cores; i++)
+		g_chunk_workers.emplace_back(ChunkWorker);
 }
 
 void Shutdown()
 {
 	Flush();
 
+	{
+		// Waits for a running job, e.g. a ReadSection from the UI
+		std::lock_guard<std::mutex> job_lk(g_chunk_job_lock);
+		{
+			std::lock_guard<std::mutex> lk(g_chunk_worker_lock);
+			g_chunk_workers_quit = true;
+		}
+		g_chunk_worker_wake.notify_all();
+		for (std::thread& worker : g_chunk_workers)
+			worker.join();
+		g_chunk_workers.clear();
+	}
+
 	// swapping with an empty vector, rather than clear()ing
 	// this gives a better guarantee to free the allocated memory right NOW (as opposed to, actually, never)
 	{
@@ -540,6 +1298,10 @@ void Shutdown()
 		std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
 		std::vector<u8>().swap(g_undo_load_buffer);
 	}
+
+	// The next game starts a new base
+	std::vector<u8>().swap(g_delta_base);
+	g_delta_base_name.clear();
 }
 
 static std::string MakeStateFilename(int number)
@@ -610,6 +1372,7 @@ void UndoLoadState()
 		if (File::Exists(File::GetUserPath(D_STATESAVES_IDX) + "undo.dtm") || (!Movie::IsRecordingInput() && !Movie::IsPlayingInput()))
 		{
 			LoadFromBuffer(g_undo_load_buffer);
+			Rewind::Clear();
 			if (Movie::IsRecordingInput() || Movie::IsPlayingInput())
 				Movie::LoadInput(File::GetUserPath(D_STATESAVES_IDX) + "undo.dtm");
 		}
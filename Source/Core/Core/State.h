@@ -44,10 +44,22 @@ void SaveAs(const std::string &filename, bool wait = false);
 void LoadAs(const std::string &filename);
 void VerifyAt(const std::string &filename);
 
+// Decompresses and checksums a single section of a compressed state file,
+// named after the PointerWrap marker that ends it (e.g. "Memory RAM").
+bool ReadSection(const std::string &filename, const std::string &name, std::vector<u8>& data);
+
 void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 void VerifyBuffer(std::vector<u8>& buffer);
 
+// Delta states hold only the pages of the serialized state that changed
+// since base, compressed in parallel. PackDelta returns the number of
+// changed pages.
+// With Core/DeltaSavestates set, Save and SaveAs write deltas against a base
+// state file kept next to them, and LoadAs reads them back through it.
+u32 PackDelta(const std::vector<u8>& base, const std::vector<u8>& state, std::vector<u8>& delta);
+bool UnpackDelta(const std::vector<u8>& base, const std::vector<u8>& delta, std::vector<u8>& state);
+
 void LoadLastSaved(int i = 1);
 void SaveFirstSaved();
 void UndoSaveState();
@@ -2,13 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <mutex>
+
 #include "Core/VolumeHandler.h"
+#include "Core/HW/DVDThread.h"
 #include "DiscIO/VolumeCreator.h"
 
 namespace VolumeHandler
 {
 
 static DiscIO::IVolume* g_pVolume = nullptr;
+// Blob readers aren't thread-safe, and the DVD thread reads concurrently
+// with the CPU thread.
+static std::mutex s_volume_lock;
 
 DiscIO::IVolume *GetVolume()
 {
@@ -17,6 +23,7 @@ DiscIO::IVolume *GetVolume()
 
 void EjectVolume()
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		// This code looks scary. Can the try/catch stuff be removed?
@@ -26,10 +33,12 @@ void EjectVolume()
 		delete g_pVolume;
 		g_pVolume = nullptr;
 	}
+	DVDThread::ClearCache();
 }
 
 bool SetVolumeName(const std::string& _rFullPath)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		delete g_pVolume;
@@ -37,12 +46,14 @@ bool SetVolumeName(const std::string& _rFullPath)
 	}
 
 	g_pVolume = DiscIO::CreateVolumeFromFilename(_rFullPath);
+	DVDThread::ClearCache();
 
 	return (g_pVolume != nullptr);
 }
 
 void SetVolumeDirectory(const std::string& _rFullPath, bool _bIsWii, const std::string& _rApploader, const std::string& _rDOL)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		delete g_pVolume;
@@ -50,10 +61,12 @@ void SetVolumeDirectory(const std::string& _rFullPath, bool _bIsWii, const std::
 	}
 
 	g_pVolume = DiscIO::CreateVolumeFromDirectory(_rFullPath, _bIsWii, _rApploader, _rDOL);
+	DVDThread::ClearCache();
 }
 
 u32 Read32(u64 _Offset)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr)
 	{
 		u32 Temp;
@@ -65,6 +78,7 @@ u32 Read32(u64 _Offset)
 
 bool ReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr && ptr)
 	{
 		g_pVolume->Read(_dwOffset, _dwLength, ptr);
@@ -75,6 +89,7 @@ bool ReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength)
 
 bool RAWReadToPtr( u8* ptr, u64 _dwOffset, u64 _dwLength )
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr && ptr)
 	{
 		g_pVolume->RAWRead(_dwOffset, _dwLength, ptr);
@@ -83,6 +98,20 @@ bool RAWReadToPtr( u8* ptr, u64 _dwOffset, u64 _dwLength )
 	return false;
 }
 
+u64 GetSize()
+{
+	std::lock_guard<std::mutex> lk(s_volume_lock);
+	if (g_pVolume != nullptr)
+		return g_pVolume->GetSize();
+	return 0;
+}
+
+bool IsMemoryMapped()
+{
+	std::lock_guard<std::mutex> lk(s_volume_lock);
+	return g_pVolume != nullptr && g_pVolume->IsMemoryMapped();
+}
+
 bool IsValid()
 {
 	return (g_pVolume != nullptr);
@@ -90,6 +119,7 @@ bool IsValid()
 
 bool IsWii()
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 		return IsVolumeWiiDisc(g_pVolume);
 
@@ -13,6 +13,7 @@
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
 #include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DCZBlob.h"
 #include "DiscIO/DriveBlob.h"
 #include "DiscIO/FileBlob.h"
 #include "DiscIO/WbfsBlob.h"
@@ -132,6 +133,9 @@ IBlobReader* CreateBlobReader(const std::string& filename)
 	if (IsCompressedBlob(filename))
 		return CompressedBlobReader::Create(filename);
 
+	if (IsDCZBlob(filename))
+		return DCZFileReader::Create(filename);
+
 	if (IsCISOBlob(filename))
 		return CISOFileReader::Create(filename);
 
@@ -30,6 +30,15 @@ public:
 	// NOT thread-safe - can't call this from multiple threads.
 	virtual bool Read(u64 offset, u64 size, u8* out_ptr) = 0;
 
+	// Formats that store Wii partition data decrypted can hand out the 0x7C00
+	// bytes of user data of the cluster at the given disc offset directly,
+	// instead of encrypting it only for the volume to decrypt it again.
+	virtual bool ReadWiiDecrypted(u64 cluster_offset, u8* out_ptr) { return false; }
+
+	// True if reads are copies out of a memory mapping, which makes caching
+	// them again pointless.
+	virtual bool IsMemoryMapped() const { return false; }
+
 protected:
 	IBlobReader() {}
 };
@@ -8,25 +8,51 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include <zlib.h>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DCZBlob.h"
 #include "DiscIO/DiscScrubber.h"
 
 
 namespace DiscIO
 {
 
-CompressedBlobReader::CompressedBlobReader(const std::string& filename) : file_name(filename)
+// Reads of at least this many blocks are decompressed on several threads;
+// for fewer, waking the workers costs more than it saves.
+static const u64 MIN_PARALLEL_BLOCKS = 8;
+
+static unsigned int GetNumWorkerThreads()
+{
+	return std::max(cpu_info.num_cores, 1);
+}
+
+CompressedBlobReader::CompressedBlobReader(const std::string& filename)
+	: file_name(filename)
+	, m_job(nullptr)
+	, m_job_size(0)
+	, m_job_next(0)
+	, m_workers_busy(0)
+	, m_job_id(0)
+	, m_workers_quit(false)
 {
 	m_file.Open(filename, "rb");
 	file_size = File::GetSize(filename);
@@ -61,6 +87,14 @@ CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename)
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+	{
+		std::lock_guard<std::mutex> lk(m_worker_lock);
+		m_workers_quit = true;
+	}
+	m_worker_wake.notify_all();
+	for (std::thread& worker : m_workers)
+		worker.join();
+
 	delete[] zlib_buffer;
 	delete[] block_pointers;
 	delete[] hashes;
@@ -81,17 +115,8 @@ u64 CompressedBlobReader::GetBlockCompressedSize(u64 block_num) const
 
 void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 {
-	bool uncompressed = false;
 	u32 comp_block_size = (u32)GetBlockCompressedSize(block_num);
-	u64 offset = block_pointers[block_num] + data_offset;
-
-	if (offset & (1ULL << 63))
-	{
-		if (comp_block_size != header.block_size)
-			PanicAlert("Uncompressed block with wrong size");
-		uncompressed = true;
-		offset &= ~(1ULL << 63);
-	}
+	u64 offset = (block_pointers[block_num] & ~(1ULL << 63)) + data_offset;
 
 	// clear unused part of zlib buffer. maybe this can be deleted when it works fully.
 	memset(zlib_buffer + comp_block_size, 0, zlib_buffer_size - comp_block_size);
@@ -99,13 +124,115 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	m_file.Seek(offset, SEEK_SET);
 	m_file.ReadBytes(zlib_buffer, comp_block_size);
 
-	u8* source = zlib_buffer;
-	u8* dest = out_ptr;
+	std::string error;
+	DecompressBlock(block_num, zlib_buffer, comp_block_size, out_ptr, &error);
+	if (!error.empty())
+		PanicAlert("%s", error.c_str());
+}
+
+void CompressedBlobReader::RunJob()
+{
+	u64 i;
+	while ((i = m_job_next++) < m_job_size)
+		(*m_job)(i);
+}
+
+void CompressedBlobReader::WorkerThread()
+{
+	Common::SetCurrentThreadName("GCZ worker");
+
+	u32 last_job_id = 0;
+	std::unique_lock<std::mutex> lk(m_worker_lock);
+	while (true)
+	{
+		m_worker_wake.wait(lk, [&] { return m_workers_quit || m_job_id != last_job_id; });
+		if (m_workers_quit)
+			return;
+
+		last_job_id = m_job_id;
+		lk.unlock();
+		RunJob();
+		lk.lock();
+
+		if (--m_workers_busy == 0)
+			m_job_done.notify_one();
+	}
+}
+
+void CompressedBlobReader::ForEachBlockParallel(u64 count, const std::function<void(u64)>& func)
+{
+	// The calling thread works on the job too
+	if (m_workers.empty())
+	{
+		for (unsigned int i = 1; i < GetNumWorkerThreads(); i++)
+			m_workers.emplace_back(&CompressedBlobReader::WorkerThread, this);
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(m_worker_lock);
+		m_job = &func;
+		m_job_size = count;
+		m_job_next = 0;
+		m_workers_busy = m_workers.size();
+		m_job_id++;
+	}
+	m_worker_wake.notify_all();
+
+	RunJob();
+
+	std::unique_lock<std::mutex> lk(m_worker_lock);
+	m_job_done.wait(lk, [this] { return m_workers_busy == 0; });
+}
+
+bool CompressedBlobReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr)
+{
+	if (num_blocks < MIN_PARALLEL_BLOCKS || block_num + num_blocks > header.num_blocks)
+		return SectorReader::ReadMultipleAlignedBlocks(block_num, num_blocks, out_ptr);
+
+	// Blocks are stored back to back, so neighbouring blocks can be read in
+	// one go and then inflated in parallel.
+	std::vector<u64> starts(num_blocks + 1);
+	for (u64 i = 0; i < num_blocks; i++)
+		starts[i] = block_pointers[block_num + i] & ~(1ULL << 63);
+	starts[num_blocks] = starts[num_blocks - 1] + (u32)GetBlockCompressedSize(block_num + num_blocks - 1);
+
+	std::vector<u8> compressed((size_t)(starts[num_blocks] - starts[0]));
+	m_file.Seek(starts[0] + data_offset, SEEK_SET);
+	if (!m_file.ReadBytes(compressed.data(), compressed.size()))
+		return false;
+
+	std::atomic<bool> ok(true);
+	std::vector<std::string> errors((size_t)num_blocks);
+	ForEachBlockParallel(num_blocks, [&](u64 i) {
+		const u8* source = compressed.data() + (starts[i] - starts[0]);
+		if (!DecompressBlock(block_num + i, source, (u32)(starts[i + 1] - starts[i]), out_ptr + i * header.block_size, &errors[i]))
+			ok = false;
+	});
+
+	// Only the first problem is shown; a corrupt image would otherwise
+	// raise one alert per block.
+	for (const std::string& error : errors)
+	{
+		if (!error.empty())
+		{
+			PanicAlert("%s", error.c_str());
+			break;
+		}
+	}
+
+	return ok;
+}
+
+bool CompressedBlobReader::DecompressBlock(u64 block_num, const u8* source, u32 comp_block_size, u8* dest, std::string* error) const
+{
+	const bool uncompressed = (block_pointers[block_num] & (1ULL << 63)) != 0;
+	if (uncompressed && comp_block_size != header.block_size && error->empty())
+		*error = "Uncompressed block with wrong size";
 
 	// First, check hash.
 	u32 block_hash = HashAdler32(source, comp_block_size);
-	if (block_hash != hashes[block_num])
-		PanicAlert("Hash of block %" PRIu64 " is %08x instead of %08x.\n"
+	if (block_hash != hashes[block_num] && error->empty())
+		*error = StringFromFormat("Hash of block %" PRIu64 " is %08x instead of %08x.\n"
 		"Your ISO, %s, is corrupt.",
 		block_num, block_hash, hashes[block_num],
 		file_name.c_str());
@@ -113,34 +240,90 @@ void CompressedBlobReader::GetBlock(u64 block_num, u8 *out_ptr)
 	if (uncompressed)
 	{
 		memcpy(dest, source, comp_block_size);
+		return true;
 	}
 	else
 	{
 		z_stream z;
 		memset(&z, 0, sizeof(z));
-		z.next_in = source;
+		z.next_in = const_cast<u8*>(source);
 		z.avail_in = comp_block_size;
-		if (z.avail_in > header.block_size)
+		if (z.avail_in > header.block_size && error->empty())
 		{
-			PanicAlert("We have a problem");
+			*error = "We have a problem";
 		}
 		z.next_out = dest;
 		z.avail_out = header.block_size;
 		inflateInit(&z);
 		int status = inflate(&z, Z_FULL_FLUSH);
 		u32 uncomp_size = header.block_size - z.avail_out;
-		if (status != Z_STREAM_END)
+		if (status != Z_STREAM_END && error->empty())
 		{
 			// this seem to fire wrongly from time to time
 			// to be sure, don't use compressed isos :P
-			PanicAlert("Failure reading block %" PRIu64 " - out of data and not at end.", block_num);
+			*error = StringFromFormat("Failure reading block %" PRIu64 " - out of data and not at end.", block_num);
 		}
 		inflateEnd(&z);
-		if (uncomp_size != header.block_size)
-			PanicAlert("Wrong block size");
+		if (uncomp_size != header.block_size && error->empty())
+			*error = "Wrong block size";
+		return status == Z_STREAM_END && uncomp_size == header.block_size;
 	}
 }
 
+// A block on its way through the compression pipeline. Blocks are read on
+// the calling thread, compressed by the workers and written in order by the
+// writer thread.
+struct CompressionSlot
+{
+	enum State
+	{
+		EMPTY,
+		READ,
+		COMPRESSED,
+	};
+
+	State state;
+	u32 block;
+	std::vector<u8> in_buf;
+	std::vector<u8> out_buf;
+	u32 out_size; // 0 if the block is stored uncompressed
+	u32 hash;
+};
+
+static void CompressBlock(CompressionSlot& slot)
+{
+	const u32 block_size = (u32)slot.in_buf.size();
+
+	z_stream z;
+	memset(&z, 0, sizeof(z));
+	z.zalloc = Z_NULL;
+	z.zfree = Z_NULL;
+	z.opaque = Z_NULL;
+	z.next_in = slot.in_buf.data();
+	z.avail_in = block_size;
+	z.next_out = slot.out_buf.data();
+	z.avail_out = block_size;
+
+	slot.out_size = 0;
+	if (deflateInit(&z, 9) == Z_OK)
+	{
+		int status = deflate(&z, Z_FINISH);
+		// Store blocks as-is unless they compress with some margin.
+		if (status == Z_STREAM_END && z.avail_out >= 10)
+			slot.out_size = block_size - z.avail_out;
+		deflateEnd(&z);
+	}
+	else
+	{
+		ERROR_LOG(DISCIO, "Deflate failed");
+	}
+
+	if (slot.out_size)
+		slot.hash = HashAdler32(slot.out_buf.data(), slot.out_size);
+	else
+		slot.hash = HashAdler32(slot.in_buf.data(), block_size);
+}
+
 bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u32 sub_type,
 	int block_size, CompressCB callback, void* arg)
 {
@@ -180,143 +363,223 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 	// round upwards!
 	header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
-	u64* offsets = new u64[header.num_blocks];
-	u32* hashes = new u32[header.num_blocks];
-	u8* out_buf = new u8[block_size];
-	u8* in_buf = new u8[block_size];
+	std::vector<u64> offsets(header.num_blocks);
+	std::vector<u32> hashes(header.num_blocks);
 
 	// seek past the header (we will write it at the end)
 	f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
 	// seek past the offset and hash tables (we will write them at the end)
 	f.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
 
+	const u32 start_time = Common::Timer::GetTimeMs();
+	const unsigned int num_workers = GetNumWorkerThreads();
+	// Two slots per worker, so reading and writing can run ahead of compression.
+	std::vector<CompressionSlot> slots(num_workers * 2);
+	for (CompressionSlot& slot : slots)
+	{
+		slot.state = CompressionSlot::EMPTY;
+		slot.in_buf.resize(block_size);
+		slot.out_buf.resize(block_size);
+	}
+
+	std::mutex lock;
+	std::condition_variable cv;
+	bool aborted = false;
+	// Guarded by lock, for progress reports.
+	u32 blocks_written = 0;
+	u64 bytes_written = 0;
+
+	// Worker w compresses blocks w, w + num_workers, ...
+	std::vector<std::thread> workers;
+	for (unsigned int w = 0; w < num_workers; w++)
+	{
+		workers.emplace_back([&, w] {
+			for (u32 i = w; i < header.num_blocks; i += num_workers)
+			{
+				CompressionSlot& slot = slots[i % slots.size()];
+				{
+					std::unique_lock<std::mutex> lk(lock);
+					cv.wait(lk, [&] { return aborted || (slot.state == CompressionSlot::READ && slot.block == i); });
+					if (aborted)
+						return;
+				}
+
+				CompressBlock(slot);
+
+				std::lock_guard<std::mutex> lk(lock);
+				slot.state = CompressionSlot::COMPRESSED;
+				cv.notify_all();
+			}
+		});
+	}
+
 	// Now we are ready to write compressed data!
 	u64 position = 0;
 	int num_compressed = 0;
 	int num_stored = 0;
+	std::thread writer([&] {
+		for (u32 i = 0; i < header.num_blocks; i++)
+		{
+			CompressionSlot& slot = slots[i % slots.size()];
+			{
+				std::unique_lock<std::mutex> lk(lock);
+				cv.wait(lk, [&] { return aborted || (slot.state == CompressionSlot::COMPRESSED && slot.block == i); });
+				if (aborted)
+					return;
+			}
+
+			offsets[i] = position;
+			hashes[i] = slot.hash;
+			bool written;
+			if (slot.out_size)
+			{
+				// let's store compressed
+				written = f.WriteBytes(slot.out_buf.data(), slot.out_size);
+				position += slot.out_size;
+				num_compressed++;
+			}
+			else
+			{
+				// let's store uncompressed
+				offsets[i] |= 0x8000000000000000ULL;
+				written = f.WriteBytes(slot.in_buf.data(), block_size);
+				position += block_size;
+				num_stored++;
+			}
+
+			std::lock_guard<std::mutex> lk(lock);
+			if (!written)
+			{
+				ERROR_LOG(DISCIO, "Failed to write %s", outfile.c_str());
+				aborted = true;
+			}
+			slot.state = CompressionSlot::EMPTY;
+			blocks_written = i + 1;
+			bytes_written = position;
+			cv.notify_all();
+			if (aborted)
+				return;
+		}
+	});
+
 	int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
 
 	for (u32 i = 0; i < header.num_blocks; i++)
 	{
 		if (i % progress_monitor == 0)
 		{
-			const u64 inpos = inf.Tell();
-			int ratio = 0;
-			if (inpos != 0)
-				ratio = (int)(100 * position / inpos);
+			u32 done;
+			u64 done_bytes;
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				done = blocks_written;
+				done_bytes = bytes_written;
+			}
 
-			std::string temp = StringFromFormat("%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
-			callback(temp, (float)i / (float)header.num_blocks, arg);
+			int ratio = 0;
+			if (done != 0)
+				ratio = (int)(100 * done_bytes / ((u64)done * block_size));
+			const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+			const double speed = (double)done * block_size / (1024 * 1024) * 1000 / elapsed;
+
+			std::string temp = StringFromFormat("%i of %i blocks. Compression ratio %i%%, %.1f MB/s",
+				done, header.num_blocks, ratio, speed);
+			callback(temp, (float)done / (float)header.num_blocks, arg);
 		}
 
-		offsets[i] = position;
-		// u64 start = i * header.block_size;
-		// u64 size = header.block_size;
-		std::fill(in_buf, in_buf + header.block_size, 0);
-		if (scrubbing)
-			DiscScrubber::GetNextBlock(inf, in_buf);
-		else
-			inf.ReadBytes(in_buf, header.block_size);
-		z_stream z;
-		memset(&z, 0, sizeof(z));
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		z.next_in = in_buf;
-		z.avail_in = header.block_size;
-		z.next_out = out_buf;
-		z.avail_out = block_size;
-		int retval = deflateInit(&z, 9);
-
-		if (retval != Z_OK)
+		CompressionSlot& slot = slots[i % slots.size()];
 		{
-			ERROR_LOG(DISCIO, "Deflate failed");
-			goto cleanup;
+			std::unique_lock<std::mutex> lk(lock);
+			cv.wait(lk, [&] { return aborted || slot.state == CompressionSlot::EMPTY; });
+			if (aborted)
+				break;
 		}
 
-		int status = deflate(&z, Z_FINISH);
-		int comp_size = block_size - z.avail_out;
-		if ((status != Z_STREAM_END) || (z.avail_out < 10))
-		{
-			//PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-			// let's store uncompressed
-			offsets[i] |= 0x8000000000000000ULL;
-			f.WriteBytes(in_buf, block_size);
-			hashes[i] = HashAdler32(in_buf, block_size);
-			position += block_size;
-			num_stored++;
-		}
+		std::fill(slot.in_buf.begin(), slot.in_buf.end(), 0);
+		if (scrubbing)
+			DiscScrubber::GetNextBlock(inf, slot.in_buf.data());
 		else
-		{
-			// let's store compressed
-			//PanicAlert("Comp %i to %i", block_size, comp_size);
-			f.WriteBytes(out_buf, comp_size);
-			hashes[i] = HashAdler32(out_buf, comp_size);
-			position += comp_size;
-			num_compressed++;
-		}
+			inf.ReadBytes(slot.in_buf.data(), header.block_size);
 
-		deflateEnd(&z);
+		std::lock_guard<std::mutex> lk(lock);
+		slot.block = i;
+		slot.state = CompressionSlot::READ;
+		cv.notify_all();
 	}
 
-	header.compressed_data_size = position;
+	writer.join();
+	for (std::thread& worker : workers)
+		worker.join();
 
-	// Okay, go back and fill in headers
-	f.Seek(0, SEEK_SET);
-	f.WriteArray(&header, 1);
-	f.WriteArray(offsets, header.num_blocks);
-	f.WriteArray(hashes, header.num_blocks);
-
-cleanup:
-	// Cleanup
-	delete[] in_buf;
-	delete[] out_buf;
-	delete[] offsets;
-	delete[] hashes;
+	if (!aborted)
+	{
+		header.compressed_data_size = position;
+
+		// Okay, go back and fill in headers
+		f.Seek(0, SEEK_SET);
+		f.WriteArray(&header, 1);
+		f.WriteArray(offsets.data(), header.num_blocks);
+		f.WriteArray(hashes.data(), header.num_blocks);
+
+		const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+		NOTICE_LOG(DISCIO, "Compressed %s: %i blocks compressed, %i stored, %u ms (%.1f MB/s on %u threads)",
+			infile.c_str(), num_compressed, num_stored, elapsed,
+			header.data_size / (1024.0 * 1024.0) * 1000 / elapsed, num_workers);
+	}
 
 	DiscScrubber::Cleanup();
 	callback("Done compressing disc image.", 1.0f, arg);
-	return true;
+	return !aborted;
 }
 
 bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg)
 {
-	if (!IsCompressedBlob(infile))
+	if (!IsCompressedBlob(infile) && !IsDCZBlob(infile))
 	{
 		PanicAlertT("File not compressed");
 		return false;
 	}
 
-	CompressedBlobReader* reader = CompressedBlobReader::Create(infile);
+	std::unique_ptr<IBlobReader> reader(CreateBlobReader(infile));
 	if (!reader)
 		return false;
 
 	File::IOFile f(outfile, "wb");
 	if (!f)
-	{
-		delete reader;
 		return false;
-	}
 
-	const CompressedBlobHeader &header = reader->GetHeader();
-	u8* buffer = new u8[header.block_size];
-	int progress_monitor = std::max<int>(1, header.num_blocks / 100);
+	// Read enough at a time for GCZ blocks to be inflated in parallel.
+	const u64 data_size = reader->GetDataSize();
+	const u64 read_size = 0x100000 * GetNumWorkerThreads();
+	std::vector<u8> buffer((size_t)read_size);
+	const u32 start_time = Common::Timer::GetTimeMs();
 
-	for (u64 i = 0; i < header.num_blocks; i++)
+	for (u64 offset = 0; offset < data_size; offset += read_size)
 	{
-		if (i % progress_monitor == 0)
+		const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+		const double speed = offset / (1024.0 * 1024.0) * 1000 / elapsed;
+		callback(StringFromFormat("Unpacking, %.1f MB/s", speed), (float)offset / (float)data_size, arg);
+
+		const u64 size = std::min(read_size, data_size - offset);
+		reader->Read(offset, size, buffer.data());
+		if (!f.WriteBytes(buffer.data(), (size_t)size))
 		{
-			callback("Unpacking", (float)i / (float)header.num_blocks, arg);
+			PanicAlertT("Failed to write the output file \"%s\".\n"
+			            "Check that you have enough space available on the target drive.", outfile.c_str());
+			return false;
 		}
-		reader->Read(i * header.block_size, header.block_size, buffer);
-		f.WriteBytes(buffer, header.block_size);
 	}
 
-	delete[] buffer;
-
-	f.Resize(header.data_size);
+	if (!f.Close())
+	{
+		PanicAlertT("Failed to write the output file \"%s\".\n"
+		            "Check that you have enough space available on the target drive.", outfile.c_str());
+		return false;
+	}
 
-	delete reader;
+	const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+	NOTICE_LOG(DISCIO, "Decompressed %s in %u ms (%.1f MB/s)", infile.c_str(), elapsed,
+		data_size / (1024.0 * 1024.0) * 1000 / elapsed);
 
 	return true;
 }
@@ -14,10 +14,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
 #include "DiscIO/Blob.h"
 
 namespace DiscIO
@@ -53,9 +59,22 @@ public:
 	u64 GetRawSize() const override { return file_size; }
 	u64 GetBlockCompressedSize(u64 block_num) const;
 	void GetBlock(u64 block_num, u8* out_ptr) override;
+	bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr) override;
 private:
 	CompressedBlobReader(const std::string& filename);
 
+	// Checks the hash of a block read from the file and inflates it. Safe to
+	// call from several threads at once, so problems are returned in error
+	// for the caller to report rather than shown.
+	bool DecompressBlock(u64 block_num, const u8* source, u32 comp_block_size, u8* dest, std::string* error) const;
+
+	// Runs func(i) for i in [0, count) on the workers and the calling thread.
+	// The workers are started by the first call and kept until the reader is
+	// destroyed, so DVD reads during emulation don't create threads.
+	void ForEachBlockParallel(u64 count, const std::function<void(u64)>& func);
+	void RunJob();
+	void WorkerThread();
+
 	CompressedBlobHeader header;
 	u64* block_pointers;
 	u32* hashes;
@@ -65,6 +84,17 @@ private:
 	u8* zlib_buffer;
 	int zlib_buffer_size;
 	std::string file_name;
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_worker_lock;
+	std::condition_variable m_worker_wake;
+	std::condition_variable m_job_done;
+	const std::function<void(u64)>* m_job;
+	u64 m_job_size;
+	std::atomic<u64> m_job_next;
+	size_t m_workers_busy;
+	u32 m_job_id;
+	bool m_workers_quit;
 };
 
 }  // namespace
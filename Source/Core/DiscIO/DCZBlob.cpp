@@ -0,0 +1,529 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include <lzo/lzo1x.h>
+#include <polarssl/aes.h>
+#include <polarssl/sha1.h>
+
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/DCZBlob.h"
+#include "DiscIO/VolumeCreator.h"
+
+namespace DiscIO
+{
+
+static const u32 CLUSTER_SIZE = 0x8000;
+static const u32 CLUSTER_HASH_SIZE = 0x400;
+static const u32 CLUSTER_DATA_SIZE = CLUSTER_SIZE - CLUSTER_HASH_SIZE;
+static const u32 CLUSTERS_PER_SUBGROUP = 8;
+static const u32 CLUSTERS_PER_GROUP = 64;
+static const u32 GROUP_SIZE = CLUSTER_SIZE * CLUSTERS_PER_GROUP;
+static const u32 GROUP_DATA_SIZE = CLUSTER_DATA_SIZE * CLUSTERS_PER_GROUP;
+// Data outside of Wii partitions is chunked at the same size.
+static const u32 CHUNK_SIZE = GROUP_SIZE;
+
+static const u8 NO_PARTITION = 0xFF;
+static const size_t CACHE_SIZE = 4;
+
+// Rebuilds the H0/H1/H2 hash tables of a group of clusters from their user
+// data and encrypts the group the same way the disc mastering process does.
+static void EncryptGroup(const u8* data, const u8* key, u8* out)
+{
+	static const u32 H0_SIZE = 20 * (CLUSTER_DATA_SIZE / 0x400);
+	static const u32 H1_SIZE = 20 * CLUSTERS_PER_SUBGROUP;
+	static const u32 H2_SIZE = 20 * (CLUSTERS_PER_GROUP / CLUSTERS_PER_SUBGROUP);
+
+	std::vector<u8> h0(CLUSTERS_PER_GROUP * H0_SIZE);
+	std::vector<u8> h1(CLUSTERS_PER_GROUP * 20);
+	u8 h2[H2_SIZE];
+
+	for (u32 c = 0; c < CLUSTERS_PER_GROUP; c++)
+	{
+		for (u32 j = 0; j < CLUSTER_DATA_SIZE / 0x400; j++)
+			sha1(data + c * CLUSTER_DATA_SIZE + j * 0x400, 0x400, &h0[c * H0_SIZE + j * 20]);
+		sha1(&h0[c * H0_SIZE], H0_SIZE, &h1[c * 20]);
+	}
+	for (u32 s = 0; s < CLUSTERS_PER_GROUP / CLUSTERS_PER_SUBGROUP; s++)
+		sha1(&h1[s * H1_SIZE], H1_SIZE, &h2[s * 20]);
+
+	aes_context aes;
+	aes_setkey_enc(&aes, key, 128);
+
+	for (u32 c = 0; c < CLUSTERS_PER_GROUP; c++)
+	{
+		u8 hashes[CLUSTER_HASH_SIZE] = {};
+		memcpy(hashes, &h0[c * H0_SIZE], H0_SIZE);
+		memcpy(hashes + 0x280, &h1[c / CLUSTERS_PER_SUBGROUP * H1_SIZE], H1_SIZE);
+		memcpy(hashes + 0x340, h2, H2_SIZE);
+
+		u8* cluster = out + c * CLUSTER_SIZE;
+		u8 iv[16] = {};
+		aes_crypt_cbc(&aes, AES_ENCRYPT, CLUSTER_HASH_SIZE, iv, hashes, cluster);
+		memcpy(iv, cluster + 0x3d0, 16);
+		aes_crypt_cbc(&aes, AES_ENCRYPT, CLUSTER_DATA_SIZE, iv, data + c * CLUSTER_DATA_SIZE, cluster + CLUSTER_HASH_SIZE);
+	}
+}
+
+static void DecryptGroup(const u8* in, const u8* key, u8* data)
+{
+	aes_context aes;
+	aes_setkey_dec(&aes, key, 128);
+
+	for (u32 c = 0; c < CLUSTERS_PER_GROUP; c++)
+	{
+		const u8* cluster = in + c * CLUSTER_SIZE;
+		u8 iv[16];
+		memcpy(iv, cluster + 0x3d0, 16);
+		aes_crypt_cbc(&aes, AES_DECRYPT, CLUSTER_DATA_SIZE, iv, cluster + CLUSTER_HASH_SIZE, data + c * CLUSTER_DATA_SIZE);
+	}
+}
+
+DCZFileReader::DCZFileReader(const std::string& filename)
+	: m_file(filename, "rb"), m_file_name(filename), m_cache_age(0)
+{
+	m_file_size = m_file.GetSize();
+	m_file.ReadArray(&m_header, 1);
+
+	m_partitions.resize(m_header.num_partitions);
+	m_file.ReadArray(m_partitions.data(), m_partitions.size());
+	m_chunks.resize(m_header.num_chunks);
+	m_file.ReadArray(m_chunks.data(), m_chunks.size());
+}
+
+DCZFileReader* DCZFileReader::Create(const std::string& filename)
+{
+	if (IsDCZBlob(filename))
+		return new DCZFileReader(filename);
+	else
+		return nullptr;
+}
+
+u32 DCZFileReader::FindChunk(u64 offset) const
+{
+	auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), offset,
+		[](u64 value, const DCZChunk& chunk) { return value < chunk.disc_offset; });
+	if (it == m_chunks.begin())
+		return (u32)m_chunks.size();
+
+	--it;
+	if (offset >= it->disc_offset + it->disc_size)
+		return (u32)m_chunks.size();
+	return (u32)(it - m_chunks.begin());
+}
+
+bool DCZFileReader::LoadStoredData(u32 index, std::vector<u8>& out)
+{
+	const DCZChunk& chunk = m_chunks[index];
+	const u32 raw_size = chunk.partition != NO_PARTITION ? GROUP_DATA_SIZE : chunk.disc_size;
+
+	if (chunk.stored_size == 0)
+	{
+		out.assign(raw_size, 0);
+		return true;
+	}
+
+	std::vector<u8> stored(chunk.stored_size);
+	m_file.Seek(chunk.file_offset, SEEK_SET);
+	if (!m_file.ReadBytes(stored.data(), stored.size()))
+		return false;
+
+	u32 hash = HashAdler32(stored.data(), stored.size());
+	if (hash != chunk.hash)
+	{
+		PanicAlert("Hash of chunk %u is %08x instead of %08x.\n"
+			"Your ISO, %s, is corrupt.",
+			index, hash, chunk.hash, m_file_name.c_str());
+		return false;
+	}
+
+	out.resize(raw_size);
+	switch (chunk.codec)
+	{
+	case DCZ_CODEC_NONE:
+		if (stored.size() != raw_size)
+			return false;
+		out.swap(stored);
+		return true;
+
+	case DCZ_CODEC_ZLIB:
+	{
+		uLongf out_size = raw_size;
+		return uncompress(out.data(), &out_size, stored.data(), (uLong)stored.size()) == Z_OK && out_size == raw_size;
+	}
+
+	case DCZ_CODEC_LZO:
+	{
+		lzo_uint out_size = raw_size;
+		return lzo1x_decompress_safe(stored.data(), stored.size(), out.data(), &out_size, nullptr) == LZO_E_OK &&
+		       out_size == raw_size;
+	}
+
+	default:
+		PanicAlert("Unknown codec %u in chunk %u of %s", chunk.codec, index, m_file_name.c_str());
+		return false;
+	}
+}
+
+const u8* DCZFileReader::GetChunk(u32 index, bool decrypted)
+{
+	const DCZChunk& chunk = m_chunks[index];
+	if (chunk.partition == NO_PARTITION)
+		decrypted = false;
+
+	CachedChunk* decrypted_entry = nullptr;
+	for (CachedChunk& entry : m_cache)
+	{
+		if (entry.index == index && entry.decrypted == decrypted)
+		{
+			entry.age = ++m_cache_age;
+			return entry.data.data();
+		}
+		if (entry.index == index && entry.decrypted)
+			decrypted_entry = &entry;
+	}
+
+	// Fetch the user data before picking a slot, which might evict it.
+	std::vector<u8> payload;
+	if (decrypted_entry)
+		payload = decrypted_entry->data;
+	else if (!LoadStoredData(index, payload))
+		return nullptr;
+
+	CachedChunk* slot;
+	if (m_cache.size() < CACHE_SIZE)
+	{
+		m_cache.emplace_back();
+		slot = &m_cache.back();
+	}
+	else
+	{
+		slot = &*std::min_element(m_cache.begin(), m_cache.end(),
+			[](const CachedChunk& a, const CachedChunk& b) { return a.age < b.age; });
+	}
+
+	slot->index = index;
+	slot->decrypted = decrypted;
+	slot->age = ++m_cache_age;
+	if (chunk.partition != NO_PARTITION && !decrypted)
+	{
+		slot->data.resize(GROUP_SIZE);
+		EncryptGroup(payload.data(), m_partitions[chunk.partition].key, slot->data.data());
+	}
+	else
+	{
+		slot->data.swap(payload);
+	}
+	return slot->data.data();
+}
+
+bool DCZFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
+{
+	while (nbytes > 0)
+	{
+		const u32 index = FindChunk(offset);
+		if (index == m_chunks.size())
+			return false;
+
+		const u8* data = GetChunk(index, false);
+		if (!data)
+			return false;
+
+		const DCZChunk& chunk = m_chunks[index];
+		const u64 offset_in_chunk = offset - chunk.disc_offset;
+		const u64 to_copy = std::min(nbytes, chunk.disc_size - offset_in_chunk);
+		memcpy(out_ptr, data + offset_in_chunk, (size_t)to_copy);
+
+		offset += to_copy;
+		out_ptr += to_copy;
+		nbytes -= to_copy;
+	}
+
+	return true;
+}
+
+bool DCZFileReader::ReadWiiDecrypted(u64 cluster_offset, u8* out_ptr)
+{
+	const u32 index = FindChunk(cluster_offset);
+	if (index == m_chunks.size() || m_chunks[index].partition == NO_PARTITION)
+		return false;
+
+	const u64 offset_in_chunk = cluster_offset - m_chunks[index].disc_offset;
+	if (offset_in_chunk % CLUSTER_SIZE)
+		return false;
+
+	const u8* data = GetChunk(index, true);
+	if (!data)
+		return false;
+
+	memcpy(out_ptr, data + offset_in_chunk / CLUSTER_SIZE * CLUSTER_DATA_SIZE, CLUSTER_DATA_SIZE);
+	return true;
+}
+
+bool IsDCZBlob(const std::string& filename)
+{
+	File::IOFile f(filename, "rb");
+
+	DCZHeader header;
+	return f.ReadArray(&header, 1) && header.magic_cookie == kDCZCookie && header.version == kDCZVersion;
+}
+
+static u32 ReadBE32(IBlobReader& reader, u64 offset)
+{
+	u32 value = 0;
+	reader.Read(offset, sizeof(value), (u8*)&value);
+	return Common::swap32(value);
+}
+
+// Finds the full groups of every partition of an encrypted Wii disc.
+static void FindWiiPartitions(IBlobReader& reader, std::vector<DCZPartition>& partitions)
+{
+	if (ReadBE32(reader, 0x18) != 0x5D1C9EA3 || ReadBE32(reader, 0x60) != 0)
+		return;
+
+	u8 region = 0;
+	reader.Read(0x3, 1, &region);
+
+	for (u32 group = 0; group < 4; group++)
+	{
+		const u32 count = ReadBE32(reader, 0x40000 + group * 8);
+		const u64 table = (u64)ReadBE32(reader, 0x40000 + group * 8 + 4) << 2;
+		if (count > 0x40)
+			continue;
+
+		for (u32 i = 0; i < count; i++)
+		{
+			const u64 offset = (u64)ReadBE32(reader, table + i * 8) << 2;
+
+			DCZPartition partition;
+			partition.data_offset = offset + ((u64)ReadBE32(reader, offset + 0x2b8) << 2);
+			partition.data_size = ((u64)ReadBE32(reader, offset + 0x2bc) << 2) / GROUP_SIZE * GROUP_SIZE;
+			if (partition.data_size == 0 || partition.data_offset + partition.data_size > reader.GetDataSize())
+				continue;
+
+			GetWiiPartitionKey(reader, offset, region == 'K', partition.key);
+			partitions.push_back(partition);
+		}
+	}
+
+	std::sort(partitions.begin(), partitions.end(),
+		[](const DCZPartition& a, const DCZPartition& b) { return a.data_offset < b.data_offset; });
+
+	// Guard against broken partition tables.
+	std::vector<DCZPartition> valid;
+	for (const DCZPartition& partition : partitions)
+	{
+		if (valid.size() == NO_PARTITION)
+			break;
+		if (valid.empty() || partition.data_offset >= valid.back().data_offset + valid.back().data_size)
+			valid.push_back(partition);
+	}
+	partitions.swap(valid);
+}
+
+static bool IsAllZero(const std::vector<u8>& data)
+{
+	return std::all_of(data.begin(), data.end(), [](u8 b) { return b == 0; });
+}
+
+static void ConvertChunk(DCZChunk& chunk, const std::vector<u8>& in, const std::vector<DCZPartition>& partitions,
+	DCZCodec codec, std::vector<u8>& out)
+{
+	std::vector<u8> decrypted;
+	const std::vector<u8>* raw = &in;
+	if (chunk.partition != NO_PARTITION)
+	{
+		const u8* key = partitions[chunk.partition].key;
+		decrypted.resize(GROUP_DATA_SIZE);
+		DecryptGroup(in.data(), key, decrypted.data());
+
+		// Only drop the hashes if they can be rebuilt exactly; some discs
+		// have junk in the padding of the hash blocks.
+		std::vector<u8> check(GROUP_SIZE);
+		EncryptGroup(decrypted.data(), key, check.data());
+		if (check == in)
+			raw = &decrypted;
+		else
+			chunk.partition = NO_PARTITION;
+	}
+
+	chunk.codec = DCZ_CODEC_NONE;
+	out.clear();
+	if (!IsAllZero(*raw))
+	{
+		switch (codec)
+		{
+		case DCZ_CODEC_ZLIB:
+		{
+			uLongf size = compressBound((uLong)raw->size());
+			out.resize(size);
+			if (compress2(out.data(), &size, raw->data(), (uLong)raw->size(), 9) == Z_OK)
+				out.resize(size);
+			else
+				out.clear();
+			break;
+		}
+
+		case DCZ_CODEC_LZO:
+		{
+			std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+			lzo_uint size = 0;
+			out.resize(raw->size() + raw->size() / 16 + 64 + 3);
+			if (lzo1x_1_compress(raw->data(), raw->size(), out.data(), &size, wrkmem.data()) == LZO_E_OK)
+				out.resize(size);
+			else
+				out.clear();
+			break;
+		}
+
+		default:
+			break;
+		}
+
+		if (!out.empty() && out.size() < raw->size())
+			chunk.codec = codec;
+		else
+			out = *raw;
+	}
+
+	chunk.stored_size = (u32)out.size();
+	chunk.hash = HashAdler32(out.data(), out.size());
+}
+
+bool CompressFileToDCZ(const std::string& infile, const std::string& outfile, DCZCodec codec,
+	CompressCB callback, void* arg)
+{
+	if (IsDCZBlob(infile))
+	{
+		PanicAlertT("%s is already compressed! Cannot compress it further.", infile.c_str());
+		return false;
+	}
+
+	std::unique_ptr<IBlobReader> reader(CreateBlobReader(infile));
+	File::IOFile f(outfile, "wb");
+	if (!reader || !f)
+		return false;
+
+	if (lzo_init() != LZO_E_OK)
+		return false;
+
+	DCZHeader header;
+	header.magic_cookie = kDCZCookie;
+	header.version = kDCZVersion;
+	header.data_size = reader->GetDataSize();
+
+	std::vector<DCZPartition> partitions;
+	FindWiiPartitions(*reader, partitions);
+
+	// Plain chunks everywhere except the full groups of the partitions.
+	std::vector<DCZChunk> chunks;
+	u64 position = 0;
+	auto add_chunks = [&](u64 end, u32 chunk_size, u8 partition) {
+		while (position < end)
+		{
+			DCZChunk chunk = {};
+			chunk.disc_offset = position;
+			chunk.disc_size = (u32)std::min<u64>(chunk_size, end - position);
+			chunk.partition = partition;
+			chunks.push_back(chunk);
+			position += chunk.disc_size;
+		}
+	};
+	for (size_t i = 0; i < partitions.size(); i++)
+	{
+		add_chunks(partitions[i].data_offset, CHUNK_SIZE, NO_PARTITION);
+		add_chunks(partitions[i].data_offset + partitions[i].data_size, GROUP_SIZE, (u8)i);
+	}
+	add_chunks(header.data_size, CHUNK_SIZE, NO_PARTITION);
+
+	header.num_partitions = (u32)partitions.size();
+	header.num_chunks = (u32)chunks.size();
+
+	// seek past the header and tables (we will write them at the end)
+	u64 file_offset = sizeof(DCZHeader) + partitions.size() * sizeof(DCZPartition) + chunks.size() * sizeof(DCZChunk);
+	f.Seek(file_offset, SEEK_SET);
+
+	// Chunks are read in batches, converted in parallel and written in order.
+	const unsigned int num_threads = std::max(cpu_info.num_cores, 1);
+	const size_t batch_size = num_threads * 2;
+	std::vector<std::vector<u8>> in(batch_size);
+	std::vector<std::vector<u8>> out(batch_size);
+	const u32 start_time = Common::Timer::GetTimeMs();
+
+	for (size_t first = 0; first < chunks.size(); first += batch_size)
+	{
+		if (callback)
+		{
+			const u64 done = chunks[first].disc_offset;
+			const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+			int ratio = done ? (int)(100 * (file_offset - sizeof(DCZHeader)) / done) : 0;
+			callback(StringFromFormat("%i of %i chunks. Compression ratio %i%%, %.1f MB/s", (int)first, (int)chunks.size(),
+				ratio, done / (1024.0 * 1024.0) * 1000 / elapsed), (float)done / header.data_size, arg);
+		}
+
+		const size_t count = std::min(batch_size, chunks.size() - first);
+		for (size_t i = 0; i < count; i++)
+		{
+			in[i].resize(chunks[first + i].disc_size);
+			if (!reader->Read(chunks[first + i].disc_offset, in[i].size(), in[i].data()))
+			{
+				ERROR_LOG(DISCIO, "Failed to read %s", infile.c_str());
+				return false;
+			}
+		}
+
+		std::vector<std::thread> workers;
+		for (unsigned int t = 0; t < std::min<size_t>(num_threads, count); t++)
+		{
+			workers.emplace_back([&, t] {
+				for (size_t i = t; i < count; i += num_threads)
+					ConvertChunk(chunks[first + i], in[i], partitions, codec, out[i]);
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			chunks[first + i].file_offset = file_offset;
+			if (!f.WriteBytes(out[i].data(), out[i].size()))
+			{
+				ERROR_LOG(DISCIO, "Failed to write %s", outfile.c_str());
+				return false;
+			}
+			file_offset += out[i].size();
+		}
+	}
+
+	f.Seek(0, SEEK_SET);
+	f.WriteArray(&header, 1);
+	f.WriteArray(partitions.data(), partitions.size());
+	f.WriteArray(chunks.data(), chunks.size());
+
+	const u32 elapsed = std::max<u32>(Common::Timer::GetTimeMs() - start_time, 1);
+	const size_t num_decrypted = std::count_if(chunks.begin(), chunks.end(),
+		[](const DCZChunk& chunk) { return chunk.partition != NO_PARTITION; });
+	NOTICE_LOG(DISCIO, "Converted %s to DCZ: %" PRIu64 " MB in %u ms (%.1f MB/s), %u of %u chunks stored decrypted",
+		infile.c_str(), file_offset >> 20, elapsed, header.data_size / (1024.0 * 1024.0) * 1000 / elapsed,
+		(u32)num_decrypted, header.num_chunks);
+
+	if (callback)
+		callback("Done compressing disc image.", 1.0f, arg);
+	return true;
+}
+
+}  // namespace
@@ -0,0 +1,113 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// WARNING Code not big-endian safe.
+
+// DCZ is a seekable compressed disc format. The disc is split into chunks,
+// each compressed on its own with the codec that suits it best. Chunks that
+// hold a whole group of 64 clusters of Wii partition data are stored
+// decrypted with their hashes dropped, which makes them compressible; the
+// hashes and encryption are rebuilt when the chunk is read.
+
+// File format
+// * DCZHeader
+// * DCZPartition[num_partitions]
+// * DCZChunk[num_chunks], sorted by disc offset
+// * [Data]
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+
+namespace DiscIO
+{
+
+bool IsDCZBlob(const std::string& filename);
+
+const u32 kDCZCookie = 0x315A4344; // "DCZ1"
+const u32 kDCZVersion = 1;
+
+enum DCZCodec
+{
+	DCZ_CODEC_NONE = 0, // stored as-is; all zeros if stored_size is 0
+	DCZ_CODEC_ZLIB = 1, // smallest files
+	DCZ_CODEC_LZO = 2,  // fastest reads
+};
+
+struct DCZHeader // 24 bytes
+{
+	u32 magic_cookie;
+	u32 version;
+	u64 data_size;
+	u32 num_partitions;
+	u32 num_chunks;
+};
+
+struct DCZPartition // 32 bytes
+{
+	u64 data_offset; // disc offset of the first decrypted group
+	u64 data_size;   // size of the decrypted groups on the disc
+	u8 key[16];
+};
+
+struct DCZChunk // 32 bytes
+{
+	u64 disc_offset;
+	u64 file_offset;
+	u32 disc_size;
+	u32 stored_size;
+	u32 hash; // Adler-32 of the stored data
+	u8 codec;
+	u8 partition; // NO_PARTITION unless stored decrypted
+	u16 pad;
+};
+
+class DCZFileReader : public IBlobReader
+{
+public:
+	static DCZFileReader* Create(const std::string& filename);
+
+	u64 GetDataSize() const override { return m_header.data_size; }
+	u64 GetRawSize() const override { return m_file_size; }
+	bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
+	bool ReadWiiDecrypted(u64 cluster_offset, u8* out_ptr) override;
+
+private:
+	DCZFileReader(const std::string& filename);
+
+	struct CachedChunk
+	{
+		u32 index;
+		bool decrypted;
+		u32 age;
+		std::vector<u8> data;
+	};
+
+	// Returns the index of the chunk holding the disc offset, or num_chunks.
+	u32 FindChunk(u64 offset) const;
+	// Returns the chunk's contents as on the disc, or, for decrypted chunks if
+	// asked, the decrypted user data. Valid until the next call.
+	const u8* GetChunk(u32 index, bool decrypted);
+	bool LoadStoredData(u32 index, std::vector<u8>& out);
+
+	DCZHeader m_header;
+	std::vector<DCZPartition> m_partitions;
+	std::vector<DCZChunk> m_chunks;
+	File::IOFile m_file;
+	u64 m_file_size;
+	std::string m_file_name;
+
+	std::vector<CachedChunk> m_cache;
+	u32 m_cache_age;
+};
+
+bool CompressFileToDCZ(const std::string& infile, const std::string& outfile, DCZCodec codec = DCZ_CODEC_ZLIB,
+	CompressCB callback = nullptr, void* arg = nullptr);
+
+}  // namespace
@@ -2,20 +2,36 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <memory>
 #include <string>
 #include "DiscIO/FileBlob.h"
 
 namespace DiscIO
 {
 
+// How far ahead of a sequential read the OS is asked to fetch pages.
+static const u64 READ_AHEAD_SIZE = 0x100000;
+
 PlainFileReader::PlainFileReader(std::FILE* file)
-	: m_file(file)
+	: m_file(file), m_last_read_end(0), m_readahead_end(0)
 {
 	m_size = m_file.GetSize();
 }
 
+PlainFileReader::PlainFileReader(std::unique_ptr<File::MappedFile> mapping)
+	: m_mapping(std::move(mapping)), m_last_read_end(0), m_readahead_end(0)
+{
+	m_size = m_mapping->GetSize();
+}
+
 PlainFileReader* PlainFileReader::Create(const std::string& filename)
 {
+	std::unique_ptr<File::MappedFile> mapping(new File::MappedFile);
+	if (mapping->Open(filename))
+		return new PlainFileReader(std::move(mapping));
+
+	// Empty files, and files too big for the address space, can't be mapped
 	File::IOFile f(filename, "rb");
 	if (f)
 		return new PlainFileReader(f.ReleaseHandle());
@@ -25,8 +41,28 @@ PlainFileReader* PlainFileReader::Create(const std::string& filename)
 
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
-	m_file.Seek(offset, SEEK_SET);
-	return m_file.ReadBytes(out_ptr, nbytes);
+	if (!m_mapping)
+	{
+		m_file.Seek(offset, SEEK_SET);
+		return m_file.ReadBytes(out_ptr, nbytes);
+	}
+
+	if (offset > (u64)m_size || nbytes > (u64)m_size - offset)
+		return false;
+
+	// Games mostly stream files front to back; once a read continues the
+	// previous one, have the OS fetch what comes next in the background so
+	// the copy below doesn't fault on every page.
+	const u64 end = offset + nbytes;
+	if (offset == m_last_read_end && end + READ_AHEAD_SIZE / 2 > m_readahead_end)
+	{
+		m_mapping->AdviseWillNeed(end, READ_AHEAD_SIZE);
+		m_readahead_end = end + READ_AHEAD_SIZE;
+	}
+	m_last_read_end = end;
+
+	memcpy(out_ptr, m_mapping->GetData() + offset, (size_t)nbytes);
+	return true;
 }
 
 }  // namespace
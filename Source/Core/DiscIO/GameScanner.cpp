@@ -0,0 +1,341 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/FileSearch.h"
+#include "Common/FileUtil.h"
+
+#include "DiscIO/BannerLoader.h"
+#include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DCZBlob.h"
+#include "DiscIO/Filesystem.h"
+#include "DiscIO/GameScanner.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
+
+namespace DiscIO
+{
+
+static const u32 CACHE_REVISION = 1;
+
+GameMetadata::GameMetadata()
+	: stamp_size(0)
+	, stamp_time(0)
+	, valid(false)
+	, platform(GAMECUBE_DISC)
+	, country(IVolume::COUNTRY_UNKNOWN)
+	, file_size(0)
+	, volume_size(0)
+	, compressed(false)
+	, disc_two(false)
+	, revision(0)
+	, banner_width(0)
+	, banner_height(0)
+{
+}
+
+void GameMetadata::DoState(PointerWrap& p)
+{
+	p.Do(file_name);
+	p.Do(stamp_size);
+	p.Do(stamp_time);
+	p.Do(valid);
+	p.Do(platform);
+	p.Do(volume_names);
+	p.Do(country);
+	p.Do(file_size);
+	p.Do(volume_size);
+	p.Do(unique_id);
+	p.Do(compressed);
+	p.Do(disc_two);
+	p.Do(revision);
+	p.Do(company);
+	p.Do(names);
+	p.Do(descriptions);
+	p.Do(banner);
+	p.Do(banner_width);
+	p.Do(banner_height);
+}
+
+GameMetadata ReadGameMetadata(const std::string& file_name)
+{
+	GameMetadata game;
+	game.file_name = file_name;
+
+	IVolume* pVolume = CreateVolumeFromFilename(file_name);
+	if (pVolume == nullptr)
+		return game;
+
+	if (!IsVolumeWadFile(pVolume))
+		game.platform = IsVolumeWiiDisc(pVolume) ? GameMetadata::WII_DISC : GameMetadata::GAMECUBE_DISC;
+	else
+		game.platform = GameMetadata::WII_WAD;
+
+	game.volume_names = pVolume->GetNames();
+	game.country = pVolume->GetCountry();
+	game.file_size = pVolume->GetRawSize();
+	game.volume_size = pVolume->GetSize();
+	game.unique_id = pVolume->GetUniqueID();
+	game.compressed = IsCompressedBlob(file_name) || IsDCZBlob(file_name);
+	game.disc_two = pVolume->IsDiscTwo();
+	game.revision = pVolume->GetRevision();
+
+	// check if we can get some info from the banner file too
+	IFileSystem* pFileSystem = CreateFileSystem(pVolume);
+
+	if (pFileSystem != nullptr || game.platform == GameMetadata::WII_WAD)
+	{
+		IBannerLoader* pBannerLoader = CreateBannerLoader(*pFileSystem, pVolume);
+
+		if (pBannerLoader != nullptr)
+		{
+			if (pBannerLoader->IsValid())
+			{
+				if (game.platform != GameMetadata::WII_WAD)
+					game.names = pBannerLoader->GetNames();
+				game.company = pBannerLoader->GetCompany();
+				game.descriptions = pBannerLoader->GetDescriptions();
+
+				std::vector<u32> Buffer = pBannerLoader->GetBanner(&game.banner_width, &game.banner_height);
+				const u32* pData = Buffer.data();
+				game.banner.resize(game.banner_width * game.banner_height * 3);
+
+				for (int i = 0; i < game.banner_width * game.banner_height; i++)
+				{
+					game.banner[i * 3 + 0] = (pData[i] & 0xFF0000) >> 16;
+					game.banner[i * 3 + 1] = (pData[i] & 0x00FF00) >> 8;
+					game.banner[i * 3 + 2] = (pData[i] & 0x0000FF) >> 0;
+				}
+			}
+			delete pBannerLoader;
+		}
+
+		delete pFileSystem;
+	}
+
+	delete pVolume;
+
+	game.valid = true;
+	return game;
+}
+
+std::vector<std::string> FindGameFiles(std::vector<std::string> directories, bool recursive,
+                                       const std::vector<std::string>& patterns)
+{
+	if (recursive)
+	{
+		// directories grows while we walk it
+		for (size_t i = 0; i < directories.size(); i++)
+		{
+			File::FSTEntry FST_Temp;
+			File::ScanDirectoryTree(directories[i], FST_Temp);
+			for (auto& Entry : FST_Temp.children)
+			{
+				if (Entry.isDirectory &&
+				    std::find(directories.begin(), directories.end(), Entry.physicalName) == directories.end())
+				{
+					directories.push_back(Entry.physicalName);
+				}
+			}
+		}
+	}
+
+	CFileSearch FileSearch(patterns, directories);
+	return FileSearch.GetFileNames();
+}
+
+GameScanner::GameScanner()
+	: m_dirty(false)
+{
+	m_stats = Stats();
+	LoadCache();
+}
+
+std::string GameScanner::GetCacheFilename()
+{
+	return File::GetUserPath(D_CACHE_IDX) + "GameList.cache";
+}
+
+void GameScanner::DoState(PointerWrap& p)
+{
+	u32 count = (u32)m_cache.size();
+	p.Do(count);
+
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		m_cache.clear();
+		for (u32 i = 0; i < count; i++)
+		{
+			GameMetadata game;
+			game.DoState(p);
+			m_cache[game.file_name] = game;
+		}
+	}
+	else
+	{
+		for (auto& entry : m_cache)
+			entry.second.DoState(p);
+	}
+}
+
+bool GameScanner::LoadCache()
+{
+	m_dirty = false;
+	if (!File::Exists(GetCacheFilename()))
+	{
+		m_cache.clear();
+		return false;
+	}
+
+	if (!CChunkFileReader::Load<GameScanner>(GetCacheFilename(), CACHE_REVISION, *this))
+	{
+		m_cache.clear();
+		return false;
+	}
+	return true;
+}
+
+bool GameScanner::SaveCache()
+{
+	if (!m_dirty)
+		return true;
+
+	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
+		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
+
+	if (!CChunkFileReader::Save<GameScanner>(GetCacheFilename(), CACHE_REVISION, *this))
+		return false;
+
+	m_dirty = false;
+	return true;
+}
+
+void GameScanner::ClearCache()
+{
+	m_cache.clear();
+	m_dirty = true;
+}
+
+std::vector<GameMetadata> GameScanner::Scan(const std::vector<std::string>& files, const ProgressCallback& progress)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_stats = Stats();
+
+	std::vector<GameMetadata> results(files.size());
+	std::vector<u8> finished(files.size(), 0);
+	std::atomic<u32> next(0);
+	std::atomic<u32> current(0);
+	std::atomic<u32> cached(0);
+	std::atomic<bool> cancel(false);
+	u32 num_done = 0;
+	std::mutex done_lock;
+	std::condition_variable done_cv;
+
+	// Opening images is mostly waiting on the disk, and decoding banners is
+	// cheap, so don't go below two threads even on single core machines.
+	const u32 num_threads = std::min<u32>(std::max(cpu_info.num_cores, 2), (u32)files.size());
+	std::vector<std::thread> workers;
+	for (u32 t = 0; t < num_threads; t++)
+	{
+		workers.emplace_back([&] {
+			u32 i;
+			while (!cancel && (i = next++) < files.size())
+			{
+				current = i;
+
+				u64 size = 0, time = 0;
+				File::GetSizeAndModifiedTime(files[i], size, time);
+
+				// Only this thread touches entry i, and m_cache isn't modified
+				// until all workers are done.
+				auto it = m_cache.find(files[i]);
+				if (it != m_cache.end() && it->second.stamp_size == size && it->second.stamp_time == time)
+				{
+					results[i] = it->second;
+					cached++;
+				}
+				else
+				{
+					results[i] = ReadGameMetadata(files[i]);
+					results[i].stamp_size = size;
+					results[i].stamp_time = time;
+				}
+
+				std::lock_guard<std::mutex> lk(done_lock);
+				finished[i] = 1;
+				num_done++;
+				done_cv.notify_one();
+			}
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> lk(done_lock);
+		while (num_done < files.size() && !cancel)
+		{
+			// Report progress at most every 50ms; warm scans finish thousands
+			// of files in that time.
+			done_cv.wait_for(lk, std::chrono::milliseconds(50), [&] { return num_done == files.size(); });
+			if (progress)
+			{
+				const u32 done = num_done;
+				const std::string& name = files[std::min<u32>(current, (u32)files.size() - 1)];
+				lk.unlock();
+				if (!progress(done, (u32)files.size(), name))
+					cancel = true;
+				lk.lock();
+			}
+		}
+	}
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	std::vector<GameMetadata> games;
+	games.reserve(files.size());
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (!finished[i])
+			continue;
+
+		if (!results[i].valid)
+			m_stats.invalid++;
+		games.push_back(results[i]);
+	}
+	m_stats.cached = cached;
+	m_stats.scanned = (u32)games.size() - m_stats.cached;
+
+	// Entries for files that are gone are only dropped after a full scan.
+	if (!cancel)
+	{
+		m_dirty = m_dirty || m_stats.scanned != 0 || m_cache.size() != games.size();
+		m_cache.clear();
+	}
+	else if (m_stats.scanned != 0)
+	{
+		m_dirty = true;
+	}
+	for (GameMetadata& game : games)
+		m_cache[game.file_name] = game;
+
+	m_stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	INFO_LOG(DISCIO, "Game scan: %u files (%u cached, %u read, %u invalid) in %.0f ms",
+	         (u32)games.size(), m_stats.cached, m_stats.scanned, m_stats.invalid, m_stats.seconds * 1000);
+
+	return games;
+}
+
+}  // namespace
@@ -0,0 +1,107 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Reads what the game list shows about each image without any UI. Images are
+// opened on worker threads, and the results are kept in a single cache file
+// in the user's cache directory, so only new or modified images are opened
+// again on the next scan.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "DiscIO/Volume.h"
+
+class PointerWrap;
+
+namespace DiscIO
+{
+
+struct GameMetadata
+{
+	enum
+	{
+		GAMECUBE_DISC = 0,
+		WII_DISC,
+		WII_WAD,
+	};
+
+	GameMetadata();
+	void DoState(PointerWrap& p);
+
+	std::string file_name;
+	// The image is scanned again when either of these changes
+	u64 stamp_size;
+	u64 stamp_time;
+
+	bool valid;
+	int platform;
+	std::vector<std::string> volume_names;
+	IVolume::ECountry country;
+	u64 file_size;
+	u64 volume_size;
+	std::string unique_id;
+	bool compressed;
+	bool disc_two;
+	int revision;
+
+	// Stuff from banner
+	std::string company;
+	std::vector<std::string> names;
+	std::vector<std::string> descriptions;
+	std::vector<u8> banner; // RGB
+	int banner_width;
+	int banner_height;
+};
+
+// Reads the metadata of a single image (or drive), uncached.
+GameMetadata ReadGameMetadata(const std::string& file_name);
+
+// Returns the files in the given directories (and their subdirectories if
+// recursive) matching any of the patterns, such as "*.iso".
+std::vector<std::string> FindGameFiles(std::vector<std::string> directories, bool recursive,
+                                       const std::vector<std::string>& patterns);
+
+class GameScanner
+{
+public:
+	struct Stats
+	{
+		u32 cached;  // unchanged since the last scan
+		u32 scanned; // opened and read
+		u32 invalid; // not a game
+		double seconds;
+	};
+
+	// Called on the thread running Scan. Returning false cancels the scan.
+	typedef std::function<bool(u32 done, u32 total, const std::string& file_name)> ProgressCallback;
+
+	GameScanner();
+
+	bool LoadCache();
+	bool SaveCache();
+	void ClearCache();
+
+	// Returns the metadata of the files, in the same order, reading only
+	// those that aren't in the cache or changed since. A cancelled scan
+	// returns the files finished so far.
+	std::vector<GameMetadata> Scan(const std::vector<std::string>& files, const ProgressCallback& progress = nullptr);
+
+	const Stats& GetStats() const { return m_stats; }
+
+	void DoState(PointerWrap& p);
+
+private:
+	static std::string GetCacheFilename();
+
+	std::map<std::string, GameMetadata> m_cache;
+	bool m_dirty;
+	Stats m_stats;
+};
+
+}  // namespace
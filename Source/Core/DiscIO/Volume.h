@@ -32,7 +32,19 @@ public:
 	virtual std::string GetApploaderDate() const = 0;
 	virtual bool SupportsIntegrityCheck() const { return false; }
 	virtual bool CheckIntegrity() const { return false; }
+
+	struct ReadBenchmark
+	{
+		u64 SequentialBytes;
+		double SequentialMBps;
+		u32 RandomReads;
+		double RandomMBps;
+	};
+	// Times sequential and random reads from a cold cache.
+	virtual bool BenchmarkReads(ReadBenchmark* Result) const { return false; }
 	virtual bool IsDiscTwo() const { return false; }
+	// True if Read is a plain copy out of a memory-mapped image.
+	virtual bool IsMemoryMapped() const { return false; }
 
 	enum ECountry
 	{
@@ -144,6 +144,31 @@ bool IsVolumeWadFile(const IVolume *_rVolume)
 	return (Common::swap32(MagicWord) == 0x00204973 || Common::swap32(MagicWord) == 0x00206962);
 }
 
+void GetWiiPartitionKey(IBlobReader& _rReader, u64 _PartitionOffset, bool Korean, u8* _pKey)
+{
+	CBlobBigEndianReader Reader(_rReader);
+
+	u8 SubKey[16];
+	_rReader.Read(_PartitionOffset + 0x1bf, 16, SubKey);
+
+	u8 IV[16];
+	memset(IV, 0, 16);
+	_rReader.Read(_PartitionOffset + 0x44c, 8, IV);
+
+	bool usingKoreanKey = false;
+	// Issue: 6813
+	// Magic value is at partition's offset + 0x1f1 (1byte)
+	// If encrypted with the Korean key, the magic value would be 1
+	// Otherwise it is zero
+	if (Korean && Reader.Read8(_PartitionOffset + 0x1f1) == 1)
+		usingKoreanKey = true;
+
+	aes_context AES_ctx;
+	aes_setkey_dec(&AES_ctx, (usingKoreanKey ? g_MasterKeyK : g_MasterKey), 128);
+
+	aes_crypt_cbc(&AES_ctx, AES_DECRYPT, 16, IV, SubKey, _pKey);
+}
+
 static IVolume* CreateVolumeFromCryptedWiiImage(IBlobReader& _rReader, u32 _PartitionGroup, u32 _VolumeType, u32 _VolumeNum, bool Korean)
 {
 	CBlobBigEndianReader Reader(_rReader);
@@ -191,26 +216,8 @@ static IVolume* CreateVolumeFromCryptedWiiImage(IBlobReader& _rReader, u32 _Part
 
 		if (rPartition.Type == _VolumeType || i == _VolumeNum)
 		{
-			u8 SubKey[16];
-			_rReader.Read(rPartition.Offset + 0x1bf, 16, SubKey);
-
-			u8 IV[16];
-			memset(IV, 0, 16);
-			_rReader.Read(rPartition.Offset + 0x44c, 8, IV);
-
-			bool usingKoreanKey = false;
-			// Issue: 6813
-			// Magic value is at partition's offset + 0x1f1 (1byte)
-			// If encrypted with the Korean key, the magic value would be 1
-			// Otherwise it is zero
-			if (Korean && Reader.Read8(rPartition.Offset + 0x1f1) == 1)
-				usingKoreanKey = true;
-
-			aes_context AES_ctx;
-			aes_setkey_dec(&AES_ctx, (usingKoreanKey ? g_MasterKeyK : g_MasterKey), 128);
-
 			u8 VolumeKey[16];
-			aes_crypt_cbc(&AES_ctx, AES_DECRYPT, 16, IV, SubKey, VolumeKey);
+			GetWiiPartitionKey(_rReader, rPartition.Offset, Korean, VolumeKey);
 
 			// -1 means the caller just wanted the partition with matching type
 			if ((int)_VolumeNum == -1 || i == _VolumeNum)
@@ -11,11 +11,14 @@
 namespace DiscIO
 {
 
+class IBlobReader;
 class IVolume;
 
 IVolume* CreateVolumeFromFilename(const std::string& _rFilename, u32 _PartitionGroup = 0, u32 _VolumeNum = -1);
 IVolume* CreateVolumeFromDirectory(const std::string& _rDirectory, bool _bIsWii, const std::string& _rApploader = "", const std::string& _rDOL = "");
 bool IsVolumeWiiDisc(const IVolume *_rVolume);
 bool IsVolumeWadFile(const IVolume *_rVolume);
+// Decrypts the title key of the Wii partition at the given disc offset.
+void GetWiiPartitionKey(IBlobReader& _rReader, u64 _PartitionOffset, bool Korean, u8* _pKey);
 
 } // namespace
@@ -162,6 +162,11 @@ bool CVolumeGC::IsDiscTwo() const
 	return discTwo;
 }
 
+bool CVolumeGC::IsMemoryMapped() const
+{
+	return m_pReader != nullptr && m_pReader->IsMemoryMapped();
+}
+
 auto CVolumeGC::GetStringDecoder(ECountry country) -> StringDecoder
 {
 	return (COUNTRY_JAPAN == country || COUNTRY_TAIWAN == country) ?
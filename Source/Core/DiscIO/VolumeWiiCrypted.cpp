@@ -2,33 +2,140 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <random>
 #include <string>
 #include <vector>
 #include <polarssl/aes.h>
 #include <polarssl/sha1.h>
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeGC.h"
 #include "DiscIO/VolumeWiiCrypted.h"
 
+// GCC only exposes the AES intrinsics when building with -maes, which CMake
+// sets for this file on x86.
+#if !defined(_M_GENERIC) && (defined(_MSC_VER) || defined(__AES__))
+#define USE_AESNI 1
+#include <wmmintrin.h>
+#endif
+
 namespace DiscIO
 {
 
+#ifdef USE_AESNI
+namespace AESNI
+{
+
+static __m128i ExpandKey(__m128i Key, __m128i KeyGenAssist)
+{
+	KeyGenAssist = _mm_shuffle_epi32(KeyGenAssist, _MM_SHUFFLE(3, 3, 3, 3));
+	Key = _mm_xor_si128(Key, _mm_slli_si128(Key, 4));
+	Key = _mm_xor_si128(Key, _mm_slli_si128(Key, 4));
+	Key = _mm_xor_si128(Key, _mm_slli_si128(Key, 4));
+	return _mm_xor_si128(Key, KeyGenAssist);
+}
+
+// Writes the 11 AES-128 round keys for decryption in the order aesdec uses them.
+static void SetKeyDec(const u8* Key, u8* RoundKeys)
+{
+	__m128i Enc[11];
+	Enc[0] = _mm_loadu_si128((const __m128i*)Key);
+	Enc[1] = ExpandKey(Enc[0], _mm_aeskeygenassist_si128(Enc[0], 0x01));
+	Enc[2] = ExpandKey(Enc[1], _mm_aeskeygenassist_si128(Enc[1], 0x02));
+	Enc[3] = ExpandKey(Enc[2], _mm_aeskeygenassist_si128(Enc[2], 0x04));
+	Enc[4] = ExpandKey(Enc[3], _mm_aeskeygenassist_si128(Enc[3], 0x08));
+	Enc[5] = ExpandKey(Enc[4], _mm_aeskeygenassist_si128(Enc[4], 0x10));
+	Enc[6] = ExpandKey(Enc[5], _mm_aeskeygenassist_si128(Enc[5], 0x20));
+	Enc[7] = ExpandKey(Enc[6], _mm_aeskeygenassist_si128(Enc[6], 0x40));
+	Enc[8] = ExpandKey(Enc[7], _mm_aeskeygenassist_si128(Enc[7], 0x80));
+	Enc[9] = ExpandKey(Enc[8], _mm_aeskeygenassist_si128(Enc[8], 0x1B));
+	Enc[10] = ExpandKey(Enc[9], _mm_aeskeygenassist_si128(Enc[9], 0x36));
+
+	_mm_storeu_si128((__m128i*)RoundKeys, Enc[10]);
+	for (int i = 1; i < 10; i++)
+		_mm_storeu_si128((__m128i*)(RoundKeys + i * 16), _mm_aesimc_si128(Enc[10 - i]));
+	_mm_storeu_si128((__m128i*)(RoundKeys + 10 * 16), Enc[0]);
+}
+
+// CBC decryption has no dependency between blocks, so keep several in flight
+// to hide the latency of aesdec.
+static void DecryptCBC(const u8* RoundKeys, const u8* IV, const u8* In, u8* Out, u32 Size)
+{
+	const int PARALLEL_BLOCKS = 8;
+
+	__m128i Keys[11];
+	for (int i = 0; i < 11; i++)
+		Keys[i] = _mm_loadu_si128((const __m128i*)(RoundKeys + i * 16));
+
+	__m128i Prev = _mm_loadu_si128((const __m128i*)IV);
+	const u32 NumBlocks = Size / 16;
+	u32 Block = 0;
+
+	for (; Block + PARALLEL_BLOCKS <= NumBlocks; Block += PARALLEL_BLOCKS)
+	{
+		__m128i Cipher[PARALLEL_BLOCKS];
+		__m128i State[PARALLEL_BLOCKS];
+		for (int i = 0; i < PARALLEL_BLOCKS; i++)
+		{
+			Cipher[i] = _mm_loadu_si128((const __m128i*)(In + (Block + i) * 16));
+			State[i] = _mm_xor_si128(Cipher[i], Keys[0]);
+		}
+		for (int Round = 1; Round < 10; Round++)
+		{
+			for (int i = 0; i < PARALLEL_BLOCKS; i++)
+				State[i] = _mm_aesdec_si128(State[i], Keys[Round]);
+		}
+		for (int i = 0; i < PARALLEL_BLOCKS; i++)
+		{
+			State[i] = _mm_aesdeclast_si128(State[i], Keys[10]);
+			_mm_storeu_si128((__m128i*)(Out + (Block + i) * 16), _mm_xor_si128(State[i], Prev));
+			Prev = Cipher[i];
+		}
+	}
+
+	for (; Block < NumBlocks; Block++)
+	{
+		const __m128i Cipher = _mm_loadu_si128((const __m128i*)(In + Block * 16));
+		__m128i State = _mm_xor_si128(Cipher, Keys[0]);
+		for (int Round = 1; Round < 10; Round++)
+			State = _mm_aesdec_si128(State, Keys[Round]);
+		State = _mm_aesdeclast_si128(State, Keys[10]);
+		_mm_storeu_si128((__m128i*)(Out + Block * 16), _mm_xor_si128(State, Prev));
+		Prev = Cipher;
+	}
+}
+
+}  // namespace
+#endif
+
 CVolumeWiiCrypted::CVolumeWiiCrypted(IBlobReader* _pReader, u64 _VolumeOffset,
 									 const unsigned char* _pVolumeKey)
 	: m_pReader(_pReader),
 	m_pBuffer(nullptr),
+	m_UseAESNI(false),
 	m_VolumeOffset(_VolumeOffset),
 	dataOffset(0x20000),
-	m_LastDecryptedBlockOffset(-1)
+	m_ClusterCacheTags(CLUSTER_CACHE_SIZE, (u64)-1),
+	m_ClusterCache(CLUSTER_CACHE_SIZE * 0x7C00)
 {
 	m_AES_ctx = new aes_context;
 	aes_setkey_dec(m_AES_ctx, _pVolumeKey, 128);
-	m_pBuffer = new u8[0x8000];
+	m_pBuffer = new u8[MAX_CLUSTER_RUN * 0x8000];
+
+#ifdef USE_AESNI
+	if (cpu_info.bAES)
+	{
+		AESNI::SetKeyDec(_pVolumeKey, m_AESNIRoundKeys);
+		m_UseAESNI = true;
+	}
+#endif
 }
 
 
@@ -54,6 +161,66 @@ bool CVolumeWiiCrypted::RAWRead( u64 _Offset, u64 _Length, u8* _pBuffer ) const
 	return true;
 }
 
+const u8* CVolumeWiiCrypted::GetCachedCluster(u64 Cluster) const
+{
+	const u32 Slot = (u32)(Cluster % CLUSTER_CACHE_SIZE);
+	if (m_ClusterCacheTags[Slot] != Cluster)
+		return nullptr;
+	return &m_ClusterCache[Slot * 0x7C00];
+}
+
+void CVolumeWiiCrypted::ClearClusterCache() const
+{
+	std::fill(m_ClusterCacheTags.begin(), m_ClusterCacheTags.end(), (u64)-1);
+}
+
+void CVolumeWiiCrypted::DecryptCBC(const u8* IV, const u8* In, u8* Out, u32 Size) const
+{
+#ifdef USE_AESNI
+	if (m_UseAESNI)
+	{
+		AESNI::DecryptCBC(m_AESNIRoundKeys, IV, In, Out, Size);
+		return;
+	}
+#endif
+
+	// aes_crypt_cbc updates the IV
+	unsigned char IVCopy[16];
+	memcpy(IVCopy, IV, 16);
+	aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, Size, IVCopy, In, Out);
+}
+
+bool CVolumeWiiCrypted::DecryptClusters(u64 FirstCluster, u64 NumClusters) const
+{
+	const u64 FirstOffset = m_VolumeOffset + dataOffset + FirstCluster * 0x8000;
+	const u32 FirstSlot = (u32)(FirstCluster % CLUSTER_CACHE_SIZE);
+
+	// Some blob formats store the data decrypted already
+	m_ClusterCacheTags[FirstSlot] = (u64)-1;
+	if (m_pReader->ReadWiiDecrypted(FirstOffset, &m_ClusterCache[FirstSlot * 0x7C00]))
+	{
+		m_ClusterCacheTags[FirstSlot] = FirstCluster;
+		return true;
+	}
+
+	if (!m_pReader->Read(FirstOffset, NumClusters * 0x8000, m_pBuffer))
+	{
+		return(false);
+	}
+
+	for (u64 i = 0; i < NumClusters; i++)
+	{
+		const u8* Raw = m_pBuffer + i * 0x8000;
+		const u32 Slot = (u32)((FirstCluster + i) % CLUSTER_CACHE_SIZE);
+
+		// The IV of the data is stored (encrypted) in the hash block
+		DecryptCBC(Raw + 0x3d0, Raw + 0x400, &m_ClusterCache[Slot * 0x7C00], 0x7C00);
+		m_ClusterCacheTags[Slot] = FirstCluster + i;
+	}
+
+	return true;
+}
+
 bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 {
 	if (m_pReader == nullptr)
@@ -63,30 +230,33 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 
 	while (_Length > 0)
 	{
-		static unsigned char IV[16];
-
 		// math block offset
 		u64 Block  = _ReadOffset / 0x7C00;
 		u64 Offset = _ReadOffset % 0x7C00;
 
-		// read current block
-		if (!m_pReader->Read(m_VolumeOffset + dataOffset + Block * 0x8000, 0x8000, m_pBuffer))
+		const u8* Cluster = GetCachedCluster(Block);
+		if (!Cluster)
 		{
-			return(false);
-		}
-
-		if (m_LastDecryptedBlockOffset != Block)
-		{
-			memcpy(IV, m_pBuffer + 0x3d0, 16);
-			aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x7C00, IV, m_pBuffer + 0x400, m_LastDecryptedBlock);
+			// Fetch the following uncached clusters of this read along with it
+			const u64 LastBlock = (_ReadOffset + _Length - 1) / 0x7C00;
+			u64 NumBlocks = 1;
+			while (NumBlocks < MAX_CLUSTER_RUN && Block + NumBlocks <= LastBlock &&
+			       !GetCachedCluster(Block + NumBlocks))
+			{
+				NumBlocks++;
+			}
 
-			m_LastDecryptedBlockOffset = Block;
+			if (!DecryptClusters(Block, NumBlocks))
+			{
+				return(false);
+			}
+			Cluster = GetCachedCluster(Block);
 		}
 
-		// copy the encrypted data
+		// copy the decrypted data
 		u64 MaxSizeToCopy = 0x7C00 - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, Cluster + Offset, (size_t)CopySize);
 
 		// increase buffers
 		_Length -= CopySize;
@@ -261,7 +431,7 @@ bool CVolumeWiiCrypted::CheckIntegrity() const
 			NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", clusterID);
 			return false;
 		}
-		aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x400, IV, clusterMDCrypted, clusterMD);
+		DecryptCBC(IV, clusterMDCrypted, clusterMD, 0x400);
 
 
 		// Some clusters have invalid data and metadata because they aren't
@@ -305,4 +475,55 @@ bool CVolumeWiiCrypted::CheckIntegrity() const
 	return true;
 }
 
+bool CVolumeWiiCrypted::BenchmarkReads(ReadBenchmark* Result) const
+{
+	// Roughly what games do: streaming a file in 32KiB requests, and seeking
+	// around for small files
+	const u32 SEQUENTIAL_READ_SIZE = 0x8000;
+	const u64 MAX_SEQUENTIAL_BYTES = 256 * 1024 * 1024;
+	const u32 RANDOM_READ_SIZE = 0x2000;
+	const u32 NUM_RANDOM_READS = 4096;
+
+	u32 partSizeDiv4;
+	RAWRead(m_VolumeOffset + 0x2BC, 4, (u8*)&partSizeDiv4);
+	const u64 partDataSize = (u64)Common::swap32(partSizeDiv4) * 4 / 0x8000 * 0x7C00;
+	if (partDataSize < RANDOM_READ_SIZE)
+		return false;
+
+	std::vector<u8> buffer(std::max(SEQUENTIAL_READ_SIZE, RANDOM_READ_SIZE));
+
+	ClearClusterCache();
+	const u64 sequentialBytes = std::min(partDataSize, MAX_SEQUENTIAL_BYTES) / SEQUENTIAL_READ_SIZE * SEQUENTIAL_READ_SIZE;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (u64 offset = 0; offset < sequentialBytes; offset += SEQUENTIAL_READ_SIZE)
+	{
+		if (!Read(offset, SEQUENTIAL_READ_SIZE, buffer.data()))
+			return false;
+	}
+	const double sequentialSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// Fixed seed, so runs are comparable
+	ClearClusterCache();
+	std::mt19937 rng(0x57494949);
+	std::uniform_int_distribution<u64> dist(0, (partDataSize - RANDOM_READ_SIZE) / 32);
+	start = std::chrono::high_resolution_clock::now();
+	for (u32 i = 0; i < NUM_RANDOM_READS; i++)
+	{
+		if (!Read(dist(rng) * 32, RANDOM_READ_SIZE, buffer.data()))
+			return false;
+	}
+	const double randomSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	ClearClusterCache();
+
+	Result->SequentialBytes = sequentialBytes;
+	Result->SequentialMBps = sequentialSeconds > 0 ? sequentialBytes / sequentialSeconds / (1024 * 1024) : 0;
+	Result->RandomReads = NUM_RANDOM_READS;
+	Result->RandomMBps = randomSeconds > 0 ? (double)NUM_RANDOM_READS * RANDOM_READ_SIZE / randomSeconds / (1024 * 1024) : 0;
+
+	NOTICE_LOG(DISCIO, "Read benchmark (%s): sequential %.1f MB/s, random %.1f MB/s",
+	           m_UseAESNI ? "AES-NI" : "polarssl", Result->SequentialMBps, Result->RandomMBps);
+	return true;
+}
+
 } // namespace
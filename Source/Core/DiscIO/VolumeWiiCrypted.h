@@ -38,18 +38,33 @@ public:
 
 	bool SupportsIntegrityCheck() const override { return true; }
 	bool CheckIntegrity() const override;
+	bool BenchmarkReads(ReadBenchmark* Result) const override;
 
 private:
+	// Decrypted clusters are kept in a direct-mapped cache, so a run of up to
+	// CLUSTER_CACHE_SIZE consecutive clusters never evicts itself.
+	static const u32 CLUSTER_CACHE_SIZE = 64;
+	// Runs of uncached clusters are read with a single blob read.
+	static const u32 MAX_CLUSTER_RUN = 16;
+
+	// Returns the decrypted data of the cluster, or nullptr if it isn't cached.
+	const u8* GetCachedCluster(u64 Cluster) const;
+	bool DecryptClusters(u64 FirstCluster, u64 NumClusters) const;
+	void DecryptCBC(const u8* IV, const u8* In, u8* Out, u32 Size) const;
+	void ClearClusterCache() const;
+
 	IBlobReader* m_pReader;
 
 	u8* m_pBuffer;
 	aes_context* m_AES_ctx;
+	bool m_UseAESNI;
+	u8 m_AESNIRoundKeys[11 * 16];
 
 	u64 m_VolumeOffset;
 	u64 dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[0x8000];
+	mutable std::vector<u64> m_ClusterCacheTags;
+	mutable std::vector<u8> m_ClusterCache;
 };
 
 } // namespace
@@ -196,6 +196,8 @@ void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 				std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.txt";
 				File::CreateFullPath(filename);
 				Profiler::WriteProfileResults(filename);
+				Profiler::WriteCollapsedProfile(File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.folded");
+				Profiler::WritePerfMap();
 
 				wxFileType* filetype = nullptr;
 				if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromExtension("txt")))
@@ -668,8 +668,8 @@ void CFrame::DoOpen(bool Boot)
 	wxString path = wxFileSelector(
 		_("Select the file to load"),
 		wxEmptyString, wxEmptyString, wxEmptyString,
-		_("All GC/Wii files (elf, dol, gcm, iso, wbfs, ciso, gcz, wad)") +
-		wxString::Format("|*.elf;*.dol;*.gcm;*.iso;*.wbfs;*.ciso;*.gcz;*.wad;*.dff;*.tmd|%s",
+		_("All GC/Wii files (elf, dol, gcm, iso, wbfs, ciso, gcz, dcz, wad)") +
+		wxString::Format("|*.elf;*.dol;*.gcm;*.iso;*.wbfs;*.ciso;*.gcz;*.dcz;*.wad;*.dff;*.tmd|%s",
 		wxGetTranslation(wxALL_FILES)),
 		wxFD_OPEN | wxFD_FILE_MUST_EXIST,
 		this);
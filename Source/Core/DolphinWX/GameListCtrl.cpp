@@ -54,6 +54,8 @@
 #include "Core/Boot/Boot.h"
 #include "Core/HW/DVDInterface.h"
 #include "DiscIO/Blob.h"
+#include "DiscIO/DCZBlob.h"
+#include "DiscIO/GameScanner.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeCreator.h"
 #include "DolphinWX/Frame.h"
@@ -491,34 +493,6 @@ void CGameListCtrl::ScanForISOs()
 {
 	ClearIsoFiles();
 
-	CFileSearch::XStringVector Directories(SConfig::GetInstance().m_ISOFolder);
-
-	if (SConfig::GetInstance().m_RecursiveISOFolder)
-	{
-		for (u32 i = 0; i < Directories.size(); i++)
-		{
-			File::FSTEntry FST_Temp;
-			File::ScanDirectoryTree(Directories[i], FST_Temp);
-			for (auto& Entry : FST_Temp.children)
-			{
-				if (Entry.isDirectory)
-				{
-					bool duplicate = false;
-					for (auto& Directory : Directories)
-					{
-						if (Directory == Entry.physicalName)
-						{
-							duplicate = true;
-							break;
-						}
-					}
-					if (!duplicate)
-						Directories.push_back(Entry.physicalName);
-				}
-			}
-		}
-	}
-
 	CFileSearch::XStringVector Extensions;
 
 	if (SConfig::GetInstance().m_ListGC)
@@ -528,13 +502,14 @@ void CGameListCtrl::ScanForISOs()
 		Extensions.push_back("*.iso");
 		Extensions.push_back("*.ciso");
 		Extensions.push_back("*.gcz");
+		Extensions.push_back("*.dcz");
 		Extensions.push_back("*.wbfs");
 	}
 	if (SConfig::GetInstance().m_ListWad)
 		Extensions.push_back("*.wad");
 
-	CFileSearch FileSearch(Extensions, Directories);
-	const CFileSearch::XStringVector& rFilenames = FileSearch.GetFileNames();
+	const std::vector<std::string> rFilenames = DiscIO::FindGameFiles(SConfig::GetInstance().m_ISOFolder,
+		SConfig::GetInstance().m_RecursiveISOFolder, Extensions);
 
 	if (rFilenames.size() > 0)
 	{
@@ -550,18 +525,26 @@ void CGameListCtrl::ScanForISOs()
 			wxPD_SMOOTH // - makes updates as small as possible (down to 1px)
 			);
 
-		for (u32 i = 0; i < rFilenames.size(); i++)
+		DiscIO::GameScanner scanner;
+		const std::vector<DiscIO::GameMetadata> games = scanner.Scan(rFilenames,
+			[&](u32 done, u32 total, const std::string& path)
 		{
 			std::string FileName;
-			SplitPath(rFilenames[i], nullptr, &FileName, nullptr);
+			SplitPath(path, nullptr, &FileName, nullptr);
 
-			// Update with the progress (i) and the message
-			dialog.Update(i, wxString::Format(_("Scanning %s"),
+			// Update with the progress and the message
+			dialog.Update(std::min<int>(done, (int)total - 1), wxString::Format(_("Scanning %s"),
 				StrToWxStr(FileName)));
-			if (dialog.WasCancelled())
-				break;
+			return !dialog.WasCancelled();
+		});
+		scanner.SaveCache();
+
+		for (const DiscIO::GameMetadata& game : games)
+		{
+			if (!game.valid)
+				continue;
 
-			auto iso_file = std::make_unique<GameListItem>(rFilenames[i]);
+			auto iso_file = std::make_unique<GameListItem>(game);
 
 			if (iso_file->IsValid())
 			{
@@ -1217,8 +1200,9 @@ void CGameListCtrl::OnCompressGCM(wxCommandEvent& WXUNUSED(event))
 				StrToWxStr(FilePath),
 				StrToWxStr(FileName) + ".gcz",
 				wxEmptyString,
-				_("All compressed GC/Wii ISO files (gcz)") +
-				wxString::Format("|*.gcz|%s", wxGetTranslation(wxALL_FILES)),
+				_("All compressed GC/Wii ISO files (gcz)") + "|*.gcz|" +
+				_("Seekable compressed GC/Wii ISO files (dcz)") +
+				wxString::Format("|*.dcz|%s", wxGetTranslation(wxALL_FILES)),
 				wxFD_SAVE,
 				this);
 		}
@@ -1247,6 +1231,9 @@ void CGameListCtrl::OnCompressGCM(wxCommandEvent& WXUNUSED(event))
 		if (iso->IsCompressed())
 			all_good = DiscIO::DecompressBlobToFile(iso->GetFileName(),
 			WxStrToStr(path), &CompressCB, &dialog);
+		else if (path.Lower().EndsWith(".dcz"))
+			all_good = DiscIO::CompressFileToDCZ(iso->GetFileName(),
+			WxStrToStr(path), DiscIO::DCZ_CODEC_ZLIB, &CompressCB, &dialog);
 		else
 			all_good = DiscIO::CompressFileToBlob(iso->GetFileName(),
 			WxStrToStr(path),
@@ -2,7 +2,6 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -13,11 +12,9 @@
 #include <wx/image.h>
 #include <wx/string.h>
 
-#include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/CommonPaths.h"
 #include "Common/FileUtil.h"
-#include "Common/Hash.h"
 #include "Common/IniFile.h"
 #include "Common/StringUtil.h"
 
@@ -25,102 +22,46 @@
 #include "Core/CoreParameter.h"
 #include "Core/Boot/Boot.h"
 
-#include "DiscIO/BannerLoader.h"
-#include "DiscIO/CompressedBlob.h"
-#include "DiscIO/Filesystem.h"
+#include "DiscIO/GameScanner.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeCreator.h"
 
 #include "DolphinWX/ISOFile.h"
 #include "DolphinWX/WxUtils.h"
 
-static const u32 CACHE_REVISION = 0x115;
-
 #define DVD_BANNER_WIDTH 96
 #define DVD_BANNER_HEIGHT 32
 
 GameListItem::GameListItem(const std::string& _rFileName)
-	: m_FileName(_rFileName)
-	, m_emu_state(0)
-	, m_FileSize(0)
-	, m_Revision(0)
-	, m_Valid(false)
-	, m_BlobCompressed(false)
-	, m_ImageWidth(0)
-	, m_ImageHeight(0)
 {
-	if (LoadFromCache())
-	{
-		m_Valid = true;
-	}
-	else
-	{
-		DiscIO::IVolume* pVolume = DiscIO::CreateVolumeFromFilename(_rFileName);
-
-		if (pVolume != nullptr)
-		{
-			if (!DiscIO::IsVolumeWadFile(pVolume))
-				m_Platform = DiscIO::IsVolumeWiiDisc(pVolume) ? WII_DISC : GAMECUBE_DISC;
-			else
-			{
-				m_Platform = WII_WAD;
-			}
-
-			m_volume_names = pVolume->GetNames();
-
-			m_Country = pVolume->GetCountry();
-			m_FileSize = pVolume->GetRawSize();
-			m_VolumeSize = pVolume->GetSize();
-
-			m_UniqueID = pVolume->GetUniqueID();
-			m_BlobCompressed = DiscIO::IsCompressedBlob(_rFileName);
-			m_IsDiscTwo = pVolume->IsDiscTwo();
-			m_Revision = pVolume->GetRevision();
-
-			// check if we can get some info from the banner file too
-			DiscIO::IFileSystem* pFileSystem = DiscIO::CreateFileSystem(pVolume);
-
-			if (pFileSystem != nullptr || m_Platform == WII_WAD)
-			{
-				DiscIO::IBannerLoader* pBannerLoader = DiscIO::CreateBannerLoader(*pFileSystem, pVolume);
-
-				if (pBannerLoader != nullptr)
-				{
-					if (pBannerLoader->IsValid())
-					{
-						if (m_Platform != WII_WAD)
-							m_names = pBannerLoader->GetNames();
-						m_company = pBannerLoader->GetCompany();
-						m_descriptions = pBannerLoader->GetDescriptions();
-
-						std::vector<u32> Buffer = pBannerLoader->GetBanner(&m_ImageWidth, &m_ImageHeight);
-						u32* pData = &Buffer[0];
-						// resize vector to image size
-						m_pImage.resize(m_ImageWidth * m_ImageHeight * 3);
-
-						for (int i = 0; i < m_ImageWidth * m_ImageHeight; i++)
-						{
-							m_pImage[i * 3 + 0] = (pData[i] & 0xFF0000) >> 16;
-							m_pImage[i * 3 + 1] = (pData[i] & 0x00FF00) >> 8;
-							m_pImage[i * 3 + 2] = (pData[i] & 0x0000FF) >> 0;
-						}
-					}
-					delete pBannerLoader;
-				}
-
-				delete pFileSystem;
-			}
-
-			delete pVolume;
-
-			m_Valid = true;
-
-			// Create a cache file only if we have an image.
-			// Wii isos create their images after you have generated the first savegame
-			if (!m_pImage.empty())
-				SaveToCache();
-		}
-	}
+	Init(DiscIO::ReadGameMetadata(_rFileName));
+}
+
+GameListItem::GameListItem(const DiscIO::GameMetadata& metadata)
+{
+	Init(metadata);
+}
+
+void GameListItem::Init(const DiscIO::GameMetadata& metadata)
+{
+	m_FileName = metadata.file_name;
+	m_volume_names = metadata.volume_names;
+	m_company = metadata.company;
+	m_names = metadata.names;
+	m_descriptions = metadata.descriptions;
+	m_UniqueID = metadata.unique_id;
+	m_emu_state = 0;
+	m_FileSize = metadata.file_size;
+	m_VolumeSize = metadata.volume_size;
+	m_Country = metadata.country;
+	m_Platform = metadata.platform;
+	m_Revision = metadata.revision;
+	m_Valid = metadata.valid;
+	m_BlobCompressed = metadata.compressed;
+	m_pImage = metadata.banner;
+	m_ImageWidth = metadata.banner_width;
+	m_ImageHeight = metadata.banner_height;
+	m_IsDiscTwo = metadata.disc_two;
 
 	if (IsValid())
 	{
@@ -157,58 +98,6 @@ GameListItem::~GameListItem()
 {
 }
 
-bool GameListItem::LoadFromCache()
-{
-	return CChunkFileReader::Load<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
-void GameListItem::SaveToCache()
-{
-	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
-	{
-		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
-	}
-
-	CChunkFileReader::Save<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
-void GameListItem::DoState(PointerWrap &p)
-{
-	p.Do(m_volume_names);
-	p.Do(m_company);
-	p.Do(m_names);
-	p.Do(m_descriptions);
-	p.Do(m_UniqueID);
-	p.Do(m_FileSize);
-	p.Do(m_VolumeSize);
-	p.Do(m_Country);
-	p.Do(m_BlobCompressed);
-	p.Do(m_pImage);
-	p.Do(m_ImageWidth);
-	p.Do(m_ImageHeight);
-	p.Do(m_Platform);
-	p.Do(m_IsDiscTwo);
-	p.Do(m_Revision);
-}
-
-std::string GameListItem::CreateCacheFilename()
-{
-	std::string Filename, LegalPathname, extension;
-	SplitPath(m_FileName, &LegalPathname, &Filename, &extension);
-
-	if (Filename.empty()) return Filename; // Disc Drive
-
-	// Filename.extension_HashOfFolderPath_Size.cache
-	// Append hash to prevent ISO name-clashing in different folders.
-	Filename.append(StringFromFormat("%s_%x_%" PRIx64 ".cache",
-		extension.c_str(), HashFletcher((const u8 *)LegalPathname.c_str(), LegalPathname.size()),
-		File::GetSize(m_FileName)));
-
-	std::string fullname(File::GetUserPath(D_CACHE_IDX));
-	fullname += Filename;
-	return fullname;
-}
-
 std::string GameListItem::GetCompany() const
 {
 	if (m_company.empty())
@@ -8,17 +8,20 @@
 #include <vector>
 
 #include "Common/Common.h"
+#include "DiscIO/GameScanner.h"
 #include "DiscIO/Volume.h"
 
 #if defined(HAVE_WX) && HAVE_WX
 #include <wx/image.h>
 #endif
 
-class PointerWrap;
 class GameListItem : NonCopyable
 {
 public:
+	// Reads the image right away; the game list gets its metadata from
+	// DiscIO::GameScanner instead.
 	GameListItem(const std::string& _rFileName);
+	GameListItem(const DiscIO::GameMetadata& metadata);
 	~GameListItem();
 
 	bool IsValid() const { return m_Valid; }
@@ -43,13 +46,11 @@ public:
 	const wxBitmap& GetBitmap() const { return m_Bitmap; }
 #endif
 
-	void DoState(PointerWrap &p);
-
 	enum
 	{
-		GAMECUBE_DISC = 0,
-		WII_DISC,
-		WII_WAD,
+		GAMECUBE_DISC = DiscIO::GameMetadata::GAMECUBE_DISC,
+		WII_DISC = DiscIO::GameMetadata::WII_DISC,
+		WII_WAD = DiscIO::GameMetadata::WII_WAD,
 		NUMBER_OF_PLATFORMS
 	};
 
@@ -85,8 +86,5 @@ private:
 	int m_ImageWidth, m_ImageHeight;
 	bool m_IsDiscTwo;
 
-	bool LoadFromCache();
-	void SaveToCache();
-
-	std::string CreateCacheFilename();
+	void Init(const DiscIO::GameMetadata& metadata);
 };
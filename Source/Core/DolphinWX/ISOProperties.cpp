@@ -122,6 +122,7 @@ EVT_MENU(IDM_EXTRACTALL, CISOProperties::OnExtractDir)
 EVT_MENU(IDM_EXTRACTAPPLOADER, CISOProperties::OnExtractDataFromHeader)
 EVT_MENU(IDM_EXTRACTDOL, CISOProperties::OnExtractDataFromHeader)
 EVT_MENU(IDM_CHECKINTEGRITY, CISOProperties::CheckPartitionIntegrity)
+EVT_MENU(IDM_BENCHMARKREADS, CISOProperties::BenchmarkPartitionReads)
 EVT_CHOICE(ID_LANG, CISOProperties::OnChangeBannerLang)
 END_EVENT_TABLE()
 
@@ -721,6 +722,7 @@ void CISOProperties::OnRightClickOnTree(wxTreeEvent& event)
 	{
 		popupMenu->AppendSeparator();
 		popupMenu->Append(IDM_CHECKINTEGRITY, _("Check Partition Integrity"));
+		popupMenu->Append(IDM_BENCHMARKREADS, _("Benchmark Partition Reads"));
 	}
 
 	PopupMenu(popupMenu);
@@ -1002,6 +1004,67 @@ void CISOProperties::CheckPartitionIntegrity(wxCommandEvent& event)
 	}
 }
 
+class ReadBenchmarkThread : public wxThread
+{
+public:
+	ReadBenchmarkThread(const WiiPartition& Partition, DiscIO::IVolume::ReadBenchmark* Result)
+		: wxThread(wxTHREAD_JOINABLE), m_Partition(Partition), m_Result(Result)
+	{
+		Create();
+	}
+
+	virtual ExitCode Entry() override
+	{
+		return (ExitCode)m_Partition.Partition->BenchmarkReads(m_Result);
+	}
+
+private:
+	const WiiPartition& m_Partition;
+	DiscIO::IVolume::ReadBenchmark* m_Result;
+};
+
+void CISOProperties::BenchmarkPartitionReads(wxCommandEvent& event)
+{
+	if (!DiscIO::IsVolumeWiiDisc(OpenISO))
+		return;
+
+	wxString PartitionName = m_Treectrl->GetItemText(m_Treectrl->GetSelection());
+	if (!PartitionName)
+		return;
+
+	int PartitionNum = wxAtoi(PartitionName.Mid(PartitionName.find_first_of("0123456789"), 1));
+	const WiiPartition& Partition = WiiDisc[PartitionNum];
+
+	wxProgressDialog dialog(_("Benchmarking reads..."), _("Working..."), 1000, this,
+		wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_SMOOTH
+		);
+
+	DiscIO::IVolume::ReadBenchmark Result;
+	ReadBenchmarkThread thread(Partition, &Result);
+	thread.Run();
+
+	while (thread.IsAlive())
+	{
+		dialog.Pulse();
+		wxThread::Sleep(50);
+	}
+
+	dialog.Destroy();
+
+	if (!thread.Wait())
+	{
+		wxMessageBox(wxString::Format(_("Could not read partition %d."), PartitionNum),
+			_("Read Benchmark"), wxOK | wxICON_ERROR, this);
+	}
+	else
+	{
+		wxMessageBox(
+			wxString::Format(_("Sequential: %.1f MB/s (%u MiB)\nRandom: %.1f MB/s (%u reads)"),
+			Result.SequentialMBps, (u32)(Result.SequentialBytes / (1024 * 1024)), Result.RandomMBps, Result.RandomReads),
+			_("Read Benchmark"), wxOK | wxICON_INFORMATION, this);
+	}
+}
+
 void CISOProperties::SetRefresh(wxCommandEvent& event)
 {
 	bRefreshList = true;
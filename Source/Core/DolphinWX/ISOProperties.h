@@ -175,6 +175,7 @@ private:
 		IDM_EXTRACTAPPLOADER,
 		IDM_EXTRACTDOL,
 		IDM_CHECKINTEGRITY,
+		IDM_BENCHMARKREADS,
 		IDM_BNRSAVEAS
 	};
 
@@ -196,6 +197,7 @@ private:
 	void OnExtractDir(wxCommandEvent& event);
 	void OnExtractDataFromHeader(wxCommandEvent& event);
 	void CheckPartitionIntegrity(wxCommandEvent& event);
+	void BenchmarkPartitionReads(wxCommandEvent& event);
 	void SetRefresh(wxCommandEvent& event);
 	void OnChangeBannerLang(wxCommandEvent& event);
 	void PHackButtonClicked(wxCommandEvent& event);
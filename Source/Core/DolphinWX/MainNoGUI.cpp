@@ -8,9 +8,14 @@
 #include <cstring>
 #include <getopt.h>
 #include <string>
+#include <vector>
+
+#include "AudioCommon/DPL2Decoder.h"
+#include "AudioCommon/Mixer.h"
 
 #include "Common/Common.h"
 #include "Common/Event.h"
+#include "Common/FileUtil.h"
 #include "Common/Logging/LogManager.h"
 
 #include "Core/BootManager.h"
@@ -20,7 +25,11 @@
 #include "Core/HW/Wiimote.h"
 #include "Core/PowerPC/PowerPC.h"
 
+#include "DiscIO/GameScanner.h"
+
+#include "VideoCommon/ShaderList.h"
 #include "VideoCommon/VideoBackendBase.h"
+#include "VideoCommon/VideoConfig.h"
 
 #if HAVE_X11
 #include <X11/keysym.h>
@@ -286,6 +295,78 @@ void Wayland_MainLoop()
 }
 #endif
 
+// Scans the configured ISO folders twice, without and with the metadata
+// cache, to measure how long building the game list takes.
+static int ScanGames()
+{
+	std::vector<std::string> Extensions;
+	Extensions.push_back("*.gcm");
+	Extensions.push_back("*.iso");
+	Extensions.push_back("*.ciso");
+	Extensions.push_back("*.gcz");
+	Extensions.push_back("*.dcz");
+	Extensions.push_back("*.wbfs");
+	Extensions.push_back("*.wad");
+
+	const std::vector<std::string> files = DiscIO::FindGameFiles(SConfig::GetInstance().m_ISOFolder,
+		SConfig::GetInstance().m_RecursiveISOFolder, Extensions);
+
+	DiscIO::GameScanner scanner;
+	scanner.ClearCache();
+	for (const char* pass : { "cold", "warm" })
+	{
+		scanner.Scan(files);
+		const DiscIO::GameScanner::Stats& stats = scanner.GetStats();
+		fprintf(stderr, "%s scan: %u files (%u cached, %u read, %u invalid) in %.1f ms\n", pass,
+			(unsigned)files.size(), stats.cached, stats.scanned, stats.invalid, stats.seconds * 1000);
+	}
+
+	return scanner.SaveCache() ? 0 : 1;
+}
+
+// Generates the OpenGL source of every shader in a recorded shader list, given
+// either the list file or the game's ID, to measure the shader generators.
+static int GenerateShaders(const std::string& list, const std::string& dump_dir)
+{
+	const std::string filename = File::Exists(list) ? list : ShaderList::GetFilename(list);
+	std::vector<ShaderList::Entry> entries;
+	if (!ShaderList::Load(filename, entries))
+	{
+		fprintf(stderr, "Can't read the shader list %s\n", filename.c_str());
+		return 1;
+	}
+
+	g_Config.Load((File::GetUserPath(D_CONFIG_IDX) + "gfx_opengl.ini").c_str());
+	g_Config.backend_info.APIType = API_OPENGL;
+	UpdateActiveConfig();
+
+	const ShaderList::GenerateStats stats = ShaderList::GenerateAll(entries, API_OPENGL, dump_dir);
+	fprintf(stderr, "%u draws: %u pixel and %u vertex shaders, %.1f KiB of source in %.1f ms (%.0f shaders/s)\n",
+		(unsigned)entries.size(), stats.pixel_shaders, stats.vertex_shaders, stats.bytes / 1024.0,
+		stats.seconds * 1000, stats.seconds > 0 ? (stats.pixel_shaders + stats.vertex_shaders) / stats.seconds : 0.0);
+	return 0;
+}
+
+// Times mixing synthetic 32 kHz DMA and 48 kHz streaming audio with both
+// resamplers, and decoding it to surround.
+static int BenchmarkMixer()
+{
+	const unsigned int blocks = 10000;
+	for (bool polyphase : { false, true })
+	{
+		const CMixer::BenchmarkResult result = CMixer::Benchmark(polyphase, blocks);
+		fprintf(stderr, "%s resampler: %.2f us per 10 ms of audio (%u blocks)\n", polyphase ? "polyphase" : "linear",
+			result.seconds * 1000000 / result.blocks, result.blocks);
+	}
+	for (bool scalar : { true, false })
+	{
+		const unsigned int seconds = 60;
+		fprintf(stderr, "%s DPL2 decoder: %.2f ms per second of audio\n", scalar ? "scalar" : "SSE",
+			DPL2Benchmark(scalar, seconds) * 1000 / seconds);
+	}
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
 #ifdef __APPLE__
@@ -295,20 +376,37 @@ int main(int argc, char* argv[])
 	[NSApp activateIgnoringOtherApps : YES];
 	[NSApp finishLaunching];
 #endif
-	int ch, help = 0;
+	int ch, help = 0, scan_games = 0, bench_mixer = 0;
+	std::string gen_shaders, dump_shaders;
 	struct option longopts[] = {
 			{ "exec", no_argument, nullptr, 'e' },
 			{ "help", no_argument, nullptr, 'h' },
 			{ "version", no_argument, nullptr, 'v' },
+			{ "scan-games", no_argument, nullptr, 's' },
+			{ "gen-shaders", required_argument, nullptr, 'g' },
+			{ "dump-shaders", required_argument, nullptr, 'd' },
+			{ "bench-mixer", no_argument, nullptr, 'b' },
 			{ nullptr, 0, nullptr, 0 }
 	};
 
-	while ((ch = getopt_long(argc, argv, "eh?v", longopts, 0)) != -1)
+	while ((ch = getopt_long(argc, argv, "eh?vsg:d:b", longopts, 0)) != -1)
 	{
 		switch (ch)
 		{
 		case 'e':
 			break;
+		case 's':
+			scan_games = 1;
+			break;
+		case 'g':
+			gen_shaders = optarg;
+			break;
+		case 'd':
+			dump_shaders = optarg;
+			break;
+		case 'b':
+			bench_mixer = 1;
+			break;
 		case 'h':
 		case '?':
 			help = 1;
@@ -319,19 +417,48 @@ int main(int argc, char* argv[])
 		}
 	}
 
-	if (help == 1 || argc == optind)
+	if (help == 1 || (argc == optind && !scan_games && !bench_mixer && gen_shaders.empty()))
 	{
 		fprintf(stderr, "%s\n\n", scm_rev_str);
 		fprintf(stderr, "A multi-platform GameCube/Wii emulator\n\n");
-		fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v]\n", argv[0]);
+		fprintf(stderr, "Usage: %s [-e <file>] [-h] [-v] [-s] [-g <list> [-d <dir>]] [-b]\n", argv[0]);
 		fprintf(stderr, "  -e, --exec   Load the specified file\n");
 		fprintf(stderr, "  -h, --help   Show this help message\n");
 		fprintf(stderr, "  -v, --help   Print version and exit\n");
+		fprintf(stderr, "  -s, --scan-games   Time a cold and a warm scan of the game list\n");
+		fprintf(stderr, "  -g, --gen-shaders  Time generating the shaders of a shader list file or game ID\n");
+		fprintf(stderr, "  -d, --dump-shaders Write the shaders generated by -g to a directory\n");
+		fprintf(stderr, "  -b, --bench-mixer  Time the audio mixer and DPL2 decoder\n");
 		return 1;
 	}
 
 	LogManager::Init();
 	SConfig::Init();
+
+	if (scan_games)
+	{
+		const int result = ScanGames();
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
+	if (bench_mixer)
+	{
+		const int result = BenchmarkMixer();
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
+	if (!gen_shaders.empty())
+	{
+		const int result = GenerateShaders(gen_shaders, dump_shaders);
+		SConfig::Shutdown();
+		LogManager::Shutdown();
+		return result;
+	}
+
 	VideoBackend::PopulateList();
 	VideoBackend::ActivateBackend(SConfig::GetInstance().
 		m_LocalCoreStartupParameter.m_strVideoBackend);
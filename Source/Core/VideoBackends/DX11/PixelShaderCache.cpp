@@ -4,6 +4,7 @@
 
 #include "Common/FileUtil.h"
 #include "Common/LinearDiskCache.h"
+#include "Common/Timeline.h"
 
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/Statistics.h"
@@ -352,16 +353,6 @@ ID3D11Buffer* &PixelShaderCache::GetConstantBuffer()
 	return pscbuf;
 }
 
-// this class will load the precompiled shaders into our cache
-class PixelShaderCacheInserter : public LinearDiskCacheReader<PixelShaderUid, u8>
-{
-public:
-	void Read(const PixelShaderUid &key, const u8 *value, u32 value_size)
-	{
-		PixelShaderCache::InsertByteCode(key, value, value_size);
-	}
-};
-
 void PixelShaderCache::Init()
 {
 	unsigned int cbsize = ((sizeof(psconstants))&(~0xf))+0x10; // must be a multiple of 16
@@ -401,11 +392,8 @@ void PixelShaderCache::Init()
 	char cache_filename[MAX_PATH];
 	sprintf(cache_filename, "%sdx11-%s-ps.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 			SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
-	PixelShaderCacheInserter inserter;
-	g_ps_disk_cache.OpenAndRead(cache_filename, inserter);
-
-	if (g_Config.bEnableShaderDebugging)
-		Clear();
+	// Shaders are only created when SetShader first asks for them.
+	g_ps_disk_cache.Open(cache_filename);
 
 	last_entry = NULL;
 }
@@ -452,6 +440,7 @@ void PixelShaderCache::Shutdown()
 
 bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 {
+	TIMELINE_ZONE("Shader lookup");
 	PixelShaderUid uid;
 	GetPixelShaderUidD3D11(uid, dstAlphaMode, components);
 	if (g_ActiveConfig.bEnableShaderDebugging)
@@ -485,6 +474,19 @@ bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 		return (entry.shader != NULL);
 	}
 
+	// Try the shaders compiled in earlier runs. When debugging shaders, they
+	// are compiled again to keep their code.
+	if (!g_ActiveConfig.bEnableShaderDebugging)
+	{
+		u32 bytecodelen;
+		const u8* bytecode = g_ps_disk_cache.Lookup(uid, &bytecodelen);
+		if (bytecode && InsertByteCode(uid, bytecode, bytecodelen))
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+			return true;
+		}
+	}
+
 	// Need to compile a new shader
 	ShaderCode code;
 	GeneratePixelShaderCodeD3D11(code, dstAlphaMode, components);
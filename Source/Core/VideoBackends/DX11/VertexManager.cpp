@@ -213,6 +213,15 @@ void VertexManager::Draw(UINT stride)
 		((DX11::Renderer*)g_renderer)->RestoreCull();
 }
 
+void VertexManager::PrepareShaders(u32 components)
+{
+	bool useDstAlpha = !g_ActiveConfig.bDstAlphaPass && bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate &&
+		bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24;
+
+	PixelShaderCache::SetShader(useDstAlpha ? DSTALPHA_DUAL_SOURCE_BLEND : DSTALPHA_NONE, components);
+	VertexShaderCache::SetShader(components);
+}
+
 void VertexManager::vFlush()
 {
 	u32 usedtextures = 0;
@@ -21,6 +21,7 @@ public:
 	NativeVertexFormat* CreateNativeVertexFormat();
 	void CreateDeviceObjects();
 	void DestroyDeviceObjects();
+	void PrepareShaders(u32 components);
 
 private:
 	
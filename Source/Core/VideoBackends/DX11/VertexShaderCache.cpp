@@ -4,6 +4,7 @@
 
 #include "Common/FileUtil.h"
 #include "Common/LinearDiskCache.h"
+#include "Common/Timeline.h"
 
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/Statistics.h"
@@ -57,19 +58,6 @@ ID3D11Buffer* &VertexShaderCache::GetConstantBuffer()
 	return vscbuf;
 }
 
-// this class will load the precompiled shaders into our cache
-class VertexShaderCacheInserter : public LinearDiskCacheReader<VertexShaderUid, u8>
-{
-public:
-	void Read(const VertexShaderUid &key, const u8 *value, u32 value_size)
-	{
-		D3DBlob* blob = new D3DBlob(value_size, value);
-		VertexShaderCache::InsertByteCode(key, blob);
-		blob->Release();
-
-	}
-};
-
 const char simple_shader_code[] = {
 	"struct VSOUTPUT\n"
 	"{\n"
@@ -163,11 +151,8 @@ void VertexShaderCache::Init()
 	char cache_filename[MAX_PATH];
 	sprintf(cache_filename, "%sdx11-%s-vs.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 			SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
-	VertexShaderCacheInserter inserter;
-	g_vs_disk_cache.OpenAndRead(cache_filename, inserter);
-
-	if (g_Config.bEnableShaderDebugging)
-		Clear();
+	// Shaders are only created when SetShader first asks for them.
+	g_vs_disk_cache.Open(cache_filename);
 
 	last_entry = NULL;
 }
@@ -199,6 +184,7 @@ void VertexShaderCache::Shutdown()
 
 bool VertexShaderCache::SetShader(u32 components)
 {
+	TIMELINE_ZONE("Shader lookup");
 	VertexShaderUid uid;
 	GetVertexShaderUidD3D11(uid, components);
 	if (g_ActiveConfig.bEnableShaderDebugging)
@@ -229,6 +215,25 @@ bool VertexShaderCache::SetShader(u32 components)
 		return (entry.shader != NULL);
 	}
 
+	// Try the shaders compiled in earlier runs. When debugging shaders, they
+	// are compiled again to keep their code.
+	if (!g_ActiveConfig.bEnableShaderDebugging)
+	{
+		u32 bytecodelen;
+		const u8* bytecode = g_vs_disk_cache.Lookup(uid, &bytecodelen);
+		if (bytecode)
+		{
+			D3DBlob* blob = new D3DBlob(bytecodelen, bytecode);
+			bool success = InsertByteCode(uid, blob);
+			blob->Release();
+			if (success)
+			{
+				GFX_DEBUGGER_PAUSE_AT(NEXT_VERTEX_SHADER_CHANGE, true);
+				return true;
+			}
+		}
+	}
+
 	ShaderCode code;
 	GenerateVertexShaderCodeD3D11(code, components);
 
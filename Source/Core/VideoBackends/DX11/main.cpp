@@ -16,6 +16,7 @@
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexShaderManager.h"
+#include "VideoCommon/ShaderList.h"
 #include "Core/Core.h"
 #include "Core/Host.h"
 
@@ -205,6 +206,7 @@ void VideoBackend::Video_Prepare()
 	CommandProcessor::Init();
 	PixelEngine::Init();
 	DLCache::Init();
+	ShaderList::Init();
 
 	// Tell the host that the window is ready
 	Host_Message(WM_USER_CREATE);
@@ -223,6 +225,7 @@ void VideoBackend::Shutdown()
 
 		// VideoCommon
 		DLCache::Shutdown();
+		ShaderList::Shutdown();
 		Fifo_Shutdown();
 		CommandProcessor::Shutdown();
 		PixelShaderManager::Shutdown();
@@ -9,6 +9,7 @@
 #include "Common/Hash.h"
 #include "Common/FileUtil.h"
 #include "Common/LinearDiskCache.h"
+#include "Common/Timeline.h"
 
 #include "Globals.h"
 #include "D3DBase.h"
@@ -55,15 +56,6 @@ static LPDIRECT3DPIXELSHADER9 s_ClearProgram = NULL;
 static LPDIRECT3DPIXELSHADER9 s_rgba6_to_rgb8 = NULL;
 static LPDIRECT3DPIXELSHADER9 s_rgb8_to_rgba6 = NULL;
 
-class PixelShaderCacheInserter : public LinearDiskCacheReader<PixelShaderUid, u8>
-{
-public:
-	void Read(const PixelShaderUid &key, const u8 *value, u32 value_size)
-	{
-		PixelShaderCache::InsertByteCode(key, value, value_size, false);
-	}
-};
-
 LPDIRECT3DPIXELSHADER9 PixelShaderCache::GetColorMatrixProgram(int SSAAMode)
 {
 	return s_CopyProgram[COPY_TYPE_MATRIXCOLOR][DEPTH_CONVERSION_TYPE_NONE][SSAAMode % MAX_SSAA_SHADERS];
@@ -276,11 +268,8 @@ void PixelShaderCache::Init()
 	char cache_filename[MAX_PATH];
 	sprintf(cache_filename, "%sdx9-%s-ps.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 		SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
-	PixelShaderCacheInserter inserter;
-	g_ps_disk_cache.OpenAndRead(cache_filename, inserter);
-
-	if (g_Config.bEnableShaderDebugging)
-		Clear();
+	// Shaders are only created when SetShader first asks for them.
+	g_ps_disk_cache.Open(cache_filename);
 }
 
 // ONLY to be used during shutdown.
@@ -325,6 +314,7 @@ void PixelShaderCache::Shutdown()
 
 bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 {
+	TIMELINE_ZONE("Shader lookup");
 	const API_TYPE api = ((D3D::GetCaps().PixelShaderVersion >> 8) & 0xFF) < 3 ? API_D3D9_SM20 : API_D3D9_SM30;
 	PixelShaderUid uid;
 	GetPixelShaderUidD3D9(uid, dstAlphaMode, components);
@@ -360,6 +350,18 @@ bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 		return (entry.shader != NULL);
 	}
 
+	// Try the shaders compiled in earlier runs. When debugging shaders, they
+	// are compiled again to keep their code.
+	if (!g_ActiveConfig.bEnableShaderDebugging)
+	{
+		u32 bytecodelen;
+		const u8* bytecode = g_ps_disk_cache.Lookup(uid, &bytecodelen);
+		if (bytecode && InsertByteCode(uid, bytecode, bytecodelen, true))
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+			return true;
+		}
+	}
 
 	// Need to compile a new shader
 	ShaderCode code;
@@ -385,7 +387,7 @@ bool PixelShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components)
 		char szTemp[MAX_PATH];
 		sprintf(szTemp, "%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
 
-		SaveData(szTemp, code.GetBuffer());
+		ImageWriter::QueueData(szTemp, code.GetBuffer());
 	}
 #endif
 
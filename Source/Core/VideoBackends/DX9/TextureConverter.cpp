@@ -132,7 +132,7 @@ LPDIRECT3DPIXELSHADER9 GetOrCreateEncodingShader(u32 format)
 			char szTemp[MAX_PATH];
 			sprintf(szTemp, "%senc_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
 
-			SaveData(szTemp, shader);
+			ImageWriter::QueueData(szTemp, shader);
 		}
 #endif
 		s_encodingPrograms[format] = D3D::CompileAndCreatePixelShader(shader, (int)strlen(shader));
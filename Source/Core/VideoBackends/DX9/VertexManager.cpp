@@ -519,6 +519,21 @@ void VertexManager::SetPLRasterOffsets()
 	
 }
 
+void VertexManager::PrepareShaders(u32 components)
+{
+	const bool useDstAlpha = !g_ActiveConfig.bDstAlphaPass && bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate &&
+		bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24;
+	const bool useDualSource = useDstAlpha && g_ActiveConfig.backend_info.bSupportsDualSourceBlend;
+	const bool forced_early_z = bpmem.UseEarlyDepthTest() && bpmem.zmode.updateenable && bpmem.alpha_test.TestResult() == AlphaTest::UNDETERMINED && !g_ActiveConfig.bFastDepthCalc;
+
+	VertexShaderCache::SetShader(components);
+	if (forced_early_z)
+		PixelShaderCache::SetShader(DSTALPHA_NULL, components);
+	PixelShaderCache::SetShader(useDualSource ? DSTALPHA_DUAL_SOURCE_BLEND : DSTALPHA_NONE, components);
+	if (useDstAlpha && !useDualSource)
+		PixelShaderCache::SetShader(DSTALPHA_ALPHA_PASS, components);
+}
+
 void VertexManager::vFlush()
 {
 	// initialize all values for the current flush
@@ -20,6 +20,7 @@ public:
 	void GetElements(NativeVertexFormat* format, D3DVERTEXELEMENT9** elems, int* num);
 	void CreateDeviceObjects();
 	void DestroyDeviceObjects();
+	void PrepareShaders(u32 components);
 private:
 	u32 m_vertex_buffer_cursor;
 	u32 m_vertex_buffer_size;
@@ -4,6 +4,7 @@
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
 #include "Common/LinearDiskCache.h"
+#include "Common/Timeline.h"
 
 #include "Globals.h"
 #include "D3DBase.h"
@@ -42,16 +43,6 @@ LPDIRECT3DVERTEXSHADER9 VertexShaderCache::GetClearVertexShader()
 	return ClearVertexShader;
 }
 
-// this class will load the precompiled shaders into our cache
-class VertexShaderCacheInserter : public LinearDiskCacheReader<VertexShaderUid, u8>
-{
-public:
-	void Read(const VertexShaderUid &key, const u8 *value, u32 value_size)
-	{
-		VertexShaderCache::InsertByteCode(key, value, value_size, false);
-	}
-};
-
 void VertexShaderCache::Init()
 {
 	char* vProg = new char[2048];
@@ -138,11 +129,8 @@ void VertexShaderCache::Init()
 	char cache_filename[MAX_PATH];
 	sprintf(cache_filename, "%sdx9-%s-vs.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 		SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
-	VertexShaderCacheInserter inserter;
-	g_vs_disk_cache.OpenAndRead(cache_filename, inserter);
-
-	if (g_Config.bEnableShaderDebugging)
-		Clear();
+	// Shaders are only created when SetShader first asks for them.
+	g_vs_disk_cache.Open(cache_filename);
 
 	last_entry = NULL;
 }
@@ -177,6 +165,7 @@ void VertexShaderCache::Shutdown()
 
 bool VertexShaderCache::SetShader(u32 components)
 {
+	TIMELINE_ZONE("Shader lookup");
 	VertexShaderUid uid;
 	GetVertexShaderUidD3D9(uid, components);
 	if (g_ActiveConfig.bEnableShaderDebugging)
@@ -208,6 +197,19 @@ bool VertexShaderCache::SetShader(u32 components)
 		return (entry.shader != NULL);
 	}
 
+	// Try the shaders compiled in earlier runs. When debugging shaders, they
+	// are compiled again to keep their code.
+	if (!g_ActiveConfig.bEnableShaderDebugging)
+	{
+		u32 bytecodelen;
+		const u8* bytecode = g_vs_disk_cache.Lookup(uid, &bytecodelen);
+		if (bytecode && InsertByteCode(uid, bytecode, bytecodelen, true))
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_VERTEX_SHADER_CHANGE, true);
+			return true;
+		}
+	}
+
 	ShaderCode code;
 	GenerateVertexShaderCodeD3D9(code, components);
 
@@ -17,6 +17,7 @@
 #include "main.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/Fifo.h"
+#include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "TextureCache.h"
 #include "VideoCommon/BPStructs.h"
@@ -24,6 +25,7 @@
 #include "FramebufferManager.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/VertexShaderManager.h"
+#include "VideoCommon/ShaderList.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VertexShaderCache.h"
 #include "PixelShaderCache.h"
@@ -189,7 +191,8 @@ void VideoBackend::Video_Prepare()
 	PixelShaderManager::Init();
 	CommandProcessor::Init();
 	PixelEngine::Init();
-	DLCache::Init();	
+	DLCache::Init();
+	ShaderList::Init();
 	// Notify the core that the video backend is ready
 	Host_Message(WM_USER_CREATE);
 }
@@ -207,6 +210,8 @@ void VideoBackend::Shutdown()
 
 		// VideoCommon
 		DLCache::Shutdown();
+		ShaderList::Shutdown();
+		ImageWriter::Shutdown();
 		Fifo_Shutdown();
 		CommandProcessor::Shutdown();
 		PixelShaderManager::Shutdown();
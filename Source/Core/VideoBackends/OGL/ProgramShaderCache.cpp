@@ -5,6 +5,7 @@
 #include "ProgramShaderCache.h"
 #include "VideoCommon/DriverDetails.h"
 #include "Common/MathUtil.h"
+#include "Common/Timeline.h"
 #include "StreamBuffer.h"
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/Statistics.h"
@@ -195,6 +196,7 @@ GLuint ProgramShaderCache::GetCurrentProgram(void)
 
 SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 components )
 {
+	TIMELINE_ZONE("Shader lookup");
 	SHADERUID uid;
 	GetShaderId(&uid, dstAlphaMode, components);
 
@@ -228,10 +230,17 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 	last_entry = &newentry;
 	newentry.in_cache = 0;
 
+	// Programs linked in an earlier run are loaded from the disk cache the
+	// first time they are used.
+	const bool from_disk = g_ogl_config.bSupportsGLSLCache && LoadFromDiskCache(uid, newentry.shader);
+
 	ShaderCode vcode;
 	ShaderCode pcode;
-	GenerateVertexShaderCodeGL(vcode, components);
-	GeneratePixelShaderCodeGL(pcode, dstAlphaMode, components);
+	if (!from_disk || g_ActiveConfig.bEnableShaderDebugging)
+	{
+		GenerateVertexShaderCodeGL(vcode, components);
+		GeneratePixelShaderCodeGL(pcode, dstAlphaMode, components);
+	}
 
 	if (g_ActiveConfig.bEnableShaderDebugging)
 	{
@@ -239,20 +248,27 @@ SHADER* ProgramShaderCache::SetShader ( DSTALPHA_MODE dstAlphaMode, u32 componen
 		newentry.shader.strpprog = pcode.GetBuffer();
 	}
 
-#if defined(_DEBUG) || defined(DEBUGFAST)
-	if (g_ActiveConfig.iLog & CONF_SAVESHADERS) {
-		static int counter = 0;
-		char szTemp[MAX_PATH];
-		sprintf(szTemp, "%svs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-		SaveData(szTemp, vcode.GetBuffer());
-		sprintf(szTemp, "%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
-		SaveData(szTemp, pcode.GetBuffer());
+	if (from_disk)
+	{
+		newentry.in_cache = 1;
 	}
+	else
+	{
+#if defined(_DEBUG) || defined(DEBUGFAST)
+		if (g_ActiveConfig.iLog & CONF_SAVESHADERS) {
+			static int counter = 0;
+			char szTemp[MAX_PATH];
+			sprintf(szTemp, "%svs_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
+			ImageWriter::QueueData(szTemp, vcode.GetBuffer());
+			sprintf(szTemp, "%sps_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
+			ImageWriter::QueueData(szTemp, pcode.GetBuffer());
+		}
 #endif
 
-	if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer())) {
-		GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
-		return NULL;
+		if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer())) {
+			GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+			return NULL;
+		}
 	}
 
 	INCSTAT(stats.numPixelShadersCreated);
@@ -456,10 +472,9 @@ void ProgramShaderCache::Init(void)
 			sprintf(cache_filename, "%sogl-%s-shaders.cache", File::GetUserPath(D_SHADERCACHE_IDX).c_str(),
 				SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID.c_str());
 			
-			ProgramShaderCacheInserter inserter;
-			g_program_disk_cache.OpenAndRead(cache_filename, inserter);
+			// Programs are only loaded when SetShader first asks for them.
+			g_program_disk_cache.Open(cache_filename);
 		}
-		SETSTAT(stats.numPixelShadersAlive, pshaders.size());
 	}
 	
 	CreateHeader();
@@ -558,27 +573,35 @@ void ProgramShaderCache::CreateHeader ( void )
 }
 
 
-void ProgramShaderCache::ProgramShaderCacheInserter::Read ( const SHADERUID& key, const u8* value, u32 value_size )
+bool ProgramShaderCache::LoadFromDiskCache(const SHADERUID& uid, SHADER& shader)
 {
-	const u8 *binary = value+sizeof(GLenum);
-	GLenum *prog_format = (GLenum*)value;
-	GLint binary_size = value_size-sizeof(GLenum);
-	
-	PCacheEntry entry;
-	entry.in_cache = 1;
-	entry.shader.glprogid = glCreateProgram();
-	glProgramBinary(entry.shader.glprogid, *prog_format, binary, binary_size);
+	u32 value_size;
+	const u8* value = g_program_disk_cache.Lookup(uid, &value_size);
+	if (!value || value_size < sizeof(GLenum))
+		return false;
+
+	GLenum prog_format;
+	memcpy(&prog_format, value, sizeof(GLenum));
+	const u8 *binary = value + sizeof(GLenum);
+	GLint binary_size = value_size - sizeof(GLenum);
+
+	shader.glprogid = glCreateProgram();
+	glProgramBinary(shader.glprogid, prog_format, binary, binary_size);
 
 	GLint success;
-	glGetProgramiv(entry.shader.glprogid, GL_LINK_STATUS, &success);
+	glGetProgramiv(shader.glprogid, GL_LINK_STATUS, &success);
 
-	if (success)
+	// The binary is rejected after driver updates; the program is then
+	// compiled again and replaces it in the cache on shutdown.
+	if (!success)
 	{
-		pshaders[key] = entry;
-		entry.shader.SetProgramVariables();
+		glDeleteProgram(shader.glprogid);
+		shader.glprogid = 0;
+		return false;
 	}
-	else
-		glDeleteProgram(entry.shader.glprogid);
+
+	shader.SetProgramVariables();
+	return true;
 }
 
 
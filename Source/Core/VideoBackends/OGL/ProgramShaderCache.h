@@ -97,11 +97,7 @@ public:
 	static void CreateHeader(void);
 
 private:
-	class ProgramShaderCacheInserter : public LinearDiskCacheReader<SHADERUID, u8>
-	{
-	public:
-		void Read(const SHADERUID &key, const u8 *value, u32 value_size);
-	};
+	static bool LoadFromDiskCache(const SHADERUID& uid, SHADER& shader);
 
 	static PCache pshaders;
 	static PCacheEntry* last_entry;
@@ -1819,8 +1819,18 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 	OSD::AddMessage("Saving Screenshot... ", 2000);
 
 #else
-	bool result = SaveTGA(filename.c_str(), W, H, data);
+	// SaveTGA wants BGRA
+	std::vector<u8> bgra(W * H * 4);
+	for (u32 i = 0; i < W * H; i++)
+	{
+		bgra[i * 4 + 0] = data[i * 3 + 2];
+		bgra[i * 4 + 1] = data[i * 3 + 1];
+		bgra[i * 4 + 2] = data[i * 3 + 0];
+		bgra[i * 4 + 3] = 0xFF;
+	}
 	free(data);
+	ImageWriter::QueueTGA(filename, W, H, std::move(bgra));
+	bool result = true;
 #endif
 
 	return result;
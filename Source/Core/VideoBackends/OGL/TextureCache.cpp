@@ -66,7 +66,7 @@ bool SaveTexture(const char* filename, u32 textarget, u32 tex, int virtual_width
 #ifndef USE_GLES3
 	int width = std::max(virtual_width >> level, 1);
 	int height = std::max(virtual_height >> level, 1);
-	std::vector<u32> data(width * height);
+	std::vector<u8> data(width * height * 4);
 	glActiveTexture(GL_TEXTURE0+9);
 	glBindTexture(textarget, tex);
 	glGetTexImage(textarget, level, GL_BGRA, GL_UNSIGNED_BYTE, &data[0]);
@@ -80,7 +80,8 @@ bool SaveTexture(const char* filename, u32 textarget, u32 tex, int virtual_width
 		return false;
 	}
 
-	return SaveTGA(filename, width, height, &data[0]);
+	ImageWriter::QueueTGA(filename, width, height, std::move(data));
+	return true;
 #else
 	return false;
 #endif
@@ -152,7 +152,7 @@ namespace OGL
 					char szTemp[MAX_PATH];
 					sprintf(szTemp, "%senc_%04i.txt", File::GetUserPath(D_DUMP_IDX).c_str(), counter++);
 
-					SaveData(szTemp, shader);
+					ImageWriter::QueueData(szTemp, shader);
 				}
 #endif
 
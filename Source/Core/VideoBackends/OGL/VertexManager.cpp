@@ -154,6 +154,17 @@ void VertexManager::Draw(u32 stride)
 	}
 }
 
+void VertexManager::PrepareShaders(u32 components)
+{
+	bool useDstAlpha = !g_ActiveConfig.bDstAlphaPass && bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate
+		&& bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24;
+	bool dualSourcePossible = g_ActiveConfig.backend_info.bSupportsDualSourceBlend;
+
+	ProgramShaderCache::SetShader(useDstAlpha && dualSourcePossible ? DSTALPHA_DUAL_SOURCE_BLEND : DSTALPHA_NONE, components);
+	if (useDstAlpha && !dualSourcePossible)
+		ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS, components);
+}
+
 void VertexManager::vFlush()
 {
 #if defined(_DEBUG) || defined(DEBUGFAST) 
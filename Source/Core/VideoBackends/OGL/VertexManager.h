@@ -35,6 +35,7 @@ public:
 	NativeVertexFormat* CreateNativeVertexFormat();
 	void CreateDeviceObjects();
 	void DestroyDeviceObjects();
+	void PrepareShaders(u32 components);
 	
 	// NativeVertexFormat use this
 	GLuint m_vertex_buffers;
@@ -69,6 +69,7 @@ Make AA apply instantly during gameplay if possible
 #include "VertexManager.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/VertexShaderManager.h"
+#include "VideoCommon/ShaderList.h"
 #include "ProgramShaderCache.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/PixelEngine.h"
@@ -232,6 +233,7 @@ void VideoBackend::Video_Prepare()
 #ifndef _M_GENERIC
 	DLCache::Init();
 #endif
+	ShaderList::Init();
 
 	// Notify the core that the video backend is ready
 	Host_Message(WM_USER_CREATE);
@@ -257,6 +259,8 @@ void VideoBackend::Video_Cleanup() {
 #ifndef _M_GENERIC
 		DLCache::Shutdown();
 #endif
+		ShaderList::Shutdown();
+		ImageWriter::Shutdown();
 		Fifo_Shutdown();
 
 		// The following calls are NOT Thread Safe
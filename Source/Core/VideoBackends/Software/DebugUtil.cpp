@@ -52,13 +52,11 @@ void SaveTexture(const char* filename, u32 texmap, s32 mip)
 	u32 width = ti0.width + 1;
 	u32 height = ti0.height + 1;
 
-	u8 *data = new u8[width * height * 4];
+	std::vector<u8> data(width * height * 4);
 
-	GetTextureBGRA(data, texmap, mip, width, height);
+	GetTextureBGRA(&data[0], texmap, mip, width, height);
 
-	(void)SaveTGA(filename, width, height, data);
-
-	delete []data;
+	ImageWriter::QueueTGA(filename, width, height, std::move(data));
 }
 
 void GetTextureBGRA(u8 *dst, u32 texmap, s32 mip, u32 width, u32 height)
@@ -130,8 +128,8 @@ void DumpActiveTextures()
 
 void DumpEfb(const char* filename)
 {
-	u8 *data = new u8[EFB_WIDTH * EFB_HEIGHT * 4];
-	u8 *writePtr = data;
+	std::vector<u8> data(EFB_WIDTH * EFB_HEIGHT * 4);
+	u8 *writePtr = &data[0];
 	u8 sample[4];
 
 	for (int y = 0; y < EFB_HEIGHT; y++)
@@ -147,15 +145,13 @@ void DumpEfb(const char* filename)
 		}
 	}
 
-	(void)SaveTGA(filename, EFB_WIDTH, EFB_HEIGHT, data);
-
-	delete []data;
+	ImageWriter::QueueTGA(filename, EFB_WIDTH, EFB_HEIGHT, std::move(data));
 }
 
 void DumpDepth(const char* filename)
 {
-	u8 *data = new u8[EFB_WIDTH * EFB_HEIGHT * 4];
-	u8 *writePtr = data;
+	std::vector<u8> data(EFB_WIDTH * EFB_HEIGHT * 4);
+	u8 *writePtr = &data[0];
 
 	for (int y = 0; y < EFB_HEIGHT; y++)
 	{
@@ -170,9 +166,7 @@ void DumpDepth(const char* filename)
 		}
 	}
 
-	(void)SaveTGA(filename, EFB_WIDTH, EFB_HEIGHT, data);
-
-	delete []data;
+	ImageWriter::QueueTGA(filename, EFB_WIDTH, EFB_HEIGHT, std::move(data));
 }
 
 void DrawObjectBuffer(s16 x, s16 y, u8 *color, int bufferBase, int subBuffer, const char *name)
@@ -247,10 +241,11 @@ void OnObjectEnd()
 			if (DrawnToBuffer[i])
 			{
 				DrawnToBuffer[i] = false;
-				(void)SaveTGA(StringFromFormat("%sobject%i_%s(%i).tga",
+				const u8* buffer = (const u8*)ObjectBuffer[i];
+				ImageWriter::QueueTGA(StringFromFormat("%sobject%i_%s(%i).tga",
 							File::GetUserPath(D_DUMPFRAMES_IDX).c_str(),
-							swstats.thisFrame.numDrawnObjects, ObjectBufferName[i], i - BufferBase[i]).c_str(),
-						EFB_WIDTH, EFB_HEIGHT, ObjectBuffer[i]);
+							swstats.thisFrame.numDrawnObjects, ObjectBufferName[i], i - BufferBase[i]),
+						EFB_WIDTH, EFB_HEIGHT, std::vector<u8>(buffer, buffer + EFB_WIDTH * EFB_HEIGHT * 4));
 				memset(ObjectBuffer[i], 0, sizeof(ObjectBuffer[i]));
 			}
 		}
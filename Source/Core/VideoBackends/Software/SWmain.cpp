@@ -30,6 +30,7 @@
 #include "SWVertexLoader.h"
 #include "SWStatistics.h"
 
+#include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/OnScreenDisplay.h"
 #define VSYNC_ENABLED 0
 
@@ -149,6 +150,7 @@ void VideoSoftware::Shutdown()
 	// TODO: should be in Video_Cleanup
 	HwRasterizer::Shutdown();
 	SWRenderer::Shutdown();
+	ImageWriter::Shutdown();
 
 	// Do our OSD callbacks	
 	OSD::DoCallbacks(OSD::OSD_SHUTDOWN);
@@ -6,10 +6,126 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif 
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/Thread.h"
 #include "VideoCommon/AVIDump.h"
 #include "Core/HW/VideoInterface.h" //for TargetRefreshRate
 #include "VideoCommon/VideoConfig.h"
 
+// Frames waiting for the encoder, besides the one being encoded
+static const size_t MAX_QUEUED_FRAMES = 8;
+
+struct QueuedFrame
+{
+	std::vector<u8> data;
+	int width;
+	int height;
+};
+
+static std::thread s_encoder_thread;
+static std::mutex s_queue_lock;
+// Signalled whenever a frame is queued or taken
+static std::condition_variable s_queue_changed;
+static std::deque<QueuedFrame> s_queue;
+static std::vector<std::vector<u8>> s_free_buffers;
+static bool s_stop_encoder;
+
+static u32 s_frames_queued;
+static u32 s_max_queued;
+static u32 s_stalls;
+static double s_stall_seconds;
+
+void AVIDump::StartEncoder()
+{
+	s_stop_encoder = false;
+	s_frames_queued = s_max_queued = s_stalls = 0;
+	s_stall_seconds = 0;
+	s_encoder_thread = std::thread(EncoderThread);
+}
+
+void AVIDump::EncoderThread()
+{
+	Common::SetCurrentThreadName("Frame dump encoder");
+
+	std::unique_lock<std::mutex> lk(s_queue_lock);
+	while (true)
+	{
+		s_queue_changed.wait(lk, [] { return s_stop_encoder || !s_queue.empty(); });
+		// Stop only once every frame is written.
+		if (s_queue.empty())
+			break;
+
+		QueuedFrame frame = std::move(s_queue.front());
+		s_queue.pop_front();
+		s_queue_changed.notify_all();
+		lk.unlock();
+
+		WriteFrame(&frame.data[0], frame.width, frame.height);
+
+		lk.lock();
+		s_free_buffers.push_back(std::move(frame.data));
+	}
+}
+
+void AVIDump::AddFrame(const u8* data, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return;
+
+	QueuedFrame frame;
+	frame.width = width;
+	frame.height = height;
+
+	std::unique_lock<std::mutex> lk(s_queue_lock);
+	if (s_queue.size() >= MAX_QUEUED_FRAMES)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		s_queue_changed.wait(lk, [] { return s_queue.size() < MAX_QUEUED_FRAMES; });
+		s_stall_seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		s_stalls++;
+	}
+	if (!s_free_buffers.empty())
+	{
+		frame.data.swap(s_free_buffers.back());
+		s_free_buffers.pop_back();
+	}
+	lk.unlock();
+
+	frame.data.assign(data, data + width * height * 3);
+
+	lk.lock();
+	s_queue.push_back(std::move(frame));
+	s_max_queued = std::max<u32>(s_max_queued, (u32)s_queue.size());
+	s_frames_queued++;
+	s_queue_changed.notify_all();
+}
+
+void AVIDump::Stop()
+{
+	if (s_encoder_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lk(s_queue_lock);
+			s_stop_encoder = true;
+			s_queue_changed.notify_all();
+		}
+		s_encoder_thread.join();
+
+		NOTICE_LOG(VIDEO, "Dumped %u frames; the encoder was up to %u frames behind and held up %u frames for %.0f ms",
+			s_frames_queued, s_max_queued, s_stalls, s_stall_seconds * 1000);
+	}
+	std::vector<std::vector<u8>>().swap(s_free_buffers);
+
+	StopWriting();
+}
+
 #ifdef _WIN32
 
 #include "tchar.h"
@@ -46,7 +162,10 @@ bool AVIDump::Start(HWND hWnd, int w, int h)
 	m_width = w;
 	m_height = h;
 
-	return CreateFile();
+	if (!CreateFile())
+		return false;
+	StartEncoder();
+	return true;
 }
 
 bool AVIDump::CreateFile()
@@ -76,7 +195,7 @@ bool AVIDump::CreateFile()
 		if (hr == AVIERR_FILEREAD) NOTICE_LOG(VIDEO, "A disk error occurred while reading the file."); 
 		if (hr == AVIERR_FILEOPEN) NOTICE_LOG(VIDEO, "A disk error occurred while opening the file.");
 		if (hr == REGDB_E_CLASSNOTREG) NOTICE_LOG(VIDEO, "AVI class not registered");
-		Stop();
+		StopWriting();
 		return false;
 	}
 
@@ -85,7 +204,7 @@ bool AVIDump::CreateFile()
 	if (!SetVideoFormat())
 	{
 		NOTICE_LOG(VIDEO, "Setting video format failed");
-		Stop();
+		StopWriting();
 		return false;
 	}
 
@@ -94,7 +213,7 @@ bool AVIDump::CreateFile()
 		if (!SetCompressionOptions())
 		{
 			NOTICE_LOG(VIDEO, "SetCompressionOptions failed");
-			Stop();
+			StopWriting();
 			return false;
 		}
 	}
@@ -102,14 +221,14 @@ bool AVIDump::CreateFile()
 	if (FAILED(AVIMakeCompressedStream(&m_streamCompressed, m_stream, &m_options, NULL)))
 	{
 		NOTICE_LOG(VIDEO, "AVIMakeCompressedStream failed");
-		Stop();
+		StopWriting();
 		return false;
 	}
 
 	if (FAILED(AVIStreamSetFormat(m_streamCompressed, 0, &m_bitmap, m_bitmap.biSize)))
 	{
 		NOTICE_LOG(VIDEO, "AVIStreamSetFormat failed");
-		Stop();
+		StopWriting();
 		return false;
 	}
 
@@ -139,14 +258,14 @@ void AVIDump::CloseFile()
 	AVIFileExit();
 }
 
-void AVIDump::Stop()
+void AVIDump::StopWriting()
 {
 	CloseFile();
 	m_fileCount = 0;
 	NOTICE_LOG(VIDEO, "Stop");
 }
 
-void AVIDump::AddFrame(const u8* data, int w, int h)
+void AVIDump::WriteFrame(const u8* data, int w, int h)
 {
 	static bool shown_error = false;
 	if ((w != m_bitmap.biWidth || h != m_bitmap.biHeight) && !shown_error)
@@ -223,6 +342,8 @@ uint8_t *s_OutBuffer = NULL;
 int s_width;
 int s_height;
 int s_size;
+// Reused as long as the size of the frames stays the same
+SwsContext *s_SwsContext = NULL;
 
 static void InitAVCodec()
 {
@@ -240,7 +361,10 @@ bool AVIDump::Start(int w, int h)
 	s_height = h;
 
 	InitAVCodec();
-	return CreateFile();
+	if (!CreateFile())
+		return false;
+	StartEncoder();
+	return true;
 }
 
 bool AVIDump::CreateFile()
@@ -299,19 +423,18 @@ bool AVIDump::CreateFile()
 	return true;
 }
 
-void AVIDump::AddFrame(const u8* data, int width, int height)
+void AVIDump::WriteFrame(const u8* data, int width, int height)
 {
 	avpicture_fill((AVPicture *)s_BGRFrame, const_cast<u8*>(data), PIX_FMT_BGR24, width, height);
 
 	// Convert image from BGR24 to desired pixel format, and scale to initial
 	// width and height
-	struct SwsContext *s_SwsContext;
-	if ((s_SwsContext = sws_getContext(width, height, PIX_FMT_BGR24, s_width, s_height,
-					s_Stream->codec->pix_fmt, SWS_BICUBIC, NULL, NULL, NULL)))
+	s_SwsContext = sws_getCachedContext(s_SwsContext, width, height, PIX_FMT_BGR24, s_width, s_height,
+					s_Stream->codec->pix_fmt, SWS_BICUBIC, NULL, NULL, NULL);
+	if (s_SwsContext)
 	{
 		sws_scale(s_SwsContext, s_BGRFrame->data, s_BGRFrame->linesize, 0,
 				height, s_YUVFrame->data, s_YUVFrame->linesize);
-		sws_freeContext(s_SwsContext);
 	}
 
 	// Encode and write the image
@@ -338,7 +461,7 @@ void AVIDump::AddFrame(const u8* data, int width, int height)
 	}
 }
 
-void AVIDump::Stop()
+void AVIDump::StopWriting()
 {
 	av_write_trailer(s_FormatContext);
 	CloseFile();
@@ -355,6 +478,10 @@ void AVIDump::CloseFile()
 		s_Stream = NULL;
 	}
 
+	if (s_SwsContext)
+		sws_freeContext(s_SwsContext);
+	s_SwsContext = NULL;
+
 	if (s_YUVBuffer)
 		delete[] s_YUVBuffer;
 	s_YUVBuffer = NULL;
@@ -2,6 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+// AddFrame only copies the frame into a queue; the frames are scaled,
+// encoded and written on a separate thread. When the encoder falls behind,
+// AddFrame waits for it rather than dropping frames, as the file has a fixed
+// frame rate.
+
 #ifndef _AVIDUMP_H
 #define _AVIDUMP_H
 
@@ -22,6 +27,13 @@ class AVIDump
 		static bool SetCompressionOptions();
 		static bool SetVideoFormat();
 
+		// Implemented per platform and called on the encoder thread
+		static void WriteFrame(const u8* data, int width, int height);
+		static void StopWriting();
+
+		static void StartEncoder();
+		static void EncoderThread();
+
 	public:
 #ifdef _WIN32
 		static bool Start(HWND hWnd, int w, int h);
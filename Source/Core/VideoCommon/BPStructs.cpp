@@ -8,6 +8,7 @@
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/BPFunctions.h"
@@ -36,10 +37,33 @@ static const float s_gammaLUT[] =
 	1.0f
 };
 
+// The registers GeneratePixelShader reads; writes to any other register leave the pixel shader UID as it is.
+static bool IsPixelShaderUidRegister(int address)
+{
+	switch (address)
+	{
+	case BPMEM_GENMODE:
+	case BPMEM_IREF:
+	case BPMEM_ZMODE:
+	case BPMEM_ZCOMPARE:
+	case BPMEM_FOGRANGE:
+	case BPMEM_FOGPARAM3:
+	case BPMEM_ALPHACOMPARE:
+	case BPMEM_ZTEX2:
+		return true;
+	}
+
+	return (address >= BPMEM_IND_CMD && address < BPMEM_IND_CMD + 16) ||
+	       (address >= BPMEM_TREF && address < BPMEM_TREF + 8) ||
+	       (address >= BPMEM_TEV_COLOR_ENV && address < BPMEM_TEV_COLOR_ENV + 32) ||
+	       (address >= BPMEM_TEV_KSEL && address < BPMEM_TEV_KSEL + 8);
+}
+
 void BPInit()
 {
 	memset(&bpmem, 0, sizeof(bpmem));
 	bpmem.bpMask = 0xFFFFFF;
+	InvalidatePixelShaderUids();
 
 	mapTexAddress = 0;
 	numWrites = 0;
@@ -144,6 +168,9 @@ void BPWritten(const BPCmd& bp)
 	}
 
 	((u32*)&bpmem)[bp.address] = bp.newvalue;
+
+	if (bp.changes && IsPixelShaderUidRegister(bp.address))
+		InvalidatePixelShaderUids();
 	
 	switch (bp.address)
 	{
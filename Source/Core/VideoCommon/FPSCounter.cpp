@@ -4,6 +4,8 @@
 
 #include "VideoCommon/FPSCounter.h"
 #include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Timeline.h"
 #include "Common/Timer.h"
 #include "VideoCommon/VideoConfig.h"
 
@@ -14,6 +16,9 @@ static unsigned int s_fps = 0;
 static unsigned int s_fps_last_counter = 0;
 static unsigned long s_last_update_time = 0;
 static File::IOFile s_bench_file;
+static unsigned int s_timeline_frames = 0;
+static unsigned int s_timeline_files = 0;
+static u64 s_timeline_start = 0;
 
 void InitFPSCounter()
 {
@@ -23,6 +28,9 @@ void InitFPSCounter()
 
 	if (s_bench_file.IsOpen())
 		s_bench_file.Close();
+
+	s_timeline_frames = s_timeline_files = 0;
+	s_timeline_start = Timeline::Now();
 }
 
 static void LogFPSToFile(unsigned long val)
@@ -35,8 +43,33 @@ static void LogFPSToFile(unsigned long val)
 	s_bench_file.WriteArray(buffer, strlen(buffer));
 }
 
+static void UpdateTimeline()
+{
+	const bool enabled = g_ActiveConfig.iTimelineFrames > 0;
+	if (enabled != Timeline::IsEnabled())
+	{
+		Timeline::SetEnabled(enabled);
+		s_timeline_frames = 0;
+		s_timeline_start = Timeline::Now();
+	}
+	if (!enabled)
+		return;
+
+	Timeline::MarkFrame();
+	if (++s_timeline_frames < (unsigned int)g_ActiveConfig.iTimelineFrames)
+		return;
+
+	const u64 now = Timeline::Now();
+	Timeline::ExportChromeTrace(File::GetUserPath(D_LOGS_IDX) + StringFromFormat("timeline_%04u.json", s_timeline_files++),
+	                            s_timeline_start);
+	s_timeline_frames = 0;
+	s_timeline_start = now;
+}
+
 int UpdateFPSCounter()
 {
+	UpdateTimeline();
+
 	if (Common::Timer::GetTimeMs() - s_last_update_time >= FPS_REFRESH_INTERVAL)
 	{
 		s_last_update_time = Common::Timer::GetTimeMs();
@@ -2,11 +2,18 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <list>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "VideoCommon/ImageWrite.h"
+#include "Common/CPUDetect.h"
 #include "Common/FileUtil.h"
+#include "Common/Thread.h"
 
 #pragma pack(push, 1)
 
@@ -62,3 +69,133 @@ bool SaveData(const char* filename, const char* data)
 
 	return true;
 }
+
+namespace ImageWriter
+{
+
+static const size_t MAX_QUEUED_BYTES = 128 * 1024 * 1024;
+
+struct Job
+{
+	std::string filename;
+	bool tga;
+	int width;
+	int height;
+	std::vector<u8> data;
+};
+
+static std::mutex s_lock;
+// Signalled whenever a job is queued or finished
+static std::condition_variable s_changed;
+static std::deque<Job> s_jobs;
+static std::vector<std::thread> s_workers;
+static size_t s_queued_bytes;
+static u32 s_busy;
+static bool s_stop;
+
+static void WorkerThread()
+{
+	Common::SetCurrentThreadName("Image writer");
+
+	std::unique_lock<std::mutex> lk(s_lock);
+	while (true)
+	{
+		s_changed.wait(lk, [] { return s_stop || !s_jobs.empty(); });
+		// Stop only once every job is written.
+		if (s_jobs.empty())
+			break;
+
+		Job job = std::move(s_jobs.front());
+		s_jobs.pop_front();
+		s_busy++;
+		lk.unlock();
+
+		bool written;
+		if (job.tga)
+		{
+			written = SaveTGA(job.filename.c_str(), job.width, job.height, job.data.data());
+		}
+		else
+		{
+			File::IOFile file(job.filename, "wb");
+			written = file.WriteBytes(job.data.data(), job.data.size());
+		}
+		if (!written)
+			WARN_LOG(VIDEO, "Failed to write %s", job.filename.c_str());
+
+		lk.lock();
+		s_busy--;
+		s_queued_bytes -= job.data.size();
+		s_changed.notify_all();
+	}
+}
+
+static void Queue(Job&& job)
+{
+	const size_t size = job.data.size();
+	std::unique_lock<std::mutex> lk(s_lock);
+
+	// A job larger than the cap on its own still gets queued once the
+	// queue is empty.
+	s_changed.wait(lk, [&] { return s_queued_bytes == 0 || s_queued_bytes + size <= MAX_QUEUED_BYTES; });
+
+	if (s_workers.empty())
+	{
+		// Writing is mostly waiting on the disk and compressing nothing, so
+		// a few threads are plenty.
+		const int num_workers = std::min(std::max(cpu_info.num_cores - 1, 1), 4);
+		s_stop = false;
+		for (int i = 0; i < num_workers; i++)
+			s_workers.emplace_back(WorkerThread);
+	}
+
+	s_queued_bytes += size;
+	s_jobs.push_back(std::move(job));
+	s_changed.notify_all();
+}
+
+void QueueTGA(const std::string& filename, int width, int height, std::vector<u8>&& data)
+{
+	Job job;
+	job.filename = filename;
+	job.tga = true;
+	job.width = width;
+	job.height = height;
+	job.data = std::move(data);
+	Queue(std::move(job));
+}
+
+void QueueData(const std::string& filename, const std::string& data)
+{
+	Job job;
+	job.filename = filename;
+	job.tga = false;
+	job.width = job.height = 0;
+	job.data.assign(data.begin(), data.end());
+	Queue(std::move(job));
+}
+
+void Flush()
+{
+	std::unique_lock<std::mutex> lk(s_lock);
+	s_changed.wait(lk, [] { return s_jobs.empty() && s_busy == 0; });
+}
+
+void Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		s_stop = true;
+		s_changed.notify_all();
+	}
+
+	// Queue doesn't touch s_workers while it's not empty, and anything
+	// queued meanwhile is still written before the workers exit.
+	for (std::thread& worker : s_workers)
+		worker.join();
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_workers.clear();
+}
+
+}  // namespace
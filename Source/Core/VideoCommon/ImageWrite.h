@@ -7,8 +7,28 @@
 
 #include "Common/Common.h"
 
+#include <string>
+#include <vector>
+
 bool SaveTGA(const char* filename, int width, int height, void* pdata);
 bool SaveData(const char* filename, const char* pdata);
 
+// Writes dumps on a few worker threads, so the thread producing them only
+// pays for a copy. Up to 128 MiB can be waiting to be written;
+// past that, queuing waits for the workers to catch up.
+namespace ImageWriter
+{
+
+// Takes width * height BGRA pixels, written out as a TGA.
+void QueueTGA(const std::string& filename, int width, int height, std::vector<u8>&& data);
+void QueueData(const std::string& filename, const std::string& data);
+
+// Waits until everything queued so far is written.
+void Flush();
+// Flushes and stops the workers; they start again on the next queued file.
+void Shutdown();
+
+}
+
 #endif  // _IMAGEWRITE_H
 
@@ -9,6 +9,7 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/PixelEngine.h"
 #include "Common/Atomic.h"
+#include "Common/Timeline.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/BPStructs.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -71,6 +72,7 @@ void VideoFifo_CheckSwapRequest()
 	{
 		if (Common::AtomicLoadAcquire(s_swapRequested))
 		{
+			TIMELINE_ZONE("Swap");
 			EFBRectangle rc;
 			g_renderer->Swap(s_beginFieldArgs.xfbAddr, s_beginFieldArgs.fbWidth, s_beginFieldArgs.fbHeight,rc);
 			Common::AtomicIncrement(s_EFB_PCache_Frame);
@@ -177,6 +179,7 @@ u32 VideoBackendHardware::Video_AccessEFB(EFBAccessType type, u32 x, u32 y, u32
 			)
 		{
 			// In peek scenario we have a invalid cache so get the current values
+			TIMELINE_ZONE("EFB access");
 			s_accessEFBArgs.type = type;
 			s_accessEFBArgs.x = x;
 			s_accessEFBArgs.y = y;
@@ -250,6 +253,7 @@ u32 VideoBackendHardware::Video_GetQueryResult(PerfQueryType type)
 	// TODO: Is this check sane?
 	if (!g_perf_query->IsFlushed())
 	{
+		TIMELINE_ZONE("Perf query");
 		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bCPUThread)
 		{
 			s_perf_query_requested = true;
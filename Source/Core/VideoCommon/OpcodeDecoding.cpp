@@ -13,6 +13,7 @@
 // when they are called. The reason is that the vertex format affects the sizes of the vertices.
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
+#include "Common/Timeline.h"
 #include "Core/Core.h"
 #include "Core/Host.h"
 #include "Core/FifoPlayer/FifoRecorder.h"
@@ -502,6 +503,10 @@ u32 OpcodeDecoder_Run(bool skipped_frame)
 {
 	u32 totalCycles = 0;
 	u32 cycles = FifoCommandRunnable();
+	if (cycles == 0)
+		return 0;
+
+	TIMELINE_ZONE("OpcodeDecoder_Run");
 	while (cycles > 0)
 	{
 		skipped_frame ? DecodeSemiNop() : Decode();
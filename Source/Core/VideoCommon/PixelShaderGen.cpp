@@ -12,6 +12,7 @@
 
 #include "LightingShaderGen.h"
 #include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/XFMemory.h"  // for texture projection mode
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/VideoConfig.h"
@@ -1388,9 +1389,31 @@ static inline void WriteFog(T& out, pixel_shader_uid_data& uid_data)
 
 }
 
+static UidCache<PixelShaderUid> s_uid_cache;
+
+void InvalidatePixelShaderUids()
+{
+	s_uid_cache.Invalidate();
+}
+
+template<API_TYPE ApiType>
+static inline void GetPixelShaderUid(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, u32 components)
+{
+	const u64 key = ((u64)ApiType << 32) | ((u64)dstAlphaMode << 24) | components;
+	if (s_uid_cache.Find(key, object))
+	{
+		INCSTAT(stats.thisFrame.numShaderUidsReused);
+		return;
+	}
+
+	GeneratePixelShader<PixelShaderUid, false, ApiType>(object, dstAlphaMode, components);
+	s_uid_cache.Insert(key, object);
+	INCSTAT(stats.thisFrame.numShaderUidsGenerated);
+}
+
 void GetPixelShaderUidD3D9(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, u32 components)
 {
-	GeneratePixelShader<PixelShaderUid, false, API_D3D9>(object, dstAlphaMode, components);
+	GetPixelShaderUid<API_D3D9>(object, dstAlphaMode, components);
 }
 
 void GeneratePixelShaderCodeD3D9(ShaderCode& object, DSTALPHA_MODE dstAlphaMode, u32 components)
@@ -1405,7 +1428,7 @@ void GeneratePixelShaderCodeD3D9SM2(ShaderCode& object, DSTALPHA_MODE dstAlphaMo
 
 void GetPixelShaderUidD3D11(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, u32 components)
 {
-	GeneratePixelShader<PixelShaderUid, false, API_D3D11>(object, dstAlphaMode, components);
+	GetPixelShaderUid<API_D3D11>(object, dstAlphaMode, components);
 }
 
 void GeneratePixelShaderCodeD3D11(ShaderCode& object, DSTALPHA_MODE dstAlphaMode, u32 components)
@@ -1415,7 +1438,7 @@ void GeneratePixelShaderCodeD3D11(ShaderCode& object, DSTALPHA_MODE dstAlphaMode
 
 void GetPixelShaderUidGL(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, u32 components)
 {
-	GeneratePixelShader<PixelShaderUid, false, API_OPENGL>(object, dstAlphaMode, components);
+	GetPixelShaderUid<API_OPENGL>(object, dstAlphaMode, components);
 }
 
 void GeneratePixelShaderCodeGL(ShaderCode& object, DSTALPHA_MODE dstAlphaMode, u32 components)
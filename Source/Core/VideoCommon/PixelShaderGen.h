@@ -162,6 +162,10 @@ struct pixel_shader_uid_data
 
 typedef ShaderUid<pixel_shader_uid_data> PixelShaderUid;
 
+// The GetPixelShaderUid functions reuse the UIDs generated since this was last called.
+// Call it after writing a BP or XF register (or config option) that GeneratePixelShader reads.
+void InvalidatePixelShaderUids();
+
 void GetPixelShaderUidD3D9(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, u32 components);
 
 void GeneratePixelShaderCodeD3D9(ShaderCode& object, DSTALPHA_MODE dstAlphaMode, u32 components);
@@ -24,6 +24,7 @@
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/OpcodeDecoding.h"
+#include "Common/Timeline.h"
 #include "Common/Timer.h"
 #include "Common/StringUtil.h"
 #include "Core/Host.h"
@@ -120,6 +121,7 @@ void Renderer::RenderToXFB(u32 xfbAddr, u32 fbWidth, u32 fbHeight, const EFBRect
 	}
 	else
 	{
+		TIMELINE_ZONE("Swap");
 		g_renderer->Swap(xfbAddr, fbWidth, fbHeight,sourceRc,Gamma);
 		Common::AtomicIncrement(s_EFB_PCache_Frame);
 		Common::AtomicStoreRelease(s_swapRequested, false);
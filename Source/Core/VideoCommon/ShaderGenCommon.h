@@ -120,6 +120,57 @@ private:
 
 
 
+/**
+ * Remembers the last few UIDs generated from the current register state, keyed by the generator's other arguments.
+ * Generating a UID walks every TEV stage, texgen and lighting channel, while most flushes happen without any of the
+ * registers involved being written in between.
+ * @note Invalidate() must be called whenever a register or config option read by the generator may have changed.
+ */
+template<class UidT>
+class UidCache
+{
+public:
+	UidCache() : m_num_entries(0), m_next(0) {}
+
+	void Invalidate()
+	{
+		m_num_entries = 0;
+		m_next = 0;
+	}
+
+	bool Find(u64 key, UidT& uid) const
+	{
+		for (u32 i = 0; i < m_num_entries; ++i)
+		{
+			if (m_keys[i] == key)
+			{
+				uid = m_uids[i];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Insert(u64 key, const UidT& uid)
+	{
+		m_keys[m_next] = key;
+		m_uids[m_next] = uid;
+		m_next = (m_next + 1) % NUM_ENTRIES;
+		if (m_num_entries < NUM_ENTRIES)
+			++m_num_entries;
+	}
+
+private:
+	// Only a handful of vertex formats and dst alpha passes are used between register changes
+	static const u32 NUM_ENTRIES = 8;
+
+	u64 m_keys[NUM_ENTRIES];
+	UidT m_uids[NUM_ENTRIES];
+	u32 m_num_entries;
+	u32 m_next;
+};
+
+
 class ShaderCode : public ShaderGeneratorInterface
 {
 public:
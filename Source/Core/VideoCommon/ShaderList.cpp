@@ -0,0 +1,318 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstring>
+#include <set>
+
+#include "Common/ChunkFile.h"
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+
+#include "Core/ConfigManager.h"
+
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/ShaderList.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/VertexShaderGen.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace ShaderList
+{
+
+static const u32 LIST_REVISION = 1;
+
+// Bits of the draw state that decide which pixel shaders a backend uses,
+// besides the one the UID describes.
+enum
+{
+	DRAW_DST_ALPHA = 1,
+	DRAW_FORCED_EARLY_Z = 2,
+};
+
+struct Key
+{
+	PixelShaderUid ps;
+	VertexShaderUid vs;
+	u32 components;
+	u32 draw_flags;
+
+	bool operator < (const Key& other) const
+	{
+		if (ps != other.ps)
+			return ps < other.ps;
+		if (vs != other.vs)
+			return vs < other.vs;
+		if (components != other.components)
+			return components < other.components;
+		return draw_flags < other.draw_flags;
+	}
+};
+
+class ListFile
+{
+public:
+	ListFile(std::vector<Entry>& entries) : m_entries(entries) {}
+
+	void DoState(PointerWrap& p)
+	{
+		u32 entry_size = (u32)sizeof(Entry);
+		u32 count = (u32)m_entries.size();
+		p.Do(entry_size);
+		p.Do(count);
+
+		// The registers are stored as they are in memory.
+		if (entry_size != sizeof(Entry))
+			count = 0;
+
+		m_entries.resize(count);
+		for (Entry& entry : m_entries)
+		{
+			p.Do(entry.components);
+			p.Do(entry.bp);
+			p.Do(entry.xf);
+		}
+	}
+
+private:
+	std::vector<Entry>& m_entries;
+};
+
+static bool s_recording;
+static std::string s_filename;
+static std::vector<Entry> s_entries;
+static size_t s_num_loaded;
+static std::set<Key> s_keys;
+
+static u32 GetDrawFlags()
+{
+	u32 flags = 0;
+	if (bpmem.dstalpha.enable && bpmem.blendmode.alphaupdate && bpmem.zcontrol.pixel_format == PIXELFMT_RGBA6_Z24)
+		flags |= DRAW_DST_ALPHA;
+	if (bpmem.UseEarlyDepthTest() && bpmem.zmode.updateenable && bpmem.alpha_test.TestResult() == AlphaTest::UNDETERMINED)
+		flags |= DRAW_FORCED_EARLY_Z;
+	return flags;
+}
+
+static void GetPixelShaderUid(PixelShaderUid& uid, API_TYPE api, DSTALPHA_MODE mode, u32 components)
+{
+	if (api == API_OPENGL)
+		GetPixelShaderUidGL(uid, mode, components);
+	else if (api == API_D3D11)
+		GetPixelShaderUidD3D11(uid, mode, components);
+	else
+		GetPixelShaderUidD3D9(uid, mode, components);
+}
+
+static void GetVertexShaderUid(VertexShaderUid& uid, API_TYPE api, u32 components)
+{
+	if (api == API_OPENGL)
+		GetVertexShaderUidGL(uid, components);
+	else if (api == API_D3D11)
+		GetVertexShaderUidD3D11(uid, components);
+	else
+		GetVertexShaderUidD3D9(uid, components);
+}
+
+static Key MakeKey(u32 components)
+{
+	const API_TYPE api = g_ActiveConfig.backend_info.APIType;
+	Key key;
+	GetPixelShaderUid(key.ps, api, DSTALPHA_NONE, components);
+	GetVertexShaderUid(key.vs, api, components);
+	key.components = components;
+	key.draw_flags = GetDrawFlags();
+	return key;
+}
+
+std::string GetFilename(const std::string& unique_id)
+{
+	return File::GetUserPath(D_SHADERCACHE_IDX) + unique_id + "-shaders.list";
+}
+
+bool Load(const std::string& filename, std::vector<Entry>& entries)
+{
+	ListFile file(entries);
+	if (!CChunkFileReader::Load<ListFile>(filename, LIST_REVISION, file))
+	{
+		entries.clear();
+		return false;
+	}
+	return true;
+}
+
+bool Save(const std::string& filename, std::vector<Entry>& entries)
+{
+	if (!File::IsDirectory(File::GetUserPath(D_SHADERCACHE_IDX)))
+		File::CreateDir(File::GetUserPath(D_SHADERCACHE_IDX));
+
+	ListFile file(entries);
+	return CChunkFileReader::Save<ListFile>(filename, LIST_REVISION, file);
+}
+
+void ForEach(const std::vector<Entry>& entries, const std::function<void(const Entry&)>& func)
+{
+	const BPMemory saved_bp = bpmem;
+	const XFRegisters saved_xf = xfregs;
+
+	for (const Entry& entry : entries)
+	{
+		bpmem = entry.bp;
+		xfregs = entry.xf;
+		InvalidatePixelShaderUids();
+		InvalidateVertexShaderUids();
+		func(entry);
+	}
+
+	bpmem = saved_bp;
+	xfregs = saved_xf;
+	InvalidatePixelShaderUids();
+	InvalidateVertexShaderUids();
+}
+
+GenerateStats GenerateAll(const std::vector<Entry>& entries, API_TYPE api, const std::string& dump_dir)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	GenerateStats stats = {};
+
+	std::string dir = dump_dir;
+	if (!dir.empty())
+	{
+		if (dir.back() != '/' && dir.back() != '\\')
+			dir += '/';
+		File::CreateFullPath(dir);
+	}
+
+	const bool dual_source = api == API_D3D11 || g_ActiveConfig.backend_info.bSupportsDualSourceBlend;
+	std::set<PixelShaderUid> pixel_uids;
+	std::set<VertexShaderUid> vertex_uids;
+
+	ForEach(entries, [&](const Entry& entry) {
+		const u32 flags = GetDrawFlags();
+
+		DSTALPHA_MODE modes[3];
+		int num_modes = 0;
+		modes[num_modes++] = (flags & DRAW_DST_ALPHA) && dual_source ? DSTALPHA_DUAL_SOURCE_BLEND : DSTALPHA_NONE;
+		if ((flags & DRAW_DST_ALPHA) && !dual_source)
+			modes[num_modes++] = DSTALPHA_ALPHA_PASS;
+		if ((flags & DRAW_FORCED_EARLY_Z) && (api & API_D3D9))
+			modes[num_modes++] = DSTALPHA_NULL;
+
+		for (int i = 0; i < num_modes; i++)
+		{
+			PixelShaderUid uid;
+			GetPixelShaderUid(uid, api, modes[i], entry.components);
+			if (!pixel_uids.insert(uid).second)
+				continue;
+
+			ShaderCode code;
+			if (api == API_OPENGL)
+				GeneratePixelShaderCodeGL(code, modes[i], entry.components);
+			else if (api == API_D3D11)
+				GeneratePixelShaderCodeD3D11(code, modes[i], entry.components);
+			else if (api == API_D3D9_SM20)
+				GeneratePixelShaderCodeD3D9SM2(code, modes[i], entry.components);
+			else
+				GeneratePixelShaderCodeD3D9(code, modes[i], entry.components);
+
+			stats.bytes += strlen(code.GetBuffer());
+			if (!dir.empty())
+				File::WriteStringToFile(code.GetBuffer(), StringFromFormat("%sps_%04u.txt", dir.c_str(), stats.pixel_shaders));
+			stats.pixel_shaders++;
+		}
+
+		VertexShaderUid uid;
+		GetVertexShaderUid(uid, api, entry.components);
+		if (!vertex_uids.insert(uid).second)
+			return;
+
+		ShaderCode code;
+		if (api == API_OPENGL)
+			GenerateVertexShaderCodeGL(code, entry.components);
+		else if (api == API_D3D11)
+			GenerateVertexShaderCodeD3D11(code, entry.components);
+		else
+			GenerateVertexShaderCodeD3D9(code, entry.components);
+
+		stats.bytes += strlen(code.GetBuffer());
+		if (!dir.empty())
+			File::WriteStringToFile(code.GetBuffer(), StringFromFormat("%svs_%04u.txt", dir.c_str(), stats.vertex_shaders));
+		stats.vertex_shaders++;
+	});
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return stats;
+}
+
+void Init()
+{
+	const std::string& unique_id = SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID;
+	if (unique_id.empty() || (!g_ActiveConfig.bRecordShaders && !g_ActiveConfig.bPrecompileShaders))
+		return;
+
+	const std::string filename = GetFilename(unique_id);
+	std::vector<Entry> entries;
+	if (File::Exists(filename))
+		Load(filename, entries);
+
+	if (g_ActiveConfig.bPrecompileShaders && g_vertex_manager && !entries.empty())
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		ForEach(entries, [](const Entry& entry) {
+			g_vertex_manager->PrepareShaders(entry.components);
+		});
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		NOTICE_LOG(VIDEO, "Prepared the shaders of %u recorded draws in %.0f ms", (u32)entries.size(), seconds * 1000);
+	}
+
+	if (g_ActiveConfig.bRecordShaders)
+	{
+		s_keys.clear();
+		ForEach(entries, [](const Entry& entry) {
+			s_keys.insert(MakeKey(entry.components));
+		});
+		s_entries.swap(entries);
+		s_num_loaded = s_entries.size();
+		s_filename = filename;
+		s_recording = true;
+	}
+}
+
+void Shutdown()
+{
+	if (!s_recording)
+		return;
+
+	s_recording = false;
+	if (s_entries.size() != s_num_loaded)
+	{
+		if (Save(s_filename, s_entries))
+			INFO_LOG(VIDEO, "Recorded %u new shader states to %s", (u32)(s_entries.size() - s_num_loaded), s_filename.c_str());
+		else
+			ERROR_LOG(VIDEO, "Failed to write the shader list %s", s_filename.c_str());
+	}
+
+	std::vector<Entry>().swap(s_entries);
+	s_keys.clear();
+}
+
+bool IsRecording()
+{
+	return s_recording;
+}
+
+void RecordDraw(u32 components)
+{
+	if (!s_keys.insert(MakeKey(components)).second)
+		return;
+
+	s_entries.push_back(Entry());
+	Entry& entry = s_entries.back();
+	entry.components = components;
+	entry.bp = bpmem;
+	entry.xf = xfregs;
+}
+
+}  // namespace
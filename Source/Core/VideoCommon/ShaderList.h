@@ -0,0 +1,72 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Records the register state behind every distinct pixel/vertex shader pair a
+// game draws with, so the shaders can be generated again without running the
+// game: to compile them before the game boots, or to measure and diff the
+// shader generators offline.
+//
+// The list keeps the BP and XF registers rather than the UIDs themselves, so
+// the same list works for every backend and survives changes to the UID
+// layout. Pairs are told apart by the UIDs of the backend that recorded them.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/VideoCommon.h"
+#include "VideoCommon/XFMemory.h"
+
+class PointerWrap;
+
+namespace ShaderList
+{
+
+struct Entry
+{
+	u32 components;
+	BPMemory bp;
+	XFRegisters xf;
+};
+
+struct GenerateStats
+{
+	u32 pixel_shaders;
+	u32 vertex_shaders;
+	u64 bytes;
+	double seconds;
+};
+
+// <shader cache dir>/<game id>-shaders.list
+std::string GetFilename(const std::string& unique_id);
+
+bool Load(const std::string& filename, std::vector<Entry>& entries);
+bool Save(const std::string& filename, std::vector<Entry>& entries);
+
+// Loads bpmem and xfregs from each entry in turn and calls func with it, then
+// restores both. The UID caches are invalidated around every entry.
+void ForEach(const std::vector<Entry>& entries, const std::function<void(const Entry&)>& func);
+
+// Generates the code of every distinct shader the entries need on the given
+// API, writing each one to dump_dir as ps_NNNN.txt/vs_NNNN.txt unless it's
+// empty. Runs on the calling thread, which must not be the video thread of a
+// running game.
+GenerateStats GenerateAll(const std::vector<Entry>& entries, API_TYPE api, const std::string& dump_dir = "");
+
+// Called from Video_Prepare with the backend set up: starts recording and
+// compiles the game's list ahead of the first frame, as configured.
+void Init();
+// Saves the list if recording.
+void Shutdown();
+
+bool IsRecording();
+// Called by VertexManager::Flush before the backend draws.
+void RecordDraw(u32 components);
+
+}  // namespace
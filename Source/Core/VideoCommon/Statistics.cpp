@@ -35,6 +35,8 @@ char *Statistics::ToString(char *ptr)
 	ptr+=sprintf(ptr,"dlists called:    %i\n",stats.numDListsCalled);
 	ptr+=sprintf(ptr,"dlists called(f): %i\n",stats.thisFrame.numDListsCalled);
 	ptr+=sprintf(ptr,"dlists alive:     %i\n",stats.numDListsAlive);
+	ptr+=sprintf(ptr,"Shader UIDs reused: %i\n",stats.thisFrame.numShaderUidsReused);
+	ptr+=sprintf(ptr,"Shader UIDs generated: %i\n",stats.thisFrame.numShaderUidsGenerated);
 	ptr+=sprintf(ptr,"Primitive joins: %i\n",stats.thisFrame.numPrimitiveJoins);
 	ptr+=sprintf(ptr,"Draw calls:       %i\n",stats.thisFrame.numDrawCalls);
 	ptr+=sprintf(ptr,"Indexed draw calls: %i\n",stats.thisFrame.numIndexedDrawCalls);
@@ -53,6 +53,8 @@ struct Statistics
 		int numPrims;
 		int numDLPrims;
 		int numShaderChanges;
+		int numShaderUidsReused;
+		int numShaderUidsGenerated;
 
 		int numPrimitiveJoins;
 		int numDrawCalls;
@@ -2,7 +2,10 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <set>
+
 #include "Common/MemoryUtil.h"
+#include "Common/Timeline.h"
 
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/Statistics.h"
@@ -36,6 +39,11 @@ TextureCache::BackupConfig TextureCache::backup_config;
 
 bool invalidate_texture_cache_requested;
 
+// Hash, format and level of every texture dumped since the cache was
+// created, so a texture isn't read back again while its file is still
+// being written or after.
+static std::set<u64> s_dumped_textures;
+
 TextureCache::TCacheEntryBase::~TCacheEntryBase()
 {
 }
@@ -54,6 +62,7 @@ TextureCache::TextureCache()
 	SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
 
 	invalidate_texture_cache_requested = false;
+	s_dumped_textures.clear();
 	for (u32 i = 0; i < 8; i++)
 	{
 		stagemap[i] = nullptr;
@@ -285,6 +294,11 @@ PC_TexFormat TextureCache::LoadCustomTexture(u64 tex_hash, s32 texformat, u32 le
 
 void TextureCache::DumpTexture(TCacheEntryBase* entry, u32 level)
 {
+	// The same bits as the file name
+	const u64 key = (entry->hash & 0xFFFFFFFF) | ((u64)(entry->format & 0xFFFF) << 32) | ((u64)level << 48);
+	if (!s_dumped_textures.insert(key).second)
+		return;
+
 	char szTemp[MAX_PATH];
 	std::string szDir = File::GetUserPath(D_DUMPTEXTURES_IDX) +
 		SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID;
@@ -335,6 +349,8 @@ TextureCache::TCacheEntryBase* TextureCache::Load(u32 const stage,
 	if (0 == address)
 		return NULL;
 
+	TIMELINE_ZONE("TextureCache::Load");
+
 	// TexelSizeInNibbles(format) * width * height / 16;
 	const u32 bsw = TexDecoder_GetBlockWidthInTexels(texformat) - 1;
 	const u32 bsh = TexDecoder_GetBlockHeightInTexels(texformat) - 1;
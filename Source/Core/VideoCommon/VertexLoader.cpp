@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 // Modified for Ishiiruka By Tino
 
+#include "Common/Timeline.h"
+
 #include "Core/Host.h"
 
 #include "VideoCommon/BPMemory.h"
@@ -424,6 +426,7 @@ s32 VertexLoader::SetupRunVertices(const VAT &vat, int primitive, int const coun
 
 void VertexLoader::RunVertices(const VAT &vtx_attr, int primitive, int const count)
 {
+	TIMELINE_ZONE("VertexLoader::RunVertices");
 	if (bpmem.genMode.cullmode == 3 && primitive < 5)
 	{
 		// if cull mode is none, ignore triangles and quads
@@ -459,6 +462,7 @@ void LOADERDECL VertexLoader::ConvertVertices()
 
 void VertexLoader::RunCompiledVertices(const VAT &vtx_attr, int primitive, int const count, const u8* Data)
 {
+	TIMELINE_ZONE("VertexLoader::RunVertices");
 	if (bpmem.genMode.cullmode == 3 && primitive < 5)
 	{
 		// if cull mode is none, ignore triangles and quads
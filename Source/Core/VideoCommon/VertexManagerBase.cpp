@@ -1,5 +1,6 @@
 
 #include "Common/Common.h"
+#include "Common/Timeline.h"
 
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/OpcodeDecoding.h"
@@ -10,12 +11,14 @@
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/BPStructs.h"
+#include "VideoCommon/ShaderList.h"
 
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/MainBase.h"
 #include "VideoCommon/VideoConfig.h"
 
 VertexManager *g_vertex_manager;
+extern NativeVertexFormat *g_nativeVertexFmt;
 
 u8 *VertexManager::s_pCurBufferPointer;
 u8 *VertexManager::s_pBaseBufferPointer;
@@ -146,11 +149,16 @@ void VertexManager::Flush()
 	if (g_vertex_manager->IsFlushed())
 		return;
 
+	TIMELINE_ZONE("VertexManager::Flush");
+
 	// loading a state will invalidate BP, so check for it
 	g_video_backend->CheckInvalidState();
 
 	VideoFifo_CheckEFBAccess();
 
+	if (ShaderList::IsRecording())
+		ShaderList::RecordDraw(g_nativeVertexFmt->m_components);
+
 	g_vertex_manager->vFlush();
 
 	g_vertex_manager->ResetBuffer();
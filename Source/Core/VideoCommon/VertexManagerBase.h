@@ -42,6 +42,10 @@ public:
 	static void DoState(PointerWrap& p);
 	virtual void CreateDeviceObjects(){};
 	virtual void DestroyDeviceObjects(){};
+
+	// Compiles the shaders vFlush would bind for the current registers
+	// without drawing anything.
+	virtual void PrepareShaders(u32 components) {}
 	
 protected:
 	u16* GetTriangleIndexBuffer() { return &TIBuffer[0]; }
@@ -14,6 +14,7 @@
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/LightingShaderGen.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexShaderGen.h"
 #include "VideoCommon/VideoConfig.h"
 
@@ -591,9 +592,31 @@ inline void GenerateVertexShader(T& out, u32 components)
 	}
 }
 
+static UidCache<VertexShaderUid> s_uid_cache;
+
+void InvalidateVertexShaderUids()
+{
+	s_uid_cache.Invalidate();
+}
+
+template<API_TYPE api_type>
+static inline void GetVertexShaderUid(VertexShaderUid& object, u32 components)
+{
+	const u64 key = ((u64)api_type << 32) | components;
+	if (s_uid_cache.Find(key, object))
+	{
+		INCSTAT(stats.thisFrame.numShaderUidsReused);
+		return;
+	}
+
+	GenerateVertexShader<VertexShaderUid, false, api_type>(object, components);
+	s_uid_cache.Insert(key, object);
+	INCSTAT(stats.thisFrame.numShaderUidsGenerated);
+}
+
 void GetVertexShaderUidD3D9(VertexShaderUid& object, u32 components)
 {
-	GenerateVertexShader<VertexShaderUid, false, API_D3D9>(object, components);
+	GetVertexShaderUid<API_D3D9>(object, components);
 }
 
 void GenerateVertexShaderCodeD3D9(ShaderCode& object, u32 components)
@@ -608,7 +631,7 @@ void GenerateVSOutputStructForGSD3D9(ShaderCode& object)
 
 void GetVertexShaderUidD3D11(VertexShaderUid& object, u32 components)
 {
-	GenerateVertexShader<VertexShaderUid, false, API_D3D11>(object, components);
+	GetVertexShaderUid<API_D3D11>(object, components);
 }
 
 void GenerateVertexShaderCodeD3D11(ShaderCode& object, u32 components)
@@ -623,7 +646,7 @@ void GenerateVSOutputStructForGSD3D11(ShaderCode& object)
 
 void GetVertexShaderUidGL(VertexShaderUid& object, u32 components)
 {
-	GenerateVertexShader<VertexShaderUid, false, API_OPENGL>(object, components);
+	GetVertexShaderUid<API_OPENGL>(object, components);
 }
 
 void GenerateVertexShaderCodeGL(ShaderCode& object, u32 components)
@@ -101,6 +101,10 @@ struct vertex_shader_uid_data
 
 typedef ShaderUid<vertex_shader_uid_data> VertexShaderUid;
 
+// The GetVertexShaderUid functions reuse the UIDs generated since this was last called.
+// Call it after writing an XF register (or config option) that GenerateVertexShader reads.
+void InvalidateVertexShaderUids();
+
 void GetVertexShaderUidD3D9(VertexShaderUid& object, u32 components);
 
 void GenerateVertexShaderCodeD3D9(ShaderCode& object, u32 components);
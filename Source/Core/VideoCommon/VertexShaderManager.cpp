@@ -11,6 +11,7 @@
 
 #include "VideoCommon/Statistics.h"
 
+#include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/VertexShaderGen.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/BPMemory.h"
@@ -155,6 +156,8 @@ void VertexShaderManager::Init()
 
 	memset(&xfregs, 0, sizeof(xfregs));
 	memset(xfmem, 0, sizeof(xfmem));
+	InvalidatePixelShaderUids();
+	InvalidateVertexShaderUids();
 	ResetView();
 
 	// TODO: should these go inside ResetView()?
@@ -13,6 +13,8 @@
 #include "Core/Core.h"
 #include "Core/Movie.h"
 #include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/PixelShaderGen.h"
+#include "VideoCommon/VertexShaderGen.h"
 
 VideoConfig g_Config;
 VideoConfig g_ActiveConfig;
@@ -22,6 +24,10 @@ void UpdateActiveConfig()
 	if (Movie::IsPlayingInput() && Movie::IsConfigSaved())
 		Movie::SetGraphicsConfig();
 	g_ActiveConfig = g_Config;
+
+	// The shader generators read some of the options
+	InvalidatePixelShaderUids();
+	InvalidateVertexShaderUids();
 }
 
 VideoConfig::VideoConfig()
@@ -57,6 +63,7 @@ void VideoConfig::Load(const char *ini_file)
 	settings->Get("SafeTextureCacheColorSamples", &iSafeTextureCache_ColorSamples, 128);
 	settings->Get("ShowFPS", &bShowFPS, false); // Settings
 	settings->Get("LogFPSToFile", &bLogFPSToFile, false);
+	settings->Get("TimelineFrames", &iTimelineFrames, 0);
 	settings->Get("ShowInputDisplay", &bShowInputDisplay, false);
 	settings->Get("OverlayStats", &bOverlayStats, false);
 	settings->Get("OverlayProjStats", &bOverlayProjStats, false);
@@ -89,6 +96,8 @@ void VideoConfig::Load(const char *ini_file)
 	settings->Get("OMPDecoder", &bOMPDecoder, false);
 
 	settings->Get("EnableShaderDebugging", &bEnableShaderDebugging, false);
+	settings->Get("RecordShaders", &bRecordShaders, false);
+	settings->Get("PrecompileShaders", &bPrecompileShaders, false);
 	settings->Get("BorderlessFullscreen", &bEnableShaderDebugging, false);
 	IniFile::Section* Enhancements = iniFile.GetOrCreateSection("Enhancements");
 	Enhancements->Get("ForceFiltering", &bForceFiltering, 0);
@@ -244,6 +253,7 @@ void VideoConfig::Save(const char *ini_file)
 	settings->Set("SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
 	settings->Set("ShowFPS", bShowFPS);
 	settings->Set("LogFPSToFile", bLogFPSToFile);
+	settings->Set("TimelineFrames", iTimelineFrames);
 	settings->Set("ShowInputDisplay", bShowInputDisplay);
 	settings->Set("OverlayStats", bOverlayStats);
 	settings->Set("OverlayProjStats", bOverlayProjStats);
@@ -274,6 +284,8 @@ void VideoConfig::Save(const char *ini_file)
 	settings->Set("OMPDecoder", bOMPDecoder);
 
 	settings->Set("EnableShaderDebugging", bEnableShaderDebugging);
+	settings->Set("RecordShaders", bRecordShaders);
+	settings->Set("PrecompileShaders", bPrecompileShaders);
 	settings->Set("BorderlessFullscreen", bBorderlessFullscreen);
 
 
@@ -96,6 +96,8 @@ struct VideoConfig
 	bool bTexFmtOverlayCenter;
 	bool bShowEFBCopyRegions;
 	bool bLogFPSToFile;
+	// Save the timeline of every this many frames to Logs/timeline_*.json, 0 is off
+	int iTimelineFrames;
 
 	// Render
 	bool bWireFrame;
@@ -143,6 +145,9 @@ struct VideoConfig
 
 	// Debugging
 	bool bEnableShaderDebugging;
+	// Shader lists, see ShaderList.h
+	bool bRecordShaders;
+	bool bPrecompileShaders;
 	//Exclusive Full Screen
 	bool bBorderlessFullscreen;
 	// Static config per API
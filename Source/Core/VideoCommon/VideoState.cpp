@@ -12,7 +12,9 @@
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/PixelEngine.h"
+#include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/VertexShaderGen.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/VertexManagerBase.h"
 
@@ -60,6 +62,10 @@ static void DoState(PointerWrap &p)
 	VertexManager::DoState(p);
 	p.DoMarker("VertexManager");
 
+	// The registers were replaced without going through BPWritten/LoadXFReg
+	InvalidatePixelShaderUids();
+	InvalidateVertexShaderUids();
+
 	// TODO: search for more data that should be saved and add it here
 }
 
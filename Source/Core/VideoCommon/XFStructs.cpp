@@ -8,7 +8,9 @@
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
+#include "VideoCommon/PixelShaderGen.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/VertexShaderGen.h"
 #include "Core/HW/Memmap.h"
 
 void XFMemWritten(u32 transferSize, u32 baseAddress)
@@ -194,6 +196,15 @@ void XFRegWritten(int transferSize, u32 baseAddress, u32 *pData)
 	}
 }
 
+// The registers the shader generators read: the lighting channels, dual texture transform and texgens.
+static bool IsShaderUidRegister(u32 address)
+{
+	return address == XFMEM_SETNUMCHAN ||
+	       (address >= XFMEM_SETCHAN0_COLOR && address <= XFMEM_DUALTEX) ||
+	       (address >= XFMEM_SETNUMTEXGENS && address < XFMEM_SETTEXMTXINFO + 8) ||
+	       (address >= XFMEM_SETPOSMTXINFO && address < XFMEM_SETPOSMTXINFO + 8);
+}
+
 void LoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 {
 	// do not allow writes past registers
@@ -237,7 +248,23 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 	if (transferSize > 0)
 	{	
 		XFRegWritten(transferSize, baseAddress, pData);
+
+		// XFRegWritten flushes with the old values, so only drop the UIDs
+		// once the new ones are in place.
+		bool uids_changed = false;
+		for (u32 i = 0; i < transferSize && !uids_changed; ++i)
+		{
+			u32 address = baseAddress + i;
+			uids_changed = IsShaderUidRegister(address) && ((u32*)&xfregs)[address - 0x1000] != pData[i];
+		}
+
 		memcpy_gc((u32*)(&xfregs) + (baseAddress - 0x1000), pData, transferSize * 4);        
+
+		if (uids_changed)
+		{
+			InvalidatePixelShaderUids();
+			InvalidateVertexShaderUids();
+		}
 	}
 }
 
@@ -15,13 +15,18 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
+#include "FileUtil.h"
+#include "LinearDiskCache.h"
 #include "StringUtil.h"
 #include "MathUtil.h"
 #include "PowerPC/PowerPC.h"
 #include "HW/SI_DeviceGCController.h"
+#include "AudioCommon/DPL2Decoder.h"
 
 void AudioJitTests();
 
@@ -129,6 +134,214 @@ void StringTests()
 	EXPECT_EQ(".jpg", ext);
 }
 
+static std::vector<float> DecodeDPL2(const std::vector<float>& samples, int frames_per_call)
+{
+	const int frames = (int)samples.size() / 2;
+	std::vector<float> in(samples), out(frames * 6);
+	DPL2Reset();
+	for (int i = 0; i < frames; i += frames_per_call)
+		DPL2Decode(&in[i * 2], std::min(frames_per_call, frames - i), &out[i * 6]);
+	DPL2Reset();
+	return out;
+}
+
+void DPL2Tests()
+{
+	const int frames = 48000;
+	std::vector<float> in(frames * 2);
+	for (int i = 0; i < frames; i++)
+	{
+		in[i * 2] = (float)(0.5 * sin(i * 0.0576) + 0.3 * sin(i * 0.0065));
+		in[i * 2 + 1] = (float)(0.5 * sin(i * 0.0079));
+	}
+
+	// The LFE filter runs over blocks, which mustn't depend on how the
+	// input is split into calls.
+	const std::vector<float> out = DecodeDPL2(in, 2048);
+	const bool independent_of_calls = DecodeDPL2(in, 1000) == out;
+	EXPECT_TRUE(independent_of_calls);
+
+	// The LFE channel is the mean of the front channels, low passed by a
+	// direct convolution with the decoder's taps.
+	int num_taps;
+	const float* taps = DPL2GetLFETaps(&num_taps);
+	float max_error = 0;
+	for (int i = 0; i < frames; i++)
+	{
+		double lfe = 0;
+		for (int k = 0; k < num_taps; k++)
+		{
+			const int frame = i - num_taps + 1 + k;
+			if (frame >= 0)
+				lfe += taps[k] * (out[frame * 6] + out[frame * 6 + 1]) / 2;
+		}
+		max_error = std::max(max_error, fabsf((float)lfe - out[i * 6 + 3]));
+	}
+	const bool lfe_matches_convolution = max_error < 1e-5f;
+	EXPECT_TRUE(lfe_matches_convolution);
+
+	// A signal in both channels goes to the front and center, one in
+	// opposite phase to the rear.
+	std::vector<float> mono(frames * 2), opposite(frames * 2);
+	for (int i = 0; i < frames; i++)
+	{
+		mono[i * 2] = mono[i * 2 + 1] = (float)(0.5 * sin(i * 0.05));
+		opposite[i * 2] = (float)(0.5 * sin(i * 0.05));
+		opposite[i * 2 + 1] = -opposite[i * 2];
+	}
+	const std::vector<float> mono_out = DecodeDPL2(mono, 2048);
+	const std::vector<float> opposite_out = DecodeDPL2(opposite, 2048);
+	float front_difference = 0, mono_rear = 0, mono_center = 0, opposite_center = 0, opposite_rear = 0;
+	for (int i = 0; i < frames; i++)
+	{
+		front_difference = std::max(front_difference, fabsf(mono_out[i * 6] - mono_out[i * 6 + 1]));
+		mono_center = std::max(mono_center, fabsf(mono_out[i * 6 + 2]));
+		mono_rear = std::max(mono_rear, std::max(fabsf(mono_out[i * 6 + 4]), fabsf(mono_out[i * 6 + 5])));
+		opposite_center = std::max(opposite_center, fabsf(opposite_out[i * 6 + 2]));
+		opposite_rear = std::max(opposite_rear, fabsf(opposite_out[i * 6 + 4]));
+	}
+	const bool mono_in_front = front_difference < 1e-6f && mono_rear < 1e-6f && mono_center > 0.1f;
+	const bool opposite_in_rear = opposite_center < 1e-6f && opposite_rear > 0.1f;
+	EXPECT_TRUE(mono_in_front);
+	EXPECT_TRUE(opposite_in_rear);
+}
+
+struct DiskCacheKey
+{
+	u32 a, b;
+};
+
+class DiskCacheCounter : public LinearDiskCacheReader<DiskCacheKey, u8>
+{
+public:
+	DiskCacheCounter() : count(0) {}
+	void Read(const DiskCacheKey& key, const u8* value, u32 value_size) override { count++; }
+	u32 count;
+};
+
+static bool DiskCacheValueMatches(LinearDiskCache<DiskCacheKey, u8>& cache, u32 i)
+{
+	DiskCacheKey key = { i, i * 3 };
+	u32 size = 0;
+	const u8* value = cache.Lookup(key, &size);
+	if (!value || size != i % 37 + 1)
+		return false;
+	for (u32 j = 0; j < size; j++)
+	{
+		if (value[j] != (u8)(i + j))
+			return false;
+	}
+	return true;
+}
+
+void LinearDiskCacheTests()
+{
+	const std::string filename = "LinearDiskCacheTests.cache";
+	File::Delete(filename);
+
+	// Write, then reopen: 100 entries are compacted into the index on Close,
+	// 10 more stay in the journal.
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(0, cache.Open(filename));
+		for (u32 i = 0; i < 100; i++)
+		{
+			DiskCacheKey key = { i, i * 3 };
+			std::vector<u8> value(i % 37 + 1);
+			for (u32 j = 0; j < value.size(); j++)
+				value[j] = (u8)(i + j);
+			cache.Append(key, value.data(), (u32)value.size());
+		}
+		EXPECT_TRUE(DiskCacheValueMatches(cache, 42));
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(100, cache.Open(filename));
+		bool all_match = true;
+		for (u32 i = 0; i < 100; i++)
+			all_match &= DiskCacheValueMatches(cache, i);
+		EXPECT_TRUE(all_match);
+
+		DiskCacheKey missing = { 1, 1 };
+		u32 size;
+		EXPECT_FALSE(cache.Lookup(missing, &size));
+
+		for (u32 i = 100; i < 110; i++)
+		{
+			DiskCacheKey key = { i, i * 3 };
+			std::vector<u8> value(i % 37 + 1);
+			for (u32 j = 0; j < value.size(); j++)
+				value[j] = (u8)(i + j);
+			cache.Append(key, value.data(), (u32)value.size());
+		}
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(110, cache.Open(filename));
+		DiskCacheCounter counter;
+		EXPECT_EQ(110, cache.ForEach(counter));
+		EXPECT_EQ(110, counter.count);
+		EXPECT_TRUE(DiskCacheValueMatches(cache, 105));
+	}
+
+	// A truncated tail loses only the last journal entry.
+	{
+		File::IOFile file(filename, "r+b");
+		file.Resize(file.GetSize() - 8);
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(109, cache.Open(filename));
+		EXPECT_TRUE(DiskCacheValueMatches(cache, 108));
+		EXPECT_FALSE(DiskCacheValueMatches(cache, 109));
+	}
+
+	// The truncation made Open compact the file, so all 109 entries are
+	// indexed. Corrupt the value of the first key, {0, 0}, which follows the
+	// 64 byte header and the 24 byte index entries.
+	{
+		File::IOFile file(filename, "r+b");
+		file.Seek(64 + 109 * 24, SEEK_SET);
+		const u8 garbage = 0xFF;
+		file.WriteBytes(&garbage, 1);
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		cache.Open(filename);
+		EXPECT_FALSE(DiskCacheValueMatches(cache, 0));
+		EXPECT_TRUE(DiskCacheValueMatches(cache, 1));
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(108, cache.Open(filename));
+	}
+
+	// Files from another version or with other key types start over.
+	{
+		LinearDiskCache<u32, u8> cache;
+		EXPECT_EQ(0, cache.Open(filename));
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		cache.Open(filename);
+		DiskCacheKey key = { 0, 0 };
+		const u8 value = 1;
+		cache.Append(key, &value, 1);
+	}
+	{
+		// The version string follows the id and the key and value sizes
+		File::IOFile file(filename, "r+b");
+		file.Seek(8, SEEK_SET);
+		const u8 other_version = '~';
+		file.WriteBytes(&other_version, 1);
+	}
+	{
+		LinearDiskCache<DiskCacheKey, u8> cache;
+		EXPECT_EQ(0, cache.Open(filename));
+	}
+
+	File::Delete(filename);
+}
 
 int main(int argc, char* argv[])
 {
@@ -137,6 +350,8 @@ int main(int argc, char* argv[])
 	CoreTests();
 	MathTests();
 	StringTests();
+	DPL2Tests();
+	LinearDiskCacheTests();
 	if (fail_count == 0)
 	{
 		printf("All tests passed.\n");